@@ -12,10 +12,11 @@ TOOLSDIR = $(THISDIR)../tools/
 CPPFLAGS += -I$(TOOLSDIR)nugget/common/macros/
 CPPFLAGS += -I$(GAMEINCLUDEDIR)
 CPPFLAGS += -I$(MODDIR)
+PCH_EXCLUDED_FLAGS += -I$(MODDIR)
 
 ifeq ($(USE_MININOOB),true)
   CPPFLAGS += -I$(TOOLSDIR)minin00b/include/
-  LDFLAGS += -L$(TOOLSDIR)minin00b/lib/
+  LDFLAGS += -L$(MININOOB_BUILDDIR)lib/
   LDFLAGS += -Wl,--start-group
   LDFLAGS += -l:libc.a
   LDFLAGS += -l:psxcd.a
@@ -26,9 +27,16 @@ ifeq ($(USE_MININOOB),true)
   LDFLAGS += -l:psxsio.a
   LDFLAGS += -l:psxspu.a
   LDFLAGS += -l:psxapi.a
+  LDFLAGS += -l:psxprof.a
   LDFLAGS += -Wl,--end-group
 endif
 
+# Function call tracing, see ProfTraceInit() in psxprof.h. Only the mod's own
+# sources are instrumented, as the libraries are built separately.
+ifeq ($(USE_PROFILE),true)
+  CPPFLAGS += -finstrument-functions -DPROFILE
+endif
+
 ifeq ($(USE_PSYQ),true)
   CPPFLAGS += -I$(TOOLSDIR)gcc-psyq-converted/include/
   LDFLAGS += -L$(TOOLSDIR)gcc-psyq-converted/lib/
@@ -58,4 +66,21 @@ ifeq ($(USE_PSYQ),true)
   LDFLAGS += -Wl,--end-group
 endif
 
-include $(TOOLSDIR)nugget/common.mk
\ No newline at end of file
+include $(TOOLSDIR)nugget/common.mk
+
+# Each mod builds its own copy of the minin00b libraries in MININOOB_BUILDDIR,
+# from the same sources and headers it compiles against. make is run in
+# minin00b on every build, and only recompiles what changed since the last one.
+# The elf is relinked only when one of the archives changed.
+ifeq ($(USE_MININOOB),true)
+MININOOB_LIBS = $(addprefix $(MININOOB_BUILDDIR)lib/, libc.a psxcd.a psxetc.a psxgpu.a psxgte.a psxpress.a psxsio.a psxspu.a psxapi.a psxprof.a)
+
+$(MININOOB_LIBS): minin00b ;
+
+minin00b:
+	$(MAKE) -C $(TOOLSDIR)minin00b BUILDDIR=$(MININOOB_BUILDDIR) PYTHON=$(PYTHON)
+
+$(BINDIR)$(TARGET).elf: $(MININOOB_LIBS)
+
+.PHONY: minin00b
+endif
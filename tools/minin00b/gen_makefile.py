@@ -7,17 +7,19 @@ buffer = ""
 
 for file in files:
     lib, filename = file.split("/")
-    obj_file = lib + "_" + filename[:-2] + ".o"
+    obj_file = "$(OBJDIR)" + lib + "_" + filename[:-2] + ".o"
     if lib in libs:
         libs[lib].append(obj_file)
     else:
         libs[lib] = [obj_file]
     buffer += obj_file + ": " + file + "\n"
-    buffer += "\t" + "$(CC) $(CPPFLAGS) -c -o $@ $^\n\n"
+    depflags = " $(DEPFLAGS)" if file.endswith(".c") else ""
+    buffer += "\t" + "$(CC) $(CPPFLAGS)" + depflags + " -c -o $@ $<\n\n"
 
 for key in libs:
     objs = libs[key]
-    buffer += key + ".a: " + " ".join(objs) + "\n"
-    buffer += "\t" + "$(AR) rcs lib/$@ $^\n\n"
+    buffer += "$(LIBDIR)" + key + ".a: " + " ".join(objs) + "\n"
+    buffer += "\t" + "rm -f $@\n"
+    buffer += "\t" + "$(AR) rcs $@ $^\n\n"
 
 print(buffer)
\ No newline at end of file
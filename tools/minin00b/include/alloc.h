@@ -0,0 +1,406 @@
+/*
+ * PSn00bSDK object pool and arena allocators
+ * (C) 2022-2023 spicyjpeg - MPL licensed
+ */
+
+/**
+ * @file alloc.h
+ * @brief Header-only object pool and frame arena allocators
+ *
+ * @details This header provides two allocators which operate on a buffer
+ * supplied by the caller (usually a static array), as an alternative to
+ * malloc() for objects whose count or lifetime is known in advance:
+ *
+ * - FixedPool hands out blocks of a single size. Allocating and freeing a block
+ *   take constant time, as free blocks are kept in a singly linked list stored
+ *   inside the blocks themselves.
+ * - Arena is a bump allocator. Memory is never freed individually; instead the
+ *   whole arena is released at once through ArenaReset() (e.g. at the start of
+ *   each frame) or rolled back to a point saved with ArenaGetMark().
+ *
+ * Both can also be reset in constant time. Defining ALLOC_DEBUG_POISON before
+ * including this header fills newly allocated memory with 0xcd and released
+ * memory with 0xdd, in order to make use of uninitialized or stale data easier
+ * to spot.
+ *
+ * When included from C++, the psx::Pool and psx::FrameArena templates wrap the
+ * C API and provide their own storage. They do not use exceptions, RTTI or any
+ * standard library headers, so they can be used with -fno-exceptions and
+ * -fno-rtti.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#ifdef ALLOC_DEBUG_POISON
+#include <string.h>
+#endif
+
+#define ALLOC_POISON_NEW	0xcd
+#define ALLOC_POISON_FREE	0xdd
+
+/* Structure definitions */
+
+typedef struct _FixedPool {
+	void		*free_list;		// Singly linked list of freed blocks
+	uint8_t		*next, *end;	// Range of blocks never allocated so far
+	uint8_t		*start;
+	size_t		block_size;
+	size_t		used;			// Number of blocks currently allocated
+} FixedPool;
+
+typedef struct _Arena {
+	uint8_t		*start, *end;
+	uint8_t		*ptr;			// Next free byte
+} Arena;
+
+/* Fixed-size pool API */
+
+/**
+ * @brief Returns the actual size of each block in a pool.
+ *
+ * @details Block sizes are rounded up to a multiple of 4 bytes and to at least
+ * the size of a pointer, as free blocks hold a link to the next free block.
+ *
+ * @param block_size
+ * @return Rounded block size in bytes
+ */
+static inline size_t FixedPoolBlockSize(size_t block_size) {
+	if (block_size < sizeof(void *))
+		block_size = sizeof(void *);
+
+	return (block_size + 3) & ~3;
+}
+
+/**
+ * @brief Returns the size of the buffer required by FixedPoolInit().
+ *
+ * @param block_size
+ * @param count
+ * @return Buffer size in bytes
+ */
+static inline size_t FixedPoolBufferSize(size_t block_size, size_t count) {
+	return FixedPoolBlockSize(block_size) * count;
+}
+
+/**
+ * @brief Initializes a fixed-size block pool.
+ *
+ * @details Sets up a pool of count blocks carved from the given buffer, which
+ * must be at least FixedPoolBufferSize(block_size, count) bytes long and
+ * aligned to 4 bytes. Blocks are handed out in address order until the pool has
+ * been filled once, so initialization does not need to walk the buffer.
+ *
+ * @param pool
+ * @param buffer
+ * @param block_size
+ * @param count
+ */
+static inline void FixedPoolInit(
+	FixedPool *pool, void *buffer, size_t block_size, size_t count
+) {
+	pool->block_size = FixedPoolBlockSize(block_size);
+	pool->start      = (uint8_t *) buffer;
+	pool->end        = pool->start + pool->block_size * count;
+	pool->next       = pool->start;
+	pool->free_list  = (void *) 0;
+	pool->used       = 0;
+}
+
+/**
+ * @brief Allocates a block from a pool.
+ *
+ * @param pool
+ * @return Pointer to the block or NULL if the pool is full
+ */
+static inline void *FixedPoolAlloc(FixedPool *pool) {
+	void *ptr = pool->free_list;
+
+	if (ptr) {
+		pool->free_list = *((void **) ptr);
+	} else {
+		if (pool->next >= pool->end)
+			return (void *) 0;
+
+		ptr         = pool->next;
+		pool->next += pool->block_size;
+	}
+
+	pool->used++;
+#ifdef ALLOC_DEBUG_POISON
+	memset(ptr, ALLOC_POISON_NEW, pool->block_size);
+#endif
+	return ptr;
+}
+
+/**
+ * @brief Returns a block to a pool.
+ *
+ * @details Passing NULL does nothing. The block must have been allocated from
+ * the same pool.
+ *
+ * @param pool
+ * @param ptr
+ */
+static inline void FixedPoolFree(FixedPool *pool, void *ptr) {
+	if (!ptr)
+		return;
+
+#ifdef ALLOC_DEBUG_POISON
+	memset(ptr, ALLOC_POISON_FREE, pool->block_size);
+#endif
+	*((void **) ptr) = pool->free_list;
+	pool->free_list  = ptr;
+	pool->used--;
+}
+
+/**
+ * @brief Frees all blocks in a pool at once.
+ *
+ * @param pool
+ */
+static inline void FixedPoolReset(FixedPool *pool) {
+#ifdef ALLOC_DEBUG_POISON
+	memset(pool->start, ALLOC_POISON_FREE, pool->next - pool->start);
+#endif
+	pool->next      = pool->start;
+	pool->free_list = (void *) 0;
+	pool->used      = 0;
+}
+
+/**
+ * @brief Checks whether a pointer belongs to a pool's buffer.
+ *
+ * @param pool
+ * @param ptr
+ * @return 1 if ptr is within the pool, 0 otherwise
+ */
+static inline int FixedPoolContains(const FixedPool *pool, const void *ptr) {
+	return ((const uint8_t *) ptr >= pool->start) &&
+		((const uint8_t *) ptr < pool->end);
+}
+
+/* Arena API */
+
+/**
+ * @brief Initializes an arena.
+ *
+ * @param arena
+ * @param buffer
+ * @param size
+ */
+static inline void ArenaInit(Arena *arena, void *buffer, size_t size) {
+	arena->start = (uint8_t *) buffer;
+	arena->end   = arena->start + size;
+	arena->ptr   = arena->start;
+}
+
+/**
+ * @brief Allocates memory from an arena with the given alignment.
+ *
+ * @param arena
+ * @param size
+ * @param align Alignment in bytes, must be a power of two
+ * @return Pointer to the allocated memory or NULL if the arena is full
+ */
+static inline void *ArenaAllocAligned(Arena *arena, size_t size, size_t align) {
+	uintptr_t ptr = ((uintptr_t) arena->ptr + align - 1) & ~(align - 1);
+
+	if ((size > (uintptr_t) arena->end) || (ptr > ((uintptr_t) arena->end - size)))
+		return (void *) 0;
+
+	arena->ptr = (uint8_t *) (ptr + size);
+#ifdef ALLOC_DEBUG_POISON
+	memset((void *) ptr, ALLOC_POISON_NEW, size);
+#endif
+	return (void *) ptr;
+}
+
+/**
+ * @brief Allocates word-aligned memory from an arena.
+ *
+ * @param arena
+ * @param size
+ * @return Pointer to the allocated memory or NULL if the arena is full
+ */
+static inline void *ArenaAlloc(Arena *arena, size_t size) {
+	return ArenaAllocAligned(arena, size, 4);
+}
+
+/**
+ * @brief Returns the current allocation point of an arena.
+ *
+ * @details The returned value can be passed to ArenaSetMark() later on to free
+ * everything allocated after this call, e.g. to discard temporary data.
+ *
+ * @param arena
+ * @return Opaque mark
+ */
+static inline void *ArenaGetMark(const Arena *arena) {
+	return arena->ptr;
+}
+
+/**
+ * @brief Frees everything allocated from an arena after the given mark.
+ *
+ * @param arena
+ * @param mark Value previously returned by ArenaGetMark()
+ */
+static inline void ArenaSetMark(Arena *arena, void *mark) {
+#ifdef ALLOC_DEBUG_POISON
+	memset(mark, ALLOC_POISON_FREE, arena->ptr - (uint8_t *) mark);
+#endif
+	arena->ptr = (uint8_t *) mark;
+}
+
+/**
+ * @brief Frees everything allocated from an arena.
+ *
+ * @param arena
+ */
+static inline void ArenaReset(Arena *arena) {
+	ArenaSetMark(arena, arena->start);
+}
+
+/**
+ * @brief Returns the number of bytes allocated from an arena (including any
+ * alignment padding).
+ *
+ * @param arena
+ * @return Used space in bytes
+ */
+static inline size_t ArenaGetUsed(const Arena *arena) {
+	return arena->ptr - arena->start;
+}
+
+/* C++ API */
+
+#ifdef __cplusplus
+
+namespace psx {
+
+// Placement new is normally provided by <new>, which is not always available
+// when building without a hosted standard library. A tagged overload is used
+// instead so that it can't clash with the standard one.
+struct _AllocTag {};
+
+}
+
+inline void *operator new(size_t, void *ptr, psx::_AllocTag) noexcept {
+	return ptr;
+}
+inline void operator delete(void *, void *, psx::_AllocTag) noexcept {}
+
+namespace psx {
+
+/**
+ * @brief Pool of up to N objects of type T with its own storage.
+ *
+ * @details create() allocates a slot and constructs an object in it, while
+ * destroy() runs the destructor and returns the slot to the pool. reset()
+ * discards all objects at once without running their destructors, so it should
+ * only be used with trivially destructible types or when the destructors do not
+ * matter.
+ */
+template<typename T, size_t N> class Pool {
+private:
+	// Same rounding as FixedPoolBlockSize(), which can't be used in a constant
+	// expression.
+	static constexpr size_t _block_size =
+		((sizeof(T) > sizeof(void *) ? sizeof(T) : sizeof(void *)) + 3) & ~size_t(3);
+
+	alignas(T) alignas(void *) uint8_t _data[_block_size * N];
+	FixedPool _pool;
+
+public:
+	inline Pool(void) {
+		FixedPoolInit(&_pool, _data, _block_size, N);
+	}
+
+	template<typename... Args> inline T *create(Args &&... args) {
+		void *ptr = FixedPoolAlloc(&_pool);
+
+		if (!ptr)
+			return nullptr;
+
+		return new(ptr, _AllocTag()) T(static_cast<Args &&>(args)...);
+	}
+	inline void destroy(T *obj) {
+		if (!obj)
+			return;
+
+		obj->~T();
+		FixedPoolFree(&_pool, obj);
+	}
+	inline void reset(void) {
+		FixedPoolReset(&_pool);
+	}
+
+	inline bool contains(const T *obj) const {
+		return FixedPoolContains(&_pool, obj);
+	}
+	inline size_t used(void) const {
+		return _pool.used;
+	}
+	inline size_t capacity(void) const {
+		return N;
+	}
+};
+
+/**
+ * @brief Arena with N bytes of storage, meant to be reset once per frame.
+ *
+ * @details Objects created in the arena are never destroyed individually and
+ * their destructors are not run, so only trivially destructible types should be
+ * allocated from it.
+ */
+template<size_t N> class FrameArena {
+private:
+	alignas(8) uint8_t _data[N];
+	Arena _arena;
+
+public:
+	inline FrameArena(void) {
+		ArenaInit(&_arena, _data, N);
+	}
+
+	inline void *alloc(size_t size, size_t align = 4) {
+		return ArenaAllocAligned(&_arena, size, align);
+	}
+	template<typename T> inline T *alloc_array(size_t count) {
+		if (count > (N / sizeof(T)))
+			return nullptr;
+
+		return reinterpret_cast<T *>(alloc(sizeof(T) * count, alignof(T)));
+	}
+	template<typename T, typename... Args> inline T *create(Args &&... args) {
+		void *ptr = alloc(sizeof(T), alignof(T));
+
+		if (!ptr)
+			return nullptr;
+
+		return new(ptr, _AllocTag()) T(static_cast<Args &&>(args)...);
+	}
+
+	inline void *get_mark(void) const {
+		return ArenaGetMark(&_arena);
+	}
+	inline void set_mark(void *mark) {
+		ArenaSetMark(&_arena, mark);
+	}
+	inline void reset(void) {
+		ArenaReset(&_arena);
+	}
+
+	inline size_t used(void) const {
+		return ArenaGetUsed(&_arena);
+	}
+	inline size_t capacity(void) const {
+		return N;
+	}
+};
+
+}
+
+#endif
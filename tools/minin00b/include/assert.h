@@ -3,7 +3,8 @@
  * (C) 2022-2023 spicyjpeg - MPL licensed
  *
  * The _sdk_*() macros are used internally by PSn00bSDK to output messages when
- * building in debug mode.
+ * building in debug mode. Defining SDK_LOG_SIO routes them through psxsio's
+ * buffered log instead of the BIOS TTY.
  */
 
 #pragma once
@@ -34,7 +35,18 @@ void _assert_abort(const char *file, int line, const char *expr);
 #define assert(expr) \
 	((expr) ? ((void) 0) : _assert_abort(__FILE__, __LINE__, #expr))
 
+#if defined(SDK_LOG_SIO)
+// Buffered, non-blocking logging through psxsio (see SIO_InitLog()).
+int SIO_Log(const char *fmt, ...);
+
 #ifdef SDK_LIBRARY_NAME
+#define _sdk_log(fmt, ...) \
+	SIO_Log(SDK_LIBRARY_NAME ": " fmt __VA_OPT__(,) __VA_ARGS__)
+#else
+#define _sdk_log(fmt, ...) \
+	SIO_Log(fmt __VA_OPT__(,) __VA_ARGS__)
+#endif
+#elif defined(SDK_LIBRARY_NAME)
 #define _sdk_log(fmt, ...) \
 	printf(SDK_LIBRARY_NAME ": " fmt __VA_OPT__(,) __VA_ARGS__)
 #else
@@ -76,6 +76,16 @@ typedef struct {
 	uint16_t version;
 } BS_Header;
 
+typedef struct {
+	VLC_Context			ctx;
+	uint32_t			*vlc_buf[2], *slice_buf[2];
+	size_t				vlc_size, slice_size;
+	int16_t				x, y, slice_width, height, num_slices;
+	volatile int16_t	slices_left;
+	int8_t				mode, in_index, out_index;
+	volatile int8_t		chunk_state[2];
+} MDEC_Pipeline;
+
 /* Public API */
 
 #ifdef __cplusplus
@@ -505,6 +515,130 @@ size_t DecDCTvlcSize2(size_t size);
  */
 void DecDCTvlcBuild(DECDCTTAB *table);
 
+/**
+ * @brief Sets the lookup table used by the alternate implementation of the .BS
+ * decompressor.
+ *
+ * @details Makes DecDCTvlcStart2(), DecDCTvlcContinue2() and DecDCTvlc2() use
+ * an already expanded lookup table rather than one generated by
+ * DecDCTvlcBuild(). This allows the table to be linked into the executable (see
+ * DecDCTvlcPrebuiltTable2) or loaded from disc as is, skipping generation
+ * entirely; a binary copy of the table (decdcttab.bin) is built alongside the
+ * library for the latter purpose.
+ *
+ * @param table Pointer to DECDCTTAB structure, or 0 to unset the current table
+ *
+ * @see DecDCTvlcBuild()
+ */
+void DecDCTvlcSetTable2(const DECDCTTAB *table);
+
+/**
+ * @brief Fully expanded lookup table for the alternate implementation of the
+ * .BS decompressor.
+ *
+ * @details A prebuilt copy of the table generated by DecDCTvlcBuild(), to be
+ * passed to DecDCTvlcSetTable2(). It is only linked in if referenced and placed
+ * in its own .rodata.decdcttab section, so it can be moved into an overlay or a
+ * separate memory region by the linker script.
+ */
+extern const DECDCTTAB DecDCTvlcPrebuiltTable2;
+
+/**
+ * @brief Initializes a pipelined frame decoder.
+ *
+ * @details Sets up a MDEC_Pipeline structure for decoding frames of the given
+ * size using DecDCTPipelineDecode(). Two buffers must be provided:
+ *
+ * - vlc_buf, which must be at least (vlc_size + 1) * 2 words long, is split
+ *   into two chunk buffers the bitstream is decompressed into. vlc_size is
+ *   rounded down to a multiple of 32 words; smaller chunks reduce latency and
+ *   memory usage at the cost of more frequent DMA interrupts, 1024 words is a
+ *   good starting point.
+ * - slice_buf is split into two buffers holding one 16-pixel-wide vertical
+ *   slice of decoded image data each. It must be at least height * 16 words
+ *   long in 16bpp mode or height * 24 words long in 24bpp mode.
+ *
+ * Both buffers shall remain allocated for as long as the pipeline is in use.
+ * The height must be a multiple of 16 pixels, while the width is rounded up to
+ * the next multiple of 16.
+ *
+ * @param pipe
+ * @param vlc_buf
+ * @param vlc_size Length of each chunk in 32-bit words (must be multiple of 32)
+ * @param slice_buf
+ * @param width Frame width in pixels
+ * @param height Frame height in pixels (must be multiple of 16)
+ * @param mode DECDCT_MODE_16BPP, DECDCT_MODE_16BPP_BIT15 or DECDCT_MODE_24BPP
+ *
+ * @see DecDCTPipelineDecode()
+ */
+void DecDCTPipelineInit(
+	MDEC_Pipeline *pipe,
+	uint32_t *vlc_buf,
+	size_t vlc_size,
+	uint32_t *slice_buf,
+	int width,
+	int height,
+	int mode
+);
+
+/**
+ * @brief Decodes a .BS file (or STR frame) and uploads it to VRAM with
+ * decompression, MDEC decoding and VRAM upload overlapped.
+ *
+ * @details Decodes a frame into VRAM at the given coordinates, running the
+ * three decoding stages concurrently rather than one after another: while the
+ * CPU decompresses the next chunk of the bitstream using DecDCTvlcContinue(),
+ * the MDEC processes the previous chunk and the last slice it decoded is
+ * uploaded to VRAM using LoadImage(). The MDEC and GPU stages are driven by
+ * callbacks registered with DMACallback(0) and DMACallback(1), which are
+ * restored once the frame has been fully decoded and DecDCTPipelineSync(0)
+ * has been called.
+ *
+ * This function returns as soon as the whole bitstream has been decompressed
+ * and handed over to the MDEC; the last few slices will still be decoded and
+ * uploaded in the background. DecDCTPipelineSync() can be used to wait for the
+ * frame to be completely uploaded. If another frame is still being decoded,
+ * this function will wait for it to finish first.
+ *
+ * As slice buffers are reused as soon as the MDEC has decoded the next slice,
+ * the GPU shall not be kept busy with long drawing operations while a frame is
+ * being decoded or slices may be overwritten before they are uploaded.
+ *
+ * WARNING: InitGeom() and DecDCTReset(0) must be called prior to using this
+ * function. Only one frame can be decoded at a time as the MDEC is a single
+ * shared resource. In case of failure the MDEC shall be reset using
+ * DecDCTReset() before decoding any other frame.
+ *
+ * @param pipe Pointer to MDEC_Pipeline initialized by DecDCTPipelineInit()
+ * @param bs
+ * @param x
+ * @param y
+ * @return 0 or -1 in case of failure
+ *
+ * @see DecDCTPipelineInit(), DecDCTPipelineSync()
+ */
+int DecDCTPipelineDecode(MDEC_Pipeline *pipe, const uint32_t *bs, int x, int y);
+
+/**
+ * @brief Waits for a pipelined frame decode to finish or returns its status.
+ *
+ * @details Waits until the frame being decoded by DecDCTPipelineDecode() has
+ * been fully uploaded to VRAM (if mode = 0) or returns the number of slices
+ * left to decode (if mode = 1). Once the frame is finished, DecDCTPipelineSync(0)
+ * also restores the DMA callbacks that were registered before decoding.
+ *
+ * Note that the VRAM upload of the last slice may still be in progress when
+ * this function returns; use DrawSync(0) to wait for it if needed.
+ *
+ * @param mode
+ * @return 0 or -1 in case of a timeout (mode = 0), number of slices left
+ * (mode = 1)
+ *
+ * @see DecDCTPipelineDecode()
+ */
+int DecDCTPipelineSync(int mode);
+
 #ifdef __cplusplus
 }
 #endif
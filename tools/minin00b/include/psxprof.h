@@ -0,0 +1,218 @@
+/*
+ * PSn00bSDK profiling library
+ * (C) 2022-2023 spicyjpeg - MPL licensed
+ */
+
+/**
+ * @file psxprof.h
+ * @brief Profiling library header
+ *
+ * @details This library measures how much time is spent between pairs of
+ * ProfBegin() and ProfEnd() calls on a marker and aggregates the results into
+ * per-frame minimum, average and maximum times. Statistics can be drawn as a
+ * HUD using the debug font functions or streamed over the serial port.
+ *
+ * Time is measured using root counter 2, which is set to count at 1/8 of the
+ * system clock (about 4.23 MHz or 0.236 us per tick). As the counter is only 16
+ * bits wide it wraps around every ~15.5 ms; the library extends it to 32 bits in
+ * software and uses the horizontal blank count from root counter 1 (set up by
+ * ResetGraph()) to account for wraparounds between two reads. Root counter 2
+ * must thus not be used by the game or mod at the same time.
+ *
+ * Code compiled with -finstrument-functions (enabled by the mod-builder's
+ * "profile" option) can additionally log every function call into a ring
+ * buffer set up with ProfTraceInit(), which the mod-builder reads back from
+ * PCSX-Redux to produce a flame graph without any manual markers.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Structure definitions */
+
+typedef struct _PROF_Marker {
+	const char			*name;
+	struct _PROF_Marker	*next;
+	int					registered;
+
+	uint32_t	start;			// Time of the outermost ProfBegin() call
+	uint32_t	frame_time;		// Time spent in the current frame so far
+	uint16_t	frame_calls;	// Number of calls in the current frame so far
+	uint16_t	depth;			// Current ProfBegin() nesting level
+
+	// Totals for the frames in the current window.
+	uint32_t	window_min, window_max, window_total;
+	uint32_t	window_calls;
+
+	// Statistics (in ticks per frame) for the last completed window.
+	uint32_t	min, avg, max;
+	uint32_t	calls;			// Average number of calls per frame
+} PROF_Marker;
+
+// Each entry in the trace buffer is a pair of words: the address of the
+// function entered or left (with bit 0 set for exits) followed by the time.
+typedef struct _PROF_TraceHeader {
+	uint32_t			magic;
+	uint32_t			*entries;
+	uint32_t			mask;		// Buffer length in entries, minus one
+	volatile uint32_t	count;		// Total number of entries ever written
+	volatile uint32_t	enabled;
+} PROF_TraceHeader;
+
+/* Macros */
+
+/**
+ * @brief Static initializer for a PROF_Marker structure.
+ *
+ * @details Markers are registered with the profiler automatically the first
+ * time they are used. Example:
+ *
+ *     static PROF_Marker draw_marker = PROF_MARKER("draw");
+ */
+#define PROF_MARKER(_name) { .name = (_name) }
+
+#define _PROF_CONCAT(a, b)	a ## b
+#define _PROF_SCOPE_VAR(line)	_PROF_CONCAT(_prof_scope_, line)
+
+/**
+ * @brief Profiles the rest of the enclosing scope.
+ *
+ * @details Calls ProfBegin() on the given marker, then ProfEnd() automatically
+ * when the current scope is left (including through early returns). Relies on
+ * GCC's cleanup attribute, so it works in both C and C++.
+ */
+#define PROF_SCOPE(marker) \
+	PROF_Marker *_PROF_SCOPE_VAR(__LINE__) \
+		__attribute__((cleanup(_ProfScopeEnd))) = (ProfBegin(marker), (marker))
+
+/* Public API */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Initializes the profiler.
+ *
+ * @details Configures root counter 2 and resets all statistics. Statistics are
+ * recalculated every window frames (i.e. calls to ProfFrame()); passing 0 uses
+ * the default window of 60 frames.
+ *
+ * @param window
+ */
+void ProfInit(int window);
+
+/**
+ * @brief Returns the current time in ticks.
+ *
+ * @details Returns a free-running 32-bit tick count (1/8 of the system clock).
+ * This function must be called at least every couple of seconds, which is
+ * always the case as long as ProfFrame() is called once per frame.
+ *
+ * @return Current time
+ */
+uint32_t ProfGetTime(void);
+
+/**
+ * @brief Converts a tick count to microseconds.
+ *
+ * @param ticks Up to ~1 million ticks (~250 ms)
+ * @return Time in microseconds
+ */
+uint32_t ProfTicksToUs(uint32_t ticks);
+
+/**
+ * @brief Starts timing a marker.
+ *
+ * @details Nested or recursive calls on the same marker are allowed; only the
+ * time between the outermost ProfBegin() and ProfEnd() calls is counted.
+ *
+ * @param marker
+ *
+ * @see ProfEnd(), PROF_SCOPE()
+ */
+void ProfBegin(PROF_Marker *marker);
+
+/**
+ * @brief Stops timing a marker and adds the elapsed time to the current frame.
+ *
+ * @param marker
+ */
+void ProfEnd(PROF_Marker *marker);
+
+/**
+ * @brief Ends the current frame.
+ *
+ * @details Adds the time spent in each marker during the frame to the current
+ * window, and updates the statistics of all markers once the window is
+ * complete. The time between two calls is tracked by a built-in "frame" marker.
+ * This function should be called once per frame, e.g. right after VSync().
+ */
+void ProfFrame(void);
+
+/**
+ * @brief Returns the list of registered markers.
+ *
+ * @details The first marker in the list is always the built-in "frame" marker.
+ * The list can be walked through the next field of each marker.
+ *
+ * @return Pointer to the first marker
+ */
+PROF_Marker *ProfGetMarkers(void);
+
+/**
+ * @brief Prints the statistics of all markers to a debug font stream.
+ *
+ * @details Prints one line per marker with the name followed by minimum,
+ * average and maximum time per frame in microseconds and the average share of
+ * the frame. The stream should be opened with at least 32 characters per
+ * marker. FntFlush() still has to be called to draw the text.
+ *
+ * @param stream Stream ID returned by FntOpen()
+ */
+void ProfPrint(int stream);
+
+/**
+ * @brief Sends the statistics of all markers over the serial port.
+ *
+ * @details Writes one line per marker in the same format as ProfPrint(), using
+ * the buffered SIO log (which must have been set up with SIO_InitLog()). The
+ * lines are prefixed with "prof:" so they can be filtered out from other output.
+ */
+void ProfLog(void);
+
+/**
+ * @brief Sets up the function call trace buffer.
+ *
+ * @details Starts logging function entries and exits from code compiled with
+ * -finstrument-functions into the given buffer, which must hold length entries
+ * of 8 bytes each (length must be a power of two). Once full, the oldest entries
+ * are overwritten. Calls made before this function is invoked are not logged.
+ * The buffer should be placed in memory that is not otherwise used by the mod
+ * or game, e.g. allocated with malloc(), rather than in a static array, as the
+ * latter would add to the size of the mod's binary.
+ *
+ * @param buffer
+ * @param length Number of entries (power of two)
+ * @return 0 or -1 if the arguments are invalid
+ *
+ * @see ProfTraceEnable()
+ */
+int ProfTraceInit(uint32_t *buffer, size_t length);
+
+/**
+ * @brief Pauses or resumes function call tracing.
+ *
+ * @param enable
+ */
+void ProfTraceEnable(int enable);
+
+static inline void _ProfScopeEnd(PROF_Marker **marker) {
+	ProfEnd(*marker);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -9,18 +9,21 @@
  *
  * @details This library provides a custom API to access the PS1's serial port.
  * Sending and receiving data is done fully asynchronously using a pair of
- * 128-byte FIFOs kept in main RAM, with optional hardware flow control. More
- * advanced use cases such as custom callbacks for each byte received are also
- * supported.
+ * ring buffers kept in main RAM (256 bytes each by default, or any power-of-two
+ * size through SIO_SetBuffers()), with optional hardware flow control. More
+ * advanced use cases such as custom callbacks for each byte received, and
+ * CRC-checked packet framing for bulk transfers, are also supported.
  *
  * A BIOS TTY driver to redirect stdin/stdout (including BIOS messages as well
  * as PSn00bSDK's own debug logging) to the serial port is also provided for
- * debugging purposes.
+ * debugging purposes, along with a non-blocking buffered log for code whose
+ * timing must not be disturbed by printing.
  */
 
 #pragma once
 
 #include <stdint.h>
+#include <stddef.h>
 
 /* Enum and register definitions */
 
@@ -74,6 +77,8 @@ typedef enum _SIO_FlowControl {
 	//SIO_FC_DTR_DSR	= 2
 } SIO_FlowControl;
 
+#define SIO_MAX_PACKET_LENGTH 0xffff
+
 /* Public API */
 
 #ifdef __cplusplus
@@ -112,6 +117,26 @@ void SIO_Init(int baud, uint16_t mode);
  */
 void SIO_Quit(void);
 
+/**
+ * @brief Replaces the TX and RX ring buffers.
+ *
+ * @details Sets the buffers used by the driver to send and receive data, in
+ * place of the default 256-byte ones. Both lengths must be powers of two.
+ * Passing NULL as either buffer restores the respective default buffer. Any
+ * data pending in the old buffers is discarded, so this function should be
+ * called while the TX and RX buffers are empty (e.g. right after SIO_Init()).
+ *
+ * Larger buffers are useful for bulk transfers at high baud rates, as they
+ * allow more data to be queued or received in between calls.
+ *
+ * @param tx
+ * @param tx_length TX buffer length in bytes, must be a power of two
+ * @param rx
+ * @param rx_length RX buffer length in bytes, must be a power of two
+ * @return 0 or -1 if either length is invalid
+ */
+int SIO_SetBuffers(uint8_t *tx, size_t tx_length, uint8_t *rx, size_t rx_length);
+
 /**
  * @brief Sets the flow control mode.
  *
@@ -162,6 +187,19 @@ int SIO_ReadByte(void);
  */
 int SIO_ReadByte2(void);
 
+/**
+ * @brief Reads multiple bytes from the RX buffer (non-blocking).
+ *
+ * @details Copies up to the given number of bytes from the RX buffer, without
+ * waiting for any more data to be received. This function is safe to use in a
+ * critical section.
+ *
+ * @param data
+ * @param length Maximum number of bytes to read
+ * @return Number of bytes actually read
+ */
+int SIO_Read(void *data, size_t length);
+
 /**
  * @brief Waits for a byte to be received or returns the RX buffer's length.
  *
@@ -197,6 +235,23 @@ int SIO_ReadSync(int mode);
  */
 void *SIO_ReadCallback(int (*func)(uint8_t));
 
+/**
+ * @brief Sets a callback for refilling the TX buffer.
+ *
+ * @details Registers a function to be called from the serial IRQ handler
+ * whenever the TX buffer becomes empty, which can then queue more data using
+ * SIO_Write(). This allows data to be streamed without polling from the main
+ * loop. Used internally by the buffered log (see SIO_InitLog()).
+ *
+ * The callback will run in the exception handler's context, so it should be as
+ * fast as possible and shall not call any function that relies on interrupts
+ * being enabled.
+ *
+ * @param func
+ * @return Previously set callback or NULL
+ */
+void *SIO_WriteCallback(void (*func)(void));
+
 /**
  * @brief Writes a byte to the TX buffer (blocking).
  *
@@ -230,6 +285,33 @@ int SIO_WriteByte(uint8_t value);
  */
 int SIO_WriteByte2(uint8_t value);
 
+/**
+ * @brief Writes multiple bytes to the TX buffer (non-blocking).
+ *
+ * @details Appends as many of the given bytes as will fit to the TX buffer and
+ * starts sending them if the serial port is idle. The TX IRQ handler then keeps
+ * the serial port's internal FIFO filled until the buffer is empty.
+ *
+ * This function is safe to use in a critical section, however no data will be
+ * sent while interrupts are disabled unless SIO_FlushTX() is called.
+ *
+ * @param data
+ * @param length
+ * @return Number of bytes actually written to the buffer
+ *
+ * @see SIO_FlushTX()
+ */
+int SIO_Write(const void *data, size_t length);
+
+/**
+ * @brief Moves pending bytes from the TX buffer to the serial port.
+ *
+ * @details Sends as many bytes from the TX buffer as the serial port can
+ * currently accept, without relying on the TX IRQ. Calling this function in a
+ * loop allows the TX buffer to be drained with interrupts disabled.
+ */
+void SIO_FlushTX(void);
+
 /**
  * @brief Waits for all bytes to be sent or returns the TX buffer's length.
  *
@@ -244,6 +326,105 @@ int SIO_WriteByte2(uint8_t value);
  */
 int SIO_WriteSync(int mode);
 
+/**
+ * @brief Sends a CRC-framed packet (blocking).
+ *
+ * @details Sends the given payload, prefixed with a "PK" magic and a 16-bit
+ * little endian length, and followed by its 16-bit little endian
+ * CRC-16/CCITT-FALSE (computed over the length and payload). This function
+ * blocks until the whole packet has been written to the TX buffer and flushes
+ * the buffer manually if required, so it can also be used in a critical
+ * section.
+ *
+ * @param data
+ * @param length Payload length in bytes, 1 to SIO_MAX_PACKET_LENGTH
+ * @return 0 or -1 in case of a timeout
+ *
+ * @see SIO_ReceivePacket()
+ */
+int SIO_SendPacket(const void *data, size_t length);
+
+/**
+ * @brief Receives a CRC-framed packet (non-blocking).
+ *
+ * @details Parses any data available in the RX buffer, looking for a packet in
+ * the format used by SIO_SendPacket(). The payload is copied into the given
+ * buffer as it is received, so the same buffer must be passed on each call
+ * until a nonzero value is returned. Any data preceding the packet's magic is
+ * skipped.
+ *
+ * @param data
+ * @param max_length Buffer length, longer packets are rejected
+ * @return Payload length once a valid packet has been received, 0 if the packet
+ * is still incomplete, -1 if it failed the CRC check or was too long
+ *
+ * @see SIO_SendPacket(), SIO_ResetPacketParser()
+ */
+int SIO_ReceivePacket(void *data, size_t max_length);
+
+/**
+ * @brief Discards any partially received packet.
+ *
+ * @details Resets the parser used by SIO_ReceivePacket(), e.g. after a timeout.
+ */
+void SIO_ResetPacketParser(void);
+
+/**
+ * @brief Initializes the buffered log.
+ *
+ * @details Sets up the ring buffer messages are formatted into by SIO_Log()
+ * (2048 bytes by default if buffer is NULL) and registers a write callback (see
+ * SIO_WriteCallback()) to move them to the TX buffer as the serial port sends
+ * data. SIO_Init() must be called beforehand.
+ *
+ * As the log is only drained from the serial IRQ once a transfer is in
+ * progress, SIO_FlushLog() should also be called periodically (e.g. from a
+ * VSync callback) to start sending new messages. The log shall not be used at
+ * the same time as SIO_SendPacket(), as messages could end up in the middle of
+ * a packet.
+ *
+ * @param buffer
+ * @param length Buffer length in bytes, must be a power of two
+ * @return 0 or -1 if the length is invalid
+ *
+ * @see SIO_Log(), SIO_FlushLog()
+ */
+int SIO_InitLog(char *buffer, size_t length);
+
+/**
+ * @brief Formats a message into the log buffer (non-blocking).
+ *
+ * @details printf() replacement that never waits for the serial port. The
+ * message (truncated to 127 characters) is appended to the log buffer if there
+ * is enough space, otherwise it is dropped and the counter returned by
+ * SIO_GetLogDropped() is incremented. This function is safe to use in a
+ * critical section or IRQ callback.
+ *
+ * @param fmt
+ * @return Message length, -1 if the message was dropped
+ */
+int SIO_Log(const char *fmt, ...);
+
+/**
+ * @brief Moves pending log messages to the TX buffer.
+ *
+ * @details Copies as much of the log buffer as fits into the TX buffer and
+ * starts sending it. Does not wait for the serial port, so it can be called
+ * from a VSync callback.
+ */
+void SIO_FlushLog(void);
+
+/**
+ * @brief Returns the number of log messages dropped.
+ *
+ * @details Returns how many messages were dropped by SIO_Log() due to the log
+ * buffer being full, optionally resetting the counter.
+ *
+ * @param reset
+ * @return Number of dropped messages
+ */
+uint32_t SIO_GetLogDropped(int reset);
+
 /**
  * @brief Installs the serial port TTY driver.
  *
@@ -252,7 +433,7 @@ int SIO_WriteSync(int mode);
  * bits, 1 stop bit and no parity.
  *
  * This function shall only be used for debugging purposes. Picking a high baud
- * rate is recommended as all TTY writes are blocking and bypass the TX buffer.
+ * rate is recommended as TTY writes block once the TX buffer is full.
  *
  * NOTE: some executable loaders, such as Unirom and Caetla, already replace
  * the BIOS TTY driver with a custom one. Calling AddSIO() will break the
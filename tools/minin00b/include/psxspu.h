@@ -63,6 +63,13 @@ typedef enum _SPU_WaitMode {
 
 /* Structure definitions */
 
+// Addresses and sizes are in 8-byte units, as in SPU registers.
+typedef struct _SPU_MallocRec {
+	uint16_t	addr, size;
+} SPU_MallocRec;
+
+typedef void (*SPU_RelocateCallback)(uint32_t old_addr, uint32_t new_addr, size_t size);
+
 #if 0
 typedef struct _SpuVolume {
 	int16_t left, right;
@@ -155,12 +162,27 @@ void SpuInit(void);
 size_t SpuRead(uint32_t *data, size_t size);
 size_t SpuWrite(const uint32_t *data, size_t size);
 size_t SpuWritePartly(const uint32_t *data, size_t size);
+int SpuEnqueueWrite(const uint32_t *data, size_t size, uint32_t addr);
+void *SpuSetTransferCallback(void (*func)(void));
 SPU_TransferMode SpuSetTransferMode(SPU_TransferMode mode);
 SPU_TransferMode SpuGetTransferMode(void);
 uint32_t SpuSetTransferStartAddr(uint32_t addr);
 uint32_t SpuGetTransferStartAddr(void);
 int SpuIsTransferCompleted(int mode);
 
+void SpuInitMalloc(int num, SPU_MallocRec *table);
+int SpuMalloc(int size);
+int SpuMallocWithStartAddr(uint32_t addr, int size);
+void SpuFree(uint32_t addr);
+size_t SpuGetFreeSize(size_t *largest);
+int SpuMallocCompact(uint32_t *buffer, size_t buffer_size, SPU_RelocateCallback callback);
+
+uint32_t SpuSetVoiceAllocMask(uint32_t mask);
+int SpuAllocVoice(int priority);
+void SpuFreeVoice(int ch);
+int SpuSetVoicePriority(int ch, int priority);
+uint32_t SpuGetAllocatedVoices(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -16,7 +16,7 @@
 typedef struct _HeapUsage {
 	size_t total;		// Total size of heap + stack
 	size_t heap;		// Amount of memory currently reserved for heap
-	size_t stack;		// Amount of memory currently reserved for stack
+	size_t stack;		// Amount of memory currently reserved for stack (always 0)
 	size_t alloc;		// Amount of memory currently allocated
 	size_t alloc_max;	// Maximum amount of memory ever allocated
 } HeapUsage;
@@ -36,6 +36,18 @@ int abs(int value);
 int rand(void);
 void srand(int seed);
 
+void InitHeap(void *addr, size_t size);
+int AddHeapPool(size_t block_size, int count);
+void GetHeapUsage(HeapUsage *usage);
+
+void *malloc(size_t size);
+void *calloc(size_t num, size_t size);
+void *realloc(void *ptr, size_t size);
+void free(void *ptr);
+
+// Internal: malloc() that falls back to the kernel heap before InitHeap().
+void *_malloc_fallback(size_t size);
+
 long strtol(const char *str, char **str_end, int base);
 long long strtoll(const char *str, char **str_end, int base);
 //float strtof(const char *str, char **str_end);
@@ -0,0 +1,217 @@
+/*
+ * PSn00bSDK standard library (heap allocator stress test)
+ * (C) 2022-2023 spicyjpeg - MPL licensed
+ *
+ * Performs random malloc(), calloc(), realloc() and free() calls on a small
+ * heap, filling each allocation with a pattern derived from its index and
+ * checking that no allocation overlaps or corrupts another one. Once all blocks
+ * are freed, the heap must have merged back into a single free block. The SDK's
+ * functions are renamed with a psx_ prefix when building (see Makefile).
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HEAP_SIZE	0x40000
+#define MAX_ALLOCS	256
+
+typedef struct {
+	size_t total, heap, stack, alloc, alloc_max;
+} HeapUsage;
+
+void psx_InitHeap(void *addr, size_t size);
+int psx_AddHeapPool(size_t block_size, int count);
+void psx_GetHeapUsage(HeapUsage *usage);
+void *psx_malloc(size_t size);
+void *psx_calloc(size_t num, size_t size);
+void *psx_realloc(void *ptr, size_t size);
+void psx_free(void *ptr);
+void *psx__malloc_fallback(size_t size);
+
+// Dependencies of malloc.c, which would otherwise be provided by other parts of
+// the SDK.
+void *psx_memset(void *dest, int ch, size_t count) {
+	return memset(dest, ch, count);
+}
+
+void *psx_memcpy(void *dest, const void *src, size_t count) {
+	return memcpy(dest, src, count);
+}
+
+static int _kernel_allocs = 0;
+
+void *psx_alloc_kernel_memory(int size) {
+	_kernel_allocs++;
+	return malloc(size);
+}
+
+void psx_free_kernel_memory(void *ptr) {
+	_kernel_allocs--;
+	free(ptr);
+}
+
+/* Helpers */
+
+typedef struct {
+	uint8_t	*ptr;
+	size_t	size;
+} Allocation;
+
+static Allocation _allocs[MAX_ALLOCS];
+static int        _failures = 0;
+
+#define _fail(...) \
+	if (_failures++ < 20) \
+		printf("FAIL: " __VA_ARGS__)
+
+static void _fill(int index) {
+	for (size_t i = 0; i < _allocs[index].size; i++)
+		_allocs[index].ptr[i] = (uint8_t) (index * 31 + i);
+}
+
+static void _verify(int index, size_t size) {
+	for (size_t i = 0; i < size; i++) {
+		if (_allocs[index].ptr[i] != (uint8_t) (index * 31 + i)) {
+			_fail("allocation %d corrupted at offset %zu\n", index, i);
+			return;
+		}
+	}
+}
+
+static size_t _random_size(void) {
+	switch (rand() % 4) {
+		case 0:
+			return 1 + rand() % 16;
+		case 1:
+			return 1 + rand() % 256;
+		case 2:
+			return 1 + rand() % 4096;
+		default:
+			return 1 + rand() % 32;
+	}
+}
+
+/* Main */
+
+int main(int argc, char **argv) {
+	int iterations = 10000;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-n") && (i + 1 < argc))
+			iterations = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-s") && (i + 1 < argc))
+			srand(atoi(argv[++i]));
+	}
+
+	// The heap is deliberately misaligned to check that InitHeap() aligns it.
+	uint8_t *heap = malloc(HEAP_SIZE + 1);
+	HeapUsage usage, initial;
+
+	// Before InitHeap() is called, _malloc_fallback() must allocate from the
+	// kernel and free() must give the block back to it.
+	void *kernel_ptr = psx__malloc_fallback(64);
+
+	if (!kernel_ptr || (_kernel_allocs != 1))
+		_fail("_malloc_fallback() didn't allocate from the kernel\n");
+
+	psx_free(kernel_ptr);
+
+	if (_kernel_allocs)
+		_fail("free() didn't return a kernel block to the kernel\n");
+
+	for (int pass = 0; pass < 2; pass++) {
+		psx_InitHeap(heap + 1, HEAP_SIZE);
+		psx_GetHeapUsage(&initial);
+
+		if (pass && (psx_AddHeapPool(16, 64) || psx_AddHeapPool(32, 32)))
+			_fail("unable to create pools\n");
+
+		memset(_allocs, 0, sizeof(_allocs));
+
+		for (int i = 0; i < iterations; i++) {
+			int        index = rand() % MAX_ALLOCS;
+			Allocation *a    = &_allocs[index];
+
+			if (!a->ptr) {
+				size_t size = _random_size();
+
+				a->ptr  = (rand() % 4) ? psx_malloc(size) : psx_calloc(1, size);
+				a->size = a->ptr ? size : 0;
+
+				if (a->ptr && ((uintptr_t) a->ptr % 8))
+					_fail("misaligned allocation %p\n", a->ptr);
+				if (a->ptr)
+					_fill(index);
+			} else if (rand() % 2) {
+				size_t  size = _random_size();
+				uint8_t *ptr = psx_realloc(a->ptr, size);
+
+				if (!ptr)
+					continue;
+
+				a->ptr = ptr;
+				_verify(index, (size < a->size) ? size : a->size);
+				a->size = size;
+				_fill(index);
+			} else {
+				_verify(index, a->size);
+				psx_free(a->ptr);
+				a->ptr  = 0;
+				a->size = 0;
+			}
+		}
+
+		size_t allocated = 0;
+
+		for (int i = 0; i < MAX_ALLOCS; i++) {
+			_verify(i, _allocs[i].size);
+			allocated += _allocs[i].size;
+		}
+
+		psx_GetHeapUsage(&usage);
+
+		if (usage.alloc < allocated)
+			_fail("alloc = %zu, expected at least %zu\n", usage.alloc, allocated);
+		if (usage.alloc_max < usage.alloc)
+			_fail("alloc_max = %zu < alloc = %zu\n", usage.alloc_max, usage.alloc);
+
+		for (int i = 0; i < MAX_ALLOCS; i++)
+			psx_free(_allocs[i].ptr);
+
+		psx_GetHeapUsage(&usage);
+
+		if (usage.alloc)
+			_fail("alloc = %zu after freeing everything\n", usage.alloc);
+
+		// Pools are never returned to the heap, but everything else must have
+		// been merged back into the initial free block.
+		if (!pass && (usage.heap != initial.heap))
+			_fail("heap = %zu after freeing everything, expected %zu\n", usage.heap, initial.heap);
+
+		// Check that a block larger than anything allocated previously can be
+		// obtained. The whole heap can't be allocated as a single block, as
+		// requests are rounded up to the next size class.
+		if (!pass) {
+			size_t size = (usage.total - usage.heap) / 2;
+			void   *ptr = psx_malloc(size);
+
+			if (!ptr)
+				_fail("unable to allocate %zu bytes after freeing everything\n", size);
+
+			psx_free(ptr);
+		}
+	}
+
+	free(heap);
+
+	if (_failures) {
+		printf("%d failure(s)\n", _failures);
+		return 1;
+	}
+
+	printf("all tests passed\n");
+	return 0;
+}
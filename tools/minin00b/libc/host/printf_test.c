@@ -0,0 +1,158 @@
+/*
+ * PSn00bSDK standard library (string formatting conformance test)
+ * (C) 2022-2023 spicyjpeg - MPL licensed
+ *
+ * Formats a fixed set of cases followed by randomly generated directives with
+ * both vsnprintf() implementations and compares the output strings and return
+ * values. Only conversions whose behavior is fully specified by the C standard
+ * are generated (no %p, %@ or %f). The l modifier is not tested as longs are 64
+ * bits wide on most hosts but 32 bits on the PS1. Random buffer sizes are used
+ * to check truncation.
+ */
+
+#include <stdint.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BUFFER_LENGTH	256
+
+int psx_vsnprintf(char *string, unsigned int size, const char *fmt, va_list ap);
+
+/* Helpers */
+
+static int _failures = 0;
+
+static void _check(unsigned int size, const char *fmt, ...) {
+	char    expected[BUFFER_LENGTH], actual[BUFFER_LENGTH];
+	va_list ap;
+
+	memset(expected, 0x55, sizeof(expected));
+	memset(actual,   0x55, sizeof(actual));
+
+	va_start(ap, fmt);
+	int expected_length = vsnprintf(expected, size, fmt, ap);
+	va_end(ap);
+	va_start(ap, fmt);
+	int actual_length = psx_vsnprintf(actual, size, fmt, ap);
+	va_end(ap);
+
+	// Bytes past the end of the buffer must be left untouched.
+	if (
+		(expected_length == actual_length) &&
+		!memcmp(expected, actual, sizeof(actual))
+	)
+		return;
+
+	if (_failures++ < 20)
+		printf(
+			"FAIL: \"%s\" (size %u): expected \"%s\" (%d), got \"%s\" (%d)\n",
+			fmt, size, expected, expected_length, actual, actual_length
+		);
+}
+
+static uint32_t _random_value(void) {
+	uint32_t value = ((uint32_t) rand() << 16) ^ (uint32_t) rand();
+
+	// Bias towards short numbers and edge cases.
+	switch (rand() % 6) {
+		case 0:
+			return value % 10;
+		case 1:
+			return value % 1000;
+		case 2:
+			return (rand() & 1) ? 0x80000000 : 0x7fffffff;
+		case 3:
+			return -(value % 1000);
+		default:
+			return value;
+	}
+}
+
+static void _random_directive(char *fmt, char *conversion) {
+	static const char conversions[] = "diuxXoc";
+	static const char *sizes[]      = { "", "", "hh", "h" };
+
+	*(fmt++) = '%';
+
+	for (int i = rand() % 3; i; i--)
+		*(fmt++) = "-0+ #"[rand() % 5];
+
+	if (rand() % 2)
+		fmt += sprintf(fmt, "%d", rand() % 16);
+	if (rand() % 3 == 0)
+		fmt += sprintf(fmt, ".%d", rand() % 12);
+
+	*conversion = conversions[rand() % (sizeof(conversions) - 1)];
+
+	if (*conversion != 'c')
+		fmt += sprintf(fmt, "%s", sizes[rand() % 4]);
+
+	*(fmt++) = *conversion;
+	*fmt     = 0;
+}
+
+/* Main */
+
+int main(int argc, char **argv) {
+	int iterations = 10000;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-n") && (i + 1 < argc))
+			iterations = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-s") && (i + 1 < argc))
+			srand(atoi(argv[++i]));
+	}
+
+	_check(BUFFER_LENGTH, "plain text");
+	_check(BUFFER_LENGTH, "%d %i %u", 0, -1, 4294967295u);
+	_check(BUFFER_LENGTH, "%d %d", (int) 0x80000000, 0x7fffffff);
+	_check(BUFFER_LENGTH, "[%5d] [%-5d] [%05d] [%+d] [% d]", 42, 42, -42, 42, 42);
+	_check(BUFFER_LENGTH, "[%.3d] [%8.3d] [%-8.3d] [%08.3d]", 7, -7, 7, 7);
+	_check(BUFFER_LENGTH, "[%.0d] [%.0x] [%#.0o] [%5.0u]", 0, 0, 0, 0);
+	_check(BUFFER_LENGTH, "%x %X %#x %#X %#x", 0xdeadbeef, 0xdeadbeef, 255, 255, 0);
+	_check(BUFFER_LENGTH, "[%#010x] [%#-10x] [%#o] [%#o]", 0x1234, 0x1234, 8, 0);
+	_check(BUFFER_LENGTH, "%hhd %hhu %hd %hu", 0x1ff, 0x1ff, 0x1ffff, 0x1ffff);
+	_check(BUFFER_LENGTH, "[%c] [%3c] [%-3c]", 'a', 'b', 'c');
+	_check(BUFFER_LENGTH, "[%s] [%10s] [%-10s] [%.2s] [%5.1s]", "abc", "abc", "abc", "abc", "abc");
+	_check(BUFFER_LENGTH, "[%*d] [%-*d] [%.*d] [%*d]", 5, 1, 5, 1, 3, 1, -5, 1);
+	_check(BUFFER_LENGTH, "100%% %d%%", 5);
+	_check(BUFFER_LENGTH, "%s", "");
+	_check(1, "truncated");
+	_check(4, "%d", 123456);
+	_check(8, "abc%sdef", "0123456789");
+
+	for (int i = 0; i < iterations; i++) {
+		char fmt[64], conversion;
+		int  length = 0;
+
+		// Each format string holds some text and up to three directives.
+		int count = 1 + rand() % 3;
+		uint32_t values[3];
+
+		for (int j = 0; j < count; j++) {
+			length += sprintf(&fmt[length], "%.*s", rand() % 4, "ab ");
+			_random_directive(&fmt[length], &conversion);
+			length += strlen(&fmt[length]);
+
+			values[j] = _random_value();
+
+			// Only pass printable characters to %c to keep the output readable.
+			if (conversion == 'c')
+				values[j] = ' ' + (values[j] % 95);
+		}
+
+		unsigned int size = (rand() % 4) ? BUFFER_LENGTH : (1 + rand() % 32);
+
+		_check(size, fmt, values[0], values[1], values[2]);
+	}
+
+	if (_failures) {
+		printf("%d failure(s)\n", _failures);
+		return 1;
+	}
+
+	printf("all tests passed\n");
+	return 0;
+}
@@ -0,0 +1,124 @@
+/*
+ * PSn00bSDK standard library (string function fuzzing test)
+ * (C) 2022-2023 spicyjpeg - MPL licensed
+ *
+ * Compares strlen(), strchr(), strrchr(), strcmp(), strncmp() and strstr()
+ * against the host's libc on random strings placed at random alignments. The
+ * strings are drawn from a small alphabet so that partial matches, repeated
+ * characters and common prefixes are frequent. The SDK's functions are renamed
+ * with a psx_ prefix when building (see Makefile).
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_LENGTH	96
+
+size_t psx_strlen(const char *str);
+char *psx_strchr(const char *str, int ch);
+char *psx_strrchr(const char *str, int ch);
+int psx_strcmp(const char *lhs, const char *rhs);
+int psx_strncmp(const char *lhs, const char *rhs, size_t count);
+char *psx_strstr(const char *str, const char *substr);
+
+// Dependencies of string.c, which would otherwise be provided by other parts
+// of the SDK.
+void *psx_memset(void *dest, int ch, size_t count) {
+	return memset(dest, ch, count);
+}
+
+void *psx__malloc_fallback(size_t size) {
+	return malloc(size);
+}
+
+/* Helpers */
+
+static int _failures = 0;
+
+#define _fail(...) \
+	if (_failures++ < 20) \
+		printf("FAIL: " __VA_ARGS__)
+
+static int _sign(int value) {
+	return (value > 0) - (value < 0);
+}
+
+// Fills the buffer with a random string at a random offset and returns it.
+static char *_random_string(char *buffer, int max_length, const char *alphabet) {
+	char *str    = &buffer[rand() % 4];
+	int  length  = rand() % (max_length + 1);
+	int  letters = strlen(alphabet);
+
+	for (int i = 0; i < length; i++)
+		str[i] = alphabet[rand() % letters];
+
+	str[length] = 0;
+	return str;
+}
+
+/* Main */
+
+int main(int argc, char **argv) {
+	int iterations = 10000;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-n") && (i + 1 < argc))
+			iterations = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-s") && (i + 1 < argc))
+			srand(atoi(argv[++i]));
+	}
+
+	// Characters above 0x7f are included to check that bytes are compared as
+	// unsigned values.
+	static const char *alphabets[] = { "ab", "abc\x80", "abcdefghij\xff" };
+
+	for (int i = 0; i < iterations; i++) {
+		char lhs_buffer[MAX_LENGTH + 8], rhs_buffer[MAX_LENGTH + 8];
+
+		const char *alphabet = alphabets[rand() % 3];
+		char       *lhs      = _random_string(lhs_buffer, MAX_LENGTH, alphabet);
+		char       *rhs;
+
+		// Make the second string share a prefix with the first one half of the
+		// time, so that strcmp() and strncmp() get past the first few bytes.
+		if (rand() % 2) {
+			rhs = &rhs_buffer[rand() % 4];
+			strcpy(rhs, lhs);
+
+			int length = strlen(rhs);
+			if (length && (rand() % 2))
+				rhs[rand() % length] = alphabet[rand() % strlen(alphabet)];
+			if (length && (rand() % 4 == 0))
+				rhs[rand() % length] = 0;
+		} else {
+			rhs = _random_string(rhs_buffer, (rand() % 2) ? 4 : MAX_LENGTH, alphabet);
+		}
+
+		int ch    = (rand() % 8) ? alphabet[rand() % strlen(alphabet)] : 0;
+		int count = rand() % (MAX_LENGTH + 8);
+
+		if (psx_strlen(lhs) != strlen(lhs))
+			_fail("strlen(\"%s\")\n", lhs);
+		if (psx_strchr(lhs, ch) != strchr(lhs, ch))
+			_fail("strchr(\"%s\", 0x%02x)\n", lhs, ch & 0xff);
+		if (psx_strrchr(lhs, ch) != strrchr(lhs, ch))
+			_fail("strrchr(\"%s\", 0x%02x)\n", lhs, ch & 0xff);
+		if (_sign(psx_strcmp(lhs, rhs)) != _sign(strcmp(lhs, rhs)))
+			_fail("strcmp(\"%s\", \"%s\")\n", lhs, rhs);
+		if (_sign(psx_strncmp(lhs, rhs, count)) != _sign(strncmp(lhs, rhs, count)))
+			_fail("strncmp(\"%s\", \"%s\", %d)\n", lhs, rhs, count);
+		if (psx_strstr(lhs, rhs) != strstr(lhs, rhs))
+			_fail("strstr(\"%s\", \"%s\")\n", lhs, rhs);
+	}
+
+	if (_failures) {
+		printf("%d failure(s)\n", _failures);
+		return 1;
+	}
+
+	printf("all tests passed\n");
+	return 0;
+}
@@ -0,0 +1,525 @@
+/*
+ * PSn00bSDK standard library (dynamic memory allocator)
+ * (C) 2022-2023 spicyjpeg - MPL licensed
+ *
+ * This is a TLSF (two-level segregated fit) allocator: free blocks are sorted
+ * into lists by size class, where the first level splits sizes by powers of two
+ * and the second level further divides each power of two into 16 linear
+ * ranges. Two bitmaps track which lists are non-empty, so finding a suitable
+ * block, splitting it and merging it back with its neighbors on free() all take
+ * constant time regardless of how fragmented the heap is.
+ *
+ * Mods do not own the memory past their own code and data, so the heap is not
+ * set up automatically: InitHeap() must be called with the amount of RAM that
+ * can be used, starting by default at the __heap_base symbol defined by the
+ * linker script. Small allocations of a fixed size can optionally be served
+ * from pools (see AddHeapPool()), which are carved out of the heap and avoid
+ * per-block headers and fragmentation.
+ *
+ * strdup(), strndup() and FntOpen() used to allocate from the kernel heap, so
+ * they keep doing so through _malloc_fallback() until InitHeap() is called,
+ * and free() hands any block outside of the heap back to the kernel. Such
+ * blocks cannot be passed to realloc().
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <psxapi.h>
+
+#define ALIGN_LOG2		3
+#define SL_INDEX_LOG2	4
+#define FL_INDEX_MAX	21
+
+#define ALIGN			(1 << ALIGN_LOG2)
+#define SL_INDEX_COUNT	(1 << SL_INDEX_LOG2)
+#define FL_INDEX_SHIFT	(SL_INDEX_LOG2 + ALIGN_LOG2)
+#define FL_INDEX_COUNT	(FL_INDEX_MAX - FL_INDEX_SHIFT + 1)
+#define SMALL_BLOCK_SIZE	(1 << FL_INDEX_SHIFT)
+
+#define MAX_HEAP_POOLS	4
+
+/* Private types */
+
+// Each block is preceded by a header holding a pointer to the physically
+// previous block and the size of the block's payload, whose lowest bit is set
+// if the block is free. Free blocks also store the links for their free list in
+// the first 8 bytes of their payload.
+typedef struct _Block {
+	struct _Block	*prev_phys;
+	size_t			size;
+	struct _Block	*next_free, *prev_free;
+} Block;
+
+typedef struct {
+	void		*start, *end, *next_free;
+	size_t		block_size;
+} Pool;
+
+#define BLOCK_HEADER_SIZE	offsetof(Block, next_free)
+#define MIN_BLOCK_SIZE		(sizeof(Block) - BLOCK_HEADER_SIZE)
+#define MAX_BLOCK_SIZE		((1 << FL_INDEX_MAX) - ALIGN)
+
+#define BLOCK_FREE			1
+
+/* Internal globals */
+
+// The weak reference allows linking programs that do not define __heap_base,
+// as long as they pass an address to InitHeap().
+extern uint8_t __heap_base[] __attribute__((weak));
+
+static uint32_t	_fl_bitmap = 0;
+static uint16_t	_sl_bitmap[FL_INDEX_COUNT];
+static Block	*_free_lists[FL_INDEX_COUNT][SL_INDEX_COUNT];
+
+static Pool		_pools[MAX_HEAP_POOLS];
+static int		_num_pools = 0;
+
+// _heap_free is the total size of all blocks in the free lists.
+static size_t		_heap_size  = 0;
+static size_t		_heap_free  = 0;
+static size_t		_alloc      = 0;
+static size_t		_alloc_max  = 0;
+
+// Bounds of the heap, used by free() to tell blocks allocated from the kernel
+// by _malloc_fallback() apart.
+static uintptr_t	_heap_start = 0;
+static uintptr_t	_heap_end   = 0;
+
+/* Private utilities */
+
+// __builtin_clz() is implemented using the GTE's leading zero counter (see
+// clz.s), so these are cheap.
+static inline int _fls(uint32_t value) {
+	return 31 - __builtin_clz(value);
+}
+
+static inline int _ffs(uint32_t value) {
+	return _fls(value & -value);
+}
+
+static inline size_t _block_size(const Block *block) {
+	return block->size & ~BLOCK_FREE;
+}
+
+static inline void *_block_to_ptr(Block *block) {
+	return (void *) ((uint8_t *) block + BLOCK_HEADER_SIZE);
+}
+
+static inline Block *_ptr_to_block(void *ptr) {
+	return (Block *) ((uint8_t *) ptr - BLOCK_HEADER_SIZE);
+}
+
+static inline Block *_next_phys(Block *block) {
+	return (Block *) ((uint8_t *) block + BLOCK_HEADER_SIZE + _block_size(block));
+}
+
+static void _mapping(size_t size, int *fl, int *sl) {
+	if (size < SMALL_BLOCK_SIZE) {
+		*fl = 0;
+		*sl = size / (SMALL_BLOCK_SIZE / SL_INDEX_COUNT);
+	} else {
+		int _fl = _fls(size);
+
+		*sl = (size >> (_fl - SL_INDEX_LOG2)) ^ SL_INDEX_COUNT;
+		*fl = _fl - (FL_INDEX_SHIFT - 1);
+	}
+}
+
+static void _insert_free(Block *block) {
+	int fl, sl;
+	_mapping(_block_size(block), &fl, &sl);
+
+	Block *head = _free_lists[fl][sl];
+
+	block->size     |= BLOCK_FREE;
+	block->next_free = head;
+	block->prev_free = 0;
+
+	if (head)
+		head->prev_free = block;
+
+	_free_lists[fl][sl] = block;
+	_fl_bitmap         |= 1 << fl;
+	_sl_bitmap[fl]     |= 1 << sl;
+	_heap_free         += _block_size(block);
+}
+
+static void _remove_free(Block *block) {
+	int fl, sl;
+	_mapping(_block_size(block), &fl, &sl);
+
+	Block *next = block->next_free;
+	Block *prev = block->prev_free;
+
+	if (next)
+		next->prev_free = prev;
+	if (prev)
+		prev->next_free = next;
+
+	if (_free_lists[fl][sl] == block) {
+		_free_lists[fl][sl] = next;
+
+		if (!next) {
+			_sl_bitmap[fl] &= ~(1 << sl);
+
+			if (!_sl_bitmap[fl])
+				_fl_bitmap &= ~(1 << fl);
+		}
+	}
+
+	block->size &= ~BLOCK_FREE;
+	_heap_free  -= _block_size(block);
+}
+
+// Returns a free block of at least the given size, taking it out of its list.
+static Block *_find_free(size_t size) {
+	int fl, sl;
+
+	// Round the size up to the next size class, so that any block in the list
+	// found is large enough.
+	if (size >= SMALL_BLOCK_SIZE)
+		size += (1 << (_fls(size) - SL_INDEX_LOG2)) - 1;
+
+	_mapping(size, &fl, &sl);
+
+	if (fl >= FL_INDEX_COUNT)
+		return 0;
+
+	uint32_t sl_map = _sl_bitmap[fl] & (~0u << sl);
+
+	if (!sl_map) {
+		uint32_t fl_map = _fl_bitmap & (~0u << (fl + 1));
+
+		if (!fl_map)
+			return 0;
+
+		fl     = _ffs(fl_map);
+		sl_map = _sl_bitmap[fl];
+	}
+
+	Block *block = _free_lists[fl][_ffs(sl_map)];
+
+	_remove_free(block);
+	return block;
+}
+
+// Shrinks a used block to the given size, returning the remainder to the free
+// lists (merged with the next block if possible) if it's large enough to hold
+// another block.
+static void _trim(Block *block, size_t size) {
+	size_t block_size = _block_size(block);
+
+	if (block_size < (size + BLOCK_HEADER_SIZE + MIN_BLOCK_SIZE))
+		return;
+
+	Block *rest     = (Block *) ((uint8_t *) _block_to_ptr(block) + size);
+	rest->prev_phys = block;
+	rest->size      = block_size - size - BLOCK_HEADER_SIZE;
+	block->size     = size;
+
+	Block *next = _next_phys(rest);
+
+	if (next->size & BLOCK_FREE) {
+		_remove_free(next);
+		rest->size += BLOCK_HEADER_SIZE + _block_size(next);
+		next        = _next_phys(rest);
+	}
+
+	next->prev_phys = rest;
+	_insert_free(rest);
+}
+
+static size_t _adjust_size(size_t size) {
+	if (size > MAX_BLOCK_SIZE)
+		return 0;
+	if (size < MIN_BLOCK_SIZE)
+		return MIN_BLOCK_SIZE;
+
+	return (size + ALIGN - 1) & ~(ALIGN - 1);
+}
+
+static Block *_alloc_block(size_t size) {
+	size = _adjust_size(size);
+
+	if (!size)
+		return 0;
+
+	Block *block = _find_free(size);
+
+	if (!block) {
+		_sdk_log("unable to allocate %d bytes\n", size);
+		return 0;
+	}
+
+	_trim(block, size);
+	return block;
+}
+
+static void _track_alloc(ptrdiff_t size) {
+	_alloc += size;
+
+	if (_alloc > _alloc_max)
+		_alloc_max = _alloc;
+}
+
+static Pool *_find_pool(void *ptr) {
+	for (int i = 0; i < _num_pools; i++) {
+		Pool *pool = &_pools[i];
+
+		if ((ptr >= pool->start) && (ptr < pool->end))
+			return pool;
+	}
+
+	return 0;
+}
+
+/* Public API */
+
+void InitHeap(void *addr, size_t size) {
+	if (!addr)
+		addr = __heap_base;
+
+	// Align the start and end of the heap, then leave room for the first
+	// block's header and for an empty, permanently used block at the end which
+	// stops merging past the end of the heap.
+	uintptr_t start = ((uintptr_t) addr + ALIGN - 1) & ~(ALIGN - 1);
+	uintptr_t end   = ((uintptr_t) addr + size) & ~(ALIGN - 1);
+
+	_fl_bitmap  = 0;
+	_num_pools  = 0;
+	_heap_size  = 0;
+	_heap_start = 0;
+	_heap_end   = 0;
+	_heap_free  = 0;
+	_alloc      = 0;
+	_alloc_max  = 0;
+
+	memset(_sl_bitmap, 0, sizeof(_sl_bitmap));
+	memset(_free_lists, 0, sizeof(_free_lists));
+
+	if (!addr || (end < (start + BLOCK_HEADER_SIZE * 2 + MIN_BLOCK_SIZE))) {
+		_sdk_log("invalid heap area (%08x, %d bytes)\n", addr, size);
+		return;
+	}
+
+	size = end - start - BLOCK_HEADER_SIZE * 2;
+
+	if (size > MAX_BLOCK_SIZE)
+		size = MAX_BLOCK_SIZE;
+
+	Block *block     = (Block *) start;
+	block->prev_phys = 0;
+	block->size      = size;
+
+	Block *last      = _next_phys(block);
+	last->prev_phys  = block;
+	last->size       = 0;
+
+	_insert_free(block);
+	_heap_size  = size + BLOCK_HEADER_SIZE * 2;
+	_heap_start = start;
+	_heap_end   = start + _heap_size;
+}
+
+int AddHeapPool(size_t block_size, int count) {
+	_sdk_validate_args(block_size && (count > 0), -1);
+
+	if (_num_pools >= MAX_HEAP_POOLS) {
+		_sdk_log("too many pools\n");
+		return -1;
+	}
+
+	// Blocks in a pool have no header; free blocks are linked through their
+	// first word.
+	block_size = (block_size + ALIGN - 1) & ~(ALIGN - 1);
+
+	Block *block = _alloc_block(block_size * count);
+
+	if (!block)
+		return -1;
+
+	uint8_t *data = _block_to_ptr(block);
+
+	// Keep the pools sorted by block size, so that malloc() picks the smallest
+	// one able to satisfy a request.
+	int index = _num_pools++;
+
+	for (; index && (_pools[index - 1].block_size > block_size); index--)
+		_pools[index] = _pools[index - 1];
+
+	Pool *pool       = &_pools[index];
+	pool->start      = data;
+	pool->end        = data + block_size * count;
+	pool->next_free  = data;
+	pool->block_size = block_size;
+
+	for (int i = count - 1; i; i--, data += block_size)
+		*((void **) data) = data + block_size;
+
+	*((void **) data) = 0;
+	return 0;
+}
+
+void GetHeapUsage(HeapUsage *usage) {
+	usage->total     = _heap_size;
+	usage->heap      = _heap_size - _heap_free;
+	usage->stack     = 0;
+	usage->alloc     = _alloc;
+	usage->alloc_max = _alloc_max;
+}
+
+void *malloc(size_t size) {
+	if (!size)
+		return 0;
+
+	// Try the pools first. If the matching pool is exhausted, fall back to a
+	// larger pool or to the heap.
+	for (int i = 0; i < _num_pools; i++) {
+		Pool *pool = &_pools[i];
+
+		if ((size > pool->block_size) || !pool->next_free)
+			continue;
+
+		void *ptr       = pool->next_free;
+		pool->next_free = *((void **) ptr);
+
+		_track_alloc(pool->block_size);
+		return ptr;
+	}
+
+	Block *block = _alloc_block(size);
+
+	if (!block)
+		return 0;
+
+	_track_alloc(_block_size(block));
+	return _block_to_ptr(block);
+}
+
+void *calloc(size_t num, size_t size) {
+	size_t total = num * size;
+
+	if (size && ((total / size) != num))
+		return 0;
+
+	void *ptr = malloc(total);
+
+	if (ptr)
+		memset(ptr, 0, total);
+
+	return ptr;
+}
+
+void *realloc(void *ptr, size_t size) {
+	if (!ptr)
+		return malloc(size);
+	if (!size) {
+		free(ptr);
+		return 0;
+	}
+
+	Pool   *pool = _find_pool(ptr);
+	Block  *block;
+	size_t old_size;
+
+	if (pool) {
+		old_size = pool->block_size;
+
+		if (size <= old_size)
+			return ptr;
+	} else {
+		size_t adjusted = _adjust_size(size);
+
+		if (!adjusted)
+			return 0;
+
+		block    = _ptr_to_block(ptr);
+		old_size = _block_size(block);
+
+		// Grow the block in place if the next one is free and large enough,
+		// then give back any excess space.
+		Block *next = _next_phys(block);
+
+		if (
+			(adjusted > old_size) && (next->size & BLOCK_FREE) &&
+			((old_size + BLOCK_HEADER_SIZE + _block_size(next)) >= adjusted)
+		) {
+			_remove_free(next);
+			block->size += BLOCK_HEADER_SIZE + _block_size(next);
+
+			_next_phys(block)->prev_phys = block;
+		}
+
+		if (adjusted <= _block_size(block)) {
+			_trim(block, adjusted);
+			_track_alloc(_block_size(block) - old_size);
+			return ptr;
+		}
+	}
+
+	void *new_ptr = malloc(size);
+
+	if (!new_ptr)
+		return 0;
+
+	memcpy(new_ptr, ptr, old_size);
+	free(ptr);
+	return new_ptr;
+}
+
+void *_malloc_fallback(size_t size) {
+	if (_heap_size)
+		return malloc(size);
+
+	_sdk_log("heap not initialized, allocating %d bytes from the kernel\n", (int) size);
+	return alloc_kernel_memory(size);
+}
+
+void free(void *ptr) {
+	if (!ptr)
+		return;
+
+	if (((uintptr_t) ptr < _heap_start) || ((uintptr_t) ptr >= _heap_end)) {
+		free_kernel_memory(ptr);
+		return;
+	}
+
+	Pool *pool = _find_pool(ptr);
+
+	if (pool) {
+		*((void **) ptr) = pool->next_free;
+		pool->next_free  = ptr;
+
+		_track_alloc(-(ptrdiff_t) pool->block_size);
+		return;
+	}
+
+	Block *block = _ptr_to_block(ptr);
+
+	if (block->size & BLOCK_FREE) {
+		_sdk_log("double free of %08x\n", ptr);
+		return;
+	}
+
+	_track_alloc(-(ptrdiff_t) _block_size(block));
+
+	// Merge the block with its neighbors if they are free.
+	Block *prev = block->prev_phys;
+	Block *next = _next_phys(block);
+
+	if (prev && (prev->size & BLOCK_FREE)) {
+		_remove_free(prev);
+		prev->size += BLOCK_HEADER_SIZE + _block_size(block);
+		block       = prev;
+	}
+	if (next->size & BLOCK_FREE) {
+		_remove_free(next);
+		block->size += BLOCK_HEADER_SIZE + _block_size(next);
+	}
+
+	_next_phys(block)->prev_phys = block;
+	_insert_free(block);
+}
@@ -7,12 +7,22 @@
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
-#include <psxapi.h>
 
 // Uncomment to enable strtod(), strtold() and strtof(). Note that these
 // functions use extremely slow software floats.
 //#define ALLOW_FLOAT
 
+// The string functions below process 4 bytes at a time once the pointer is
+// word-aligned. A word contains a null byte iff _has_zero() is nonzero (the
+// lowest null byte is always flagged correctly, higher ones may not be).
+// Reading a few bytes past the terminator is harmless as aligned word reads
+// can never cross into unmapped memory.
+#define ONES_MASK	0x01010101
+#define HIGHS_MASK	0x80808080
+
+#define _has_zero(word)	(((word) - ONES_MASK) & ~(word) & HIGHS_MASK)
+#define _is_aligned(ptr)	(!(((uintptr_t) (ptr)) & 3))
+
 /* Character manipulation */
 
 int isprint(int ch) {
@@ -163,21 +173,59 @@ char *strncpy(char *restrict dest, const char *restrict src, size_t count) {
 }
 
 int strcmp(const char *lhs, const char *rhs) {
-	for (;;) {
-		char a = *(lhs++), b = *(rhs++);
+	// Compare whole words as long as both strings are equally aligned, then
+	// find the exact mismatch or terminator byte by byte.
+	if (!((((uintptr_t) lhs) ^ ((uintptr_t) rhs)) & 3)) {
+		for (; !_is_aligned(lhs); lhs++, rhs++) {
+			if ((*lhs != *rhs) || !*lhs)
+				goto _compare_bytes;
+		}
 
-		if (a != b)
+		const uint32_t *_lhs = (const uint32_t *) lhs;
+		const uint32_t *_rhs = (const uint32_t *) rhs;
+
+		while ((*_lhs == *_rhs) && !_has_zero(*_lhs)) {
+			_lhs++;
+			_rhs++;
+		}
+
+		lhs = (const char *) _lhs;
+		rhs = (const char *) _rhs;
+	}
+
+_compare_bytes:
+	for (;; lhs++, rhs++) {
+		uint8_t a = *lhs, b = *rhs;
+
+		if ((a != b) || !a)
 			return a - b;
-		if (!a && !b)
-			return 0;
 	}
 }
 
 int strncmp(const char *lhs, const char *rhs, size_t count) {
-	for (; count && *lhs && *rhs; count--) {
-		char a = *(lhs++), b = *(rhs++);
+	if (!((((uintptr_t) lhs) ^ ((uintptr_t) rhs)) & 3)) {
+		for (; count && !_is_aligned(lhs); count--, lhs++, rhs++) {
+			if ((*lhs != *rhs) || !*lhs)
+				goto _compare_bytes;
+		}
 
-		if (a != b)
+		const uint32_t *_lhs = (const uint32_t *) lhs;
+		const uint32_t *_rhs = (const uint32_t *) rhs;
+
+		for (; (count >= 4) && (*_lhs == *_rhs) && !_has_zero(*_lhs); count -= 4) {
+			_lhs++;
+			_rhs++;
+		}
+
+		lhs = (const char *) _lhs;
+		rhs = (const char *) _rhs;
+	}
+
+_compare_bytes:
+	for (; count; count--, lhs++, rhs++) {
+		uint8_t a = *lhs, b = *rhs;
+
+		if ((a != b) || !a)
 			return a - b;
 	}
 
@@ -185,24 +233,63 @@ int strncmp(const char *lhs, const char *rhs, size_t count) {
 }
 
 char *strchr(const char *str, int ch) {
-	for (; *str; str++) {
+	ch = (char) ch;
+
+	for (; !_is_aligned(str); str++) {
 		if (*str == ch)
 			return (char *) str;
+		if (!*str)
+			return 0;
 	}
 
-	return 0;
+	// Skip words that contain neither the character nor the terminator.
+	const uint32_t *_str = (const uint32_t *) str;
+	uint32_t       mask  = ONES_MASK * (uint8_t) ch;
+
+	for (;; _str++) {
+		uint32_t word = *_str;
+
+		if (_has_zero(word) || _has_zero(word ^ mask))
+			break;
+	}
+
+	for (str = (const char *) _str;; str++) {
+		if (*str == ch)
+			return (char *) str;
+		if (!*str)
+			return 0;
+	}
 }
 
 char *strrchr(const char *str, int ch) {
-	size_t length = strlen(str);
+	const char *last = 0;
+
+	ch = (char) ch;
 
-	for (str += length; length; length--) {
-		str--;
+	// Single pass: words without the character are skipped, words that
+	// contain it are scanned for the last occurrence before the terminator.
+	for (; !_is_aligned(str); str++) {
 		if (*str == ch)
-			return (char *) str;
+			last = str;
+		if (!*str)
+			return (char *) last;
 	}
 
-	return 0;
+	const uint32_t *_str = (const uint32_t *) str;
+	uint32_t       mask  = ONES_MASK * (uint8_t) ch;
+
+	for (;; _str++) {
+		uint32_t word = *_str;
+
+		if (_has_zero(word) || _has_zero(word ^ mask)) {
+			for (str = (const char *) _str; str < (const char *) &_str[1]; str++) {
+				if (*str == ch)
+					last = str;
+				if (!*str)
+					return (char *) last;
+			}
+		}
+	}
 }
 
 char *strpbrk(const char *str, const char *breakset) {
@@ -223,22 +310,56 @@ char *strstr(const char *str, const char *substr) {
 
 	if (!length)
 		return (char *) str;
+	if (length == 1)
+		return strchr(str, *substr);
 
-	for (; *str; str++) {
-		if (!memcmp(str, substr, length))
+	// Boyer-Moore-Horspool search. Shifts are stored as bytes to keep the
+	// table small, which only limits the skip distance for long substrings.
+	size_t str_length = strlen(str);
+
+	if (str_length < length)
+		return 0;
+
+	uint8_t shifts[256];
+	size_t  max_shift = (length < 255) ? length : 255;
+
+	memset(shifts, max_shift, sizeof(shifts));
+
+	for (size_t i = length - max_shift; i < (length - 1); i++)
+		shifts[(uint8_t) substr[i]] = length - 1 - i;
+
+	const char *end  = &str[str_length - length];
+	uint8_t    last  = substr[length - 1];
+
+	while (str <= end) {
+		uint8_t ch = str[length - 1];
+
+		if ((ch == last) && !memcmp(str, substr, length - 1))
 			return (char *) str;
+
+		str += shifts[ch];
 	}
 
 	return 0;
 }
 
 size_t strlen(const char *str) {
-	size_t length = 0;
+	const char *start = str;
 
-	for (; *str; str++)
-		length++;
+	for (; !_is_aligned(str); str++) {
+		if (!*str)
+			return str - start;
+	}
 
-	return length;
+	const uint32_t *_str = (const uint32_t *) str;
+
+	while (!_has_zero(*_str))
+		_str++;
+
+	for (str = (const char *) _str; *str; str++)
+		;
+
+	return str - start;
 }
 
 // Non-standard, used internally
@@ -273,7 +394,7 @@ char *strncat(char *restrict dest, const char *restrict src, size_t count) {
 
 char *strdup(const char *str) {
 	size_t length = strlen(str) + 1;
-	char   *copy  = alloc_kernel_memory(length);
+	char   *copy  = _malloc_fallback(length);
 
 	if (!copy)
 		return 0;
@@ -283,13 +404,14 @@ char *strdup(const char *str) {
 }
 
 char *strndup(const char *str, size_t count) {
-	size_t length = strnlen(str, count) + 1;
-	char   *copy  = alloc_kernel_memory(length);
+	size_t length = strnlen(str, count);
+	char   *copy  = _malloc_fallback(length + 1);
 
 	if (!copy)
 		return 0;
 
 	memcpy(copy, str, length);
+	copy[length] = 0;
 	return copy;
 }
 
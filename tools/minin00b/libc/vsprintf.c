@@ -1,816 +1,495 @@
-/* printf.c
+/*
+ * PSn00bSDK standard library (string formatting)
+ * (C) 2019-2023 PSXSDK authors, Lameguy64, spicyjpeg - MPL licensed
  *
- * Inherited from the PSXSDK C library
+ * The format string is processed in a single pass and output is written
+ * directly into the destination buffer. Integers are converted two digits at a
+ * time using a lookup table and a reciprocal multiplication in place of
+ * division, as the R3000's divider takes over 30 cycles per division.
  */
 
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
 #include <stdio.h>
-#include <stdlib.h>
 #include <string.h>
-#include <stdarg.h>
 
-// Uncomment to enable support for %f.
+// Uncomment to enable support for %f. Note that this uses extremely slow
+// software floats.
 //#define ALLOW_FLOAT
 
-#define SPRINTF_ALT_FLAG			(1<<0)
-#define SPRINTF_ZERO_FLAG			(1<<1)
-#define SPRINTF_NEGFIELD_FLAG			(1<<2)
-#define SPRINTF_SPACE_FLAG			(1<<3)
-#define SPRINTF_SIGN_FLAG			(1<<4)
-
-// sprintf() macros to calculate the real padding and to write it
-// these were made to not repeat the code in the function
-// they can only be used in sprintf()
-
-// sprintf macros START
-
-#define calculate_real_padding() \
-	y = 1; \
-	\
-	for(x=0;x<=19;x++) \
-	{ \
-		if(x == 0) \
-			pad_quantity--; \
-		else \
-		{ \
-			if(arg / y) \
-				pad_quantity--; \
-		} \
-	\
-		y *= 10; \
-	} \
-	\
-	if(pad_quantity < 0) pad_quantity = 0;
-
-/*#define calculate_real_padding_hex() \
-	for (x = 0; x < 8; x++) \
-	{ \
-		if(x == 0) \
-			pad_quantity--; \
-		else \
-		{ \
-		if((arg >> (x * 4)) & 0xf) \
-			pad_quantity--; \
-		} \
-	}*/
-	
-#define calculate_real_padding_hex() \
-	last = 0; \
-	for (x = 0; x < 8; x++) \
-		if((arg >> (x * 4)) & 0xf) \
-			last = x; \
-	\
-	pad_quantity = (pad_quantity - 1) - last; \
-	if(pad_quantity < 0) pad_quantity = 0;
-
-#define calculate_real_padding_bin() \
-	last = 0; \
-	for (x = 0; x < 32; x++) \
-		if((arg >> x) & 1) \
-			last = x; \
-	\
-	pad_quantity = (pad_quantity - 1) - last; \
-	if(pad_quantity < 0) pad_quantity = 0;
-
-#define write_padding() \
-	if(!(flags & SPRINTF_NEGFIELD_FLAG)) \
-		for(x = 0; x < pad_quantity; x++) \
-		{ \
-			if(flags & SPRINTF_ZERO_FLAG) \
-					put_in_string(string, ssz, '0', string_pos++); \
-			else \
-					put_in_string(string, ssz, ' ', string_pos++); \
-		}
+#define FLAG_ALT		(1 << 0)
+#define FLAG_ZERO		(1 << 1)
+#define FLAG_LEFT		(1 << 2)
+#define FLAG_SPACE		(1 << 3)
+#define FLAG_SIGN		(1 << 4)
+#define FLAG_UPPER		(1 << 5)
+#define FLAG_PRECISION	(1 << 6)
+#define FLAG_OCTAL		(1 << 7)
+
+// Large enough for a 32-bit value in binary.
+#define NUMBER_BUFFER_LENGTH	32
+
+/* Private types */
+
+typedef enum {
+	SIZE_CHAR	= 0,
+	SIZE_SHORT	= 1,
+	SIZE_INT	= 2
+} ArgSize;
+
+typedef struct {
+	char		*string;
+	uint32_t	limit, pos;
+} Output;
+
+/* Internal globals */
+
+static const char _digit_pairs[200] =
+	"00010203040506070809" "10111213141516171819"
+	"20212223242526272829" "30313233343536373839"
+	"40414243444546474849" "50515253545556575859"
+	"60616263646566676869" "70717273747576777879"
+	"80818283848586878889" "90919293949596979899";
+
+static const char _hex_digits[2][16] = {
+	{ '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'a', 'b', 'c', 'd', 'e', 'f' },
+	{ '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' }
+};
+
+/* Private utilities */
+
+static inline void _put_char(Output *out, char ch) {
+	if (out->pos < out->limit)
+		out->string[out->pos] = ch;
+
+	out->pos++;
+}
 
-#define write_neg_padding() \
-	if(flags & SPRINTF_NEGFIELD_FLAG) \
-	{ \
-		for(x = 0; x < pad_quantity; x++) \
-			put_in_string(string, ssz, ' ', string_pos++);\
+static void _put_chars(Output *out, const char *str, uint32_t length) {
+	if (out->pos < out->limit) {
+		uint32_t space = out->limit - out->pos;
+
+		memcpy(&out->string[out->pos], str, (length < space) ? length : space);
 	}
 
-// sprintf macros END
+	out->pos += length;
+}
 
-enum
-{
-	SPRINTF_SIZE_CHAR,
-	SPRINTF_SIZE_SHORT,
-	SPRINTF_SIZE_INT,
-	SPRINTF_SIZE_LONG,
-	SPRINTF_SIZE_LONG_LONG,
-};
+static void _put_fill(Output *out, char ch, int count) {
+	for (; count > 0; count--)
+		_put_char(out, ch);
+}
 
-unsigned int get_arg_in_size(int size, unsigned long *arg, unsigned int check_sign)
-{
-	int s = 0;
-
-	switch(size)
-	{
-		case SPRINTF_SIZE_CHAR:
-			*arg &= 0xff;
-			
-			if(check_sign)
-			{
-				if(*arg & (1<<7))
-				{
-					*arg |= 0xffffff00;
-					*arg = ~(*arg - 1);
-					s = 1;
-				}
-			}
-		break;
-		case SPRINTF_SIZE_SHORT:
-			*arg &= 0xffff;
-			
-			if(check_sign)
-			{
-				if(*arg & (1<<15))
-				{
-					*arg |= 0xffff0000;
-					*arg = ~(*arg - 1);
-					s = 1;
-				}
-			}
-		break;
+// x / 100 for any 32-bit x, computed as (x * ceil(2^37 / 100)) >> 37. The
+// compiler turns the 64-bit product into a single multu instruction.
+static inline uint32_t _div100(uint32_t value) {
+	return (uint32_t) (((uint64_t) value * 0x51eb851f) >> 37);
+}
 
-// sizeof(long) == sizeof(int) on 32bit, so this will suffice for the psx
+// Writes the digits of value right-aligned into the end of the buffer and
+// returns a pointer to the first one.
+static char *_format_decimal(char *end, uint32_t value) {
+	while (value >= 100) {
+		uint32_t quotient = _div100(value);
+		const char *pair  = &_digit_pairs[(value - quotient * 100) * 2];
+		value             = quotient;
 
-		case SPRINTF_SIZE_INT:
-		case SPRINTF_SIZE_LONG:
-			*arg &= 0xffffffff;
+		*(--end) = pair[1];
+		*(--end) = pair[0];
+	}
 
-			if(check_sign)
-			{
-				if(*arg & (1<<31))
-				{
-					//*arg |= (long long)0xffffffff00000000;
-					*arg = ~(*arg - 1);
-					s = 1;
-				}
-			}
-		break;
-
-		/*case SPRINTF_SIZE_LONG_LONG:
-			if(check_sign)
-			{
-				if(*arg & ((long long)1<<63))
-				{
-					*arg = ~(*arg - 1);
-					s = 1;
-				}
-			}
-		break;*/
+	if (value >= 10) {
+		*(--end) = _digit_pairs[value * 2 + 1];
+		*(--end) = _digit_pairs[value * 2];
+	} else {
+		*(--end) = '0' + value;
 	}
-	
-	return s;
-}	
-
-int put_in_string(char *string, unsigned int sz, char c, int pos)
-{
-	if(pos>=sz)
-		return 0;
-	else
-		string[pos] = c;
-		
-	return 1;
+
+	return end;
 }
 
-int libc_ulltoa(unsigned long i, char *dst, int n)
-{
-	int x, y;
-	unsigned long a, b;
-	int empty_digit = 1;
-	int sp=0;
-	int n2=0;
-
-	for(x=20;x>=0;x--)
-	{
-		a = 1;
-		for(y = 0; y<x; y++)
-			a *= 10;
-
-		b = (i/a);
-					
-		if(b>=1)
-			empty_digit = 0;
-						
-		if(empty_digit == 0 || x == 0)
-		{	
-			i -= b*a;
-						
-			//put_in_string(string, ssz, b + '0', string_pos++);
-			if(n2!=n)
-			{
-				//printf("n2=%d\n",n2);
-				dst[sp++] = b + '0';
-				n2++;
-			}
-		}
+static char *_format_power_of_two(char *end, uint32_t value, int shift, const char *digits) {
+	uint32_t mask = (1 << shift) - 1;
+
+	do {
+		*(--end) = digits[value & mask];
+		value  >>= shift;
+	} while (value);
+
+	return end;
+}
+
+// Emits a formatted number: sign or prefix, zero/space padding to the field
+// width, zeroes up to the precision and finally the digits themselves.
+static void _put_number(
+	Output *out, const char *prefix, int prefix_length, const char *digits,
+	int length, int width, int precision, int flags
+) {
+	int zeroes = (precision > length) ? (precision - length) : 0;
+	int fill   = width - prefix_length - zeroes - length;
+
+	if ((flags & FLAG_ZERO) && !(flags & (FLAG_LEFT | FLAG_PRECISION))) {
+		zeroes += (fill > 0) ? fill : 0;
+		fill    = 0;
 	}
 
-	if(n2!=n)dst[sp] = 0;
+	if (!(flags & FLAG_LEFT))
+		_put_fill(out, ' ', fill);
+
+	_put_chars(out, prefix, prefix_length);
+	_put_fill(out, '0', zeroes);
+	_put_chars(out, digits, length);
 
-	return n2;
+	if (flags & FLAG_LEFT)
+		_put_fill(out, ' ', fill);
 }
 
-#ifdef ALLOW_FLOAT
+static void _put_string(Output *out, const char *str, int width, int precision, int flags) {
+	int length = 0;
 
-void libc_float_to_string(float fl, char *dst, int n)
-{
-	unsigned int *p = (unsigned int*)&fl;
-	unsigned long long i = 0;
-	unsigned long long f = 0;
-	int e, m, s;
-	int x, y;
-	unsigned long long z;
-	
-	s = *p >> 31;
-
-	e = 	(*p >> 23) & 0xff;
-
-	m = *p & 0x7fffff;
-
-	if(e == 255 && m == 0) // Infinity
-	{
-		if(s) strncpy(dst, "-inf", n);
-		else strncpy(dst, "inf", n);
-	}else if(e == 255 && m != 0) // NaN
-	{
-		strncpy(dst, "nan", n);
+	// Only scan as far as the precision allows, as the string is not required
+	// to be null-terminated in that case.
+	if (flags & FLAG_PRECISION) {
+		while ((length < precision) && str[length])
+			length++;
+	} else {
+		length = strlen(str);
 	}
-	else
-	{
-		e -= 127;
-		m |= 1<<23;
-
-
-
-		for(x = 23; x >= 0; x--)
-		{
-			if(m & (1<<x))
-			{
-				if(e >= 0)
-				{
-					z = 1;
-					for(y=0;y<e;y++)
-						z*=2;
-			
-					i+=z;
-				}
-				else
-				{
-					z = 5000000000000000000;
-					for(y = 1; y < -e; y++) 
-						z /= 2;
 
-					f+=z;
-				}
-			}
-			e--;
-		}
+	if (!(flags & FLAG_LEFT))
+		_put_fill(out, ' ', width - length);
 
-		if(s && n)
-		{
-			*(dst++) = '-';
-			n--;
-		}
+	_put_chars(out, str, length);
 
-		x = libc_ulltoa(i, dst, n);
-		n-=x;
-		dst+=x;
-
-		if(n)
-		{
-			*(dst++) = '.';
-			n--;
-			if(n)
-			{
-				x = libc_ulltoa(f, dst, n<6?n:6);
-				n-=x;
-				dst+=x;
-
-				if(n)
-					*dst=0;
-			}
-		}
-	}
+	if (flags & FLAG_LEFT)
+		_put_fill(out, ' ', width - length);
 }
 
-void libc_double_to_string(double fl, char *dst, int n)
-{
-	unsigned long long *p = (unsigned long long *)&fl;
-	unsigned long long i = 0;
-	unsigned long long f = 0;
-	unsigned long long m, s;
-	long long e;
-	int x, y;
-	unsigned long long z;
-	
-	s = *p >> 63;
-
-	e = 	(*p >> 52) & 0x7ff;
-	//printf("%d\n", e);
-
-	m = *p & 0xfffffffffffff;
-
-	for(x=0;x<52;x++)
-		if(m&((unsigned long long)1<<(52-x))) putchar('1'); else putchar('0');	
-
-	if(e == 255 && m == 0) // Infinity
-	{
-		if(s) strncpy(dst, "-inf", n);
-		else strncpy(dst, "inf", n);
-	}else if(e == 255 && m != 0) // NaN
-	{
-		strncpy(dst, "nan", n);
+#ifdef ALLOW_FLOAT
+
+static void _put_float(Output *out, double value, int width, int precision, int flags) {
+	char buffer[NUMBER_BUFFER_LENGTH * 2];
+	char *end = &buffer[sizeof(buffer)];
+	char *ptr = end;
+
+	const char *prefix = "";
+
+	if (value < 0) {
+		prefix = "-";
+		value  = -value;
+	} else if (flags & FLAG_SIGN) {
+		prefix = "+";
+	} else if (flags & FLAG_SPACE) {
+		prefix = " ";
 	}
-	else
-	{
-		e -= 1023;
-		m |= (unsigned long long)1<<52;
-
-		for(x = 52; x >= 0; x--)
-		{
-			if(m & ((unsigned long long)1<<x))
-			{
-				if(e >= 0)
-				{
-					z = (long long)1<<e;
-			
-					i+=z;
-				}
-				else
-				{
-					z = 5000000000000000000;
-					z >>= -(e + 1);
 
-					f+=z;
-				}
-			}
-			e--;
-		}
+	if (!(flags & FLAG_PRECISION))
+		precision = 6;
+	if (precision > 9)
+		precision = 9;
 
-		if(s && n)
-		{
-			*(dst++) = '-';
-			n--;
-		}
+	// Values that don't fit in 32 bits are clamped, which is good enough for
+	// debug output.
+	uint32_t scale = 1;
+	for (int i = precision; i; i--)
+		scale *= 10;
 
-		x = libc_ulltoa(i, dst, n);
-		n-=x;
-		dst+=x;
+	double   rounded  = value + 0.5 / scale;
+	uint32_t integer  = (rounded >= 4294967295.0) ? 0xffffffff : (uint32_t) rounded;
+	uint32_t fraction = (uint32_t) ((rounded - integer) * scale);
 
-		if(n)
-		{
-			*(dst++) = '.';
-			n--;
-			if(n)
-				libc_ulltoa(f, dst, n<6?n:6);
-		}
+	if (precision) {
+		char *digits = _format_decimal(ptr, fraction);
+
+		while ((ptr - digits) < precision)
+			*(--digits) = '0';
+
+		ptr      = digits;
+		*(--ptr) = '.';
 	}
-}
 
-char libc_sprintf_floatbuf[64];
+	ptr = _format_decimal(ptr, integer);
+
+	_put_number(
+		out, prefix, strlen(prefix), ptr, end - ptr, width, 0,
+		flags & ~FLAG_PRECISION
+	);
+}
 
 #endif
 
-int vsnprintf(char *string, unsigned int size, const char *fmt, va_list ap)
-{
-	int string_pos,fmt_pos;
-	int l;
-	unsigned long arg;
-	unsigned char *argcp;
-	unsigned char *argcp_tmp;
-	int directive_coming = 0;
-	int alternate_form = 0;
-	int flags = 0;
-	int argsize = 2; // int
-	int x, y;
-	unsigned long a, b;
-	int empty_digit;
-	int ssz = size - 1;
-	int zero_flag_imp = 0;
-	int pad_quantity = 0;
-	int last;
+/* Public API */
 
+int vsnprintf(char *string, unsigned int size, const char *fmt, va_list ap) {
 	// C11: required to check these cases and return error if detected
-	if (string == NULL || fmt == NULL || size == 0) { return -1; }
-	
-	l = strlen(fmt);
-	
-	string_pos = 0;
-	
-	for(fmt_pos=0;fmt_pos<l;fmt_pos++)
-	{
-		if(directive_coming)
-		{
-			switch(fmt[fmt_pos])
-			{
-				case '%':
-					put_in_string(string, ssz, '%', string_pos++);
-					directive_coming = 0;
-				break;
-				case ' ':
-					flags |= SPRINTF_SPACE_FLAG;
-				break;
-				case '#': // Specify alternate form
-					flags |= SPRINTF_ALT_FLAG;
-				break;
-				case '+': // Specify sign in signed conversions
-					flags |= SPRINTF_SIGN_FLAG;
-				break;
-				case '0': // Padding with zeros...
-					if(zero_flag_imp == 0)
-					{
-						flags |= SPRINTF_ZERO_FLAG;
-						zero_flag_imp = 1;
-						//printf("Zero padding enabled!\n"); 
-					}
-					else
-					{
-						pad_quantity *= 10;
-						//printf("pad_quantity = %d\n", pad_quantity);
-					}	
-				break;
-				case '1' ... '9': // '...' cases are a GNU extension,
-				                  // but they simplify a lot 
-				                  
-				        pad_quantity *= 10;
-				        pad_quantity += fmt[fmt_pos] - '0';
-				        zero_flag_imp = 1;
-				        
-				        //printf("pad_quantity = %d\n", pad_quantity);
-				break;
-				case '-': // Negative field flag
-					if(flags & SPRINTF_ZERO_FLAG)
-						flags &= ~SPRINTF_ZERO_FLAG;
-				
-					flags |= SPRINTF_NEGFIELD_FLAG;
-				break;
-				case 'h': // Half argument size
-					if(argsize) argsize--;
-				break;
-				case 'l': // Double argument size
-					if(argsize < 2) argsize = 2;
-					//else if(argsize < SPRINTF_SIZE_LONG_LONG) argsize++;
+	if (!string || !fmt || !size)
+		return -1;
+
+	Output out = {
+		.string = string,
+		.limit  = size - 1,
+		.pos    = 0
+	};
+
+	for (;;) {
+		// Copy any text up to the next directive in one go.
+		const char *literal = fmt;
+
+		while (*fmt && (*fmt != '%'))
+			fmt++;
+
+		if (fmt != literal)
+			_put_chars(&out, literal, fmt - literal);
+		if (!*fmt)
+			break;
+
+		fmt++;
+
+		// Parse flags, field width, precision and argument size.
+		int     flags     = 0;
+		int     width     = 0;
+		int     precision = 0;
+		ArgSize size      = SIZE_INT;
+
+		for (;; fmt++) {
+			if (*fmt == '-')
+				flags |= FLAG_LEFT;
+			else if (*fmt == '0')
+				flags |= FLAG_ZERO;
+			else if (*fmt == '+')
+				flags |= FLAG_SIGN;
+			else if (*fmt == ' ')
+				flags |= FLAG_SPACE;
+			else if (*fmt == '#')
+				flags |= FLAG_ALT;
+			else
 				break;
-				case 'd': // signed decimal
-				case 'i':
-					empty_digit = 1;
-				
-					//printf("argsize = %d\n", argsize);
-
-					//if(argsize < SPRINTF_SIZE_LONG_LONG)
-					arg = (unsigned long)va_arg(ap, unsigned long);
-					//else
-					//	arg = va_arg(ap, unsigned long);
-
-					if(get_arg_in_size(argsize, &arg, 1))
-					{
-						put_in_string(string, ssz, '-', string_pos++);
-						pad_quantity--;
-					}
-					else
-					{
-						if(flags & SPRINTF_SIGN_FLAG)
-						{
-							put_in_string(string, ssz, '+', string_pos++);
-							pad_quantity--;
-						}
-					}
-				
-					/* Calculate how much padding we have to write */
-					
-					/*y = 1;
-					
-					for(x=0;x<=9;x++)
-					{
-						if(x == 0)
-							pad_quantity--;
-						else
-						{
-							if(arg / y)
-								pad_quantity--;
-						}
-						
-						y *= 10;
-					}
-					if(pad_quantity < 0) pad_quantity = 0;*/
-
-					calculate_real_padding();
-					
-					//printf("Actual pad quantity = %d\n", pad_quantity);
-					
-					
-
-					/*if(!(flags & SPRINTF_NEGFIELD_FLAG))
-					{
-						for(x = 0; x < pad_quantity; x++)
-						{
-							if(flags & SPRINTF_ZERO_FLAG)
-								put_in_string(string, ssz, '0', string_pos++);
-							else
-								put_in_string(string, ssz, ' ', string_pos++);
-						}
-					}*/
-				
-					write_padding();
-
-					for(x=19;x>=0;x--)
-					{
-						a = 1;
-						for(y = 0; y<x; y++)
-							a *= 10;
-							
-						b = (arg/a);
-						
-						if(b>=1)
-							empty_digit = 0;
-						
-						if(empty_digit == 0 || x == 0)
-						{	
-							arg -= b*a;
-						
-							put_in_string(string, ssz, b + '0', string_pos++);
-						}
-					}
-					
-					/*if(flags & SPRINTF_NEGFIELD_FLAG)
-					{
-						for(x = 0; x < pad_quantity; x++)
-								put_in_string(string, ssz, ' ', string_pos++);
-					}*/
-					write_neg_padding();
-					
-					directive_coming = 0;
+		}
+
+		if (*fmt == '*') {
+			width = va_arg(ap, int);
+			fmt++;
+
+			if (width < 0) {
+				flags |= FLAG_LEFT;
+				width  = -width;
+			}
+		} else {
+			for (; (*fmt >= '0') && (*fmt <= '9'); fmt++)
+				width = width * 10 + (*fmt - '0');
+		}
+
+		if (*fmt == '.') {
+			flags |= FLAG_PRECISION;
+			fmt++;
+
+			if (*fmt == '*') {
+				precision = va_arg(ap, int);
+				fmt++;
+
+				if (precision < 0)
+					flags &= ~FLAG_PRECISION;
+			} else {
+				for (; (*fmt >= '0') && (*fmt <= '9'); fmt++)
+					precision = precision * 10 + (*fmt - '0');
+			}
+		}
+
+		// sizeof(long) == sizeof(int) on the PS1, so 'l', 'z' and 't' don't
+		// change anything.
+		for (;; fmt++) {
+			if (*fmt == 'h')
+				size = (size == SIZE_INT) ? SIZE_SHORT : SIZE_CHAR;
+			else if ((*fmt != 'l') && (*fmt != 'z') && (*fmt != 't'))
 				break;
-				case 'u': // unsigned decimal
-					empty_digit = 1;
-				
-					//if(argsize < SPRINTF_SIZE_LONG_LONG)
-					arg = (unsigned long)va_arg(ap, unsigned int);
-					//else
-					//arg = va_arg(ap, unsigned long long);
-				
-					get_arg_in_size(argsize, &arg, 0);
-				
-					calculate_real_padding();
-					write_padding();
-
-					for(x=19;x>=0;x--)
-					{
-						a = 1;
-						for(y = 0; y<x; y++)
-							a *= 10;
-						
-						
-							
-						b = (arg/a);
-						
-						if(b>=1)
-							empty_digit = 0;
-						
-						if(empty_digit == 0 || x == 0)
-						{	
-							arg -= b*a;
-						
-							put_in_string(string, ssz, b + '0', string_pos++);
-						}
-					}
-					
-					write_neg_padding();
-
-					directive_coming = 0;
-				break;		
-				case 'x': // Hexadecimal
-				case 'X': // Hexadecimal with big letters
-				case 'p': // Hexadecimal with small letters with '0x' prefix
-					empty_digit = 1;
-
-					//if(argsize < SPRINTF_SIZE_LONG_LONG)
-					arg = (unsigned long)va_arg(ap, unsigned int);
-					//else
-					//	arg = va_arg(ap, unsigned long int);
-
-					get_arg_in_size(argsize, &arg, 0);
-				
-					if(fmt_pos == 'p')
-						flags |= SPRINTF_ALT_FLAG;
-				
-					if(flags & SPRINTF_ALT_FLAG)
-					{
-						put_in_string(string, ssz, '0', string_pos++);
-						
-						if(fmt[fmt_pos] == 'X')
-							put_in_string(string, ssz, 'X', string_pos++);
-						else
-							put_in_string(string, ssz, 'x', string_pos++);
-					}
-				
-					calculate_real_padding_hex();
-					write_padding();
-
-					for(x=7;x>=0;x--)
-					{
-						y = arg >> (x << 2);
-						y &= 0xf;
-						
-						if(y>=1)
-							empty_digit = 0;
-						
-						if(empty_digit == 0 || x == 0)
-						{
-							if(y>=0 && y<=9)
-								put_in_string(string, ssz, y + '0', string_pos++);
-							else if(y>=0xA && y<=0xF)
-							{
-								if(fmt[fmt_pos] == 'X')
-									put_in_string(string, ssz, (y - 0xa) + 'A', string_pos++);
-								else
-									put_in_string(string, ssz, (y - 0xa) + 'a', string_pos++);
-							}
-						}
-					}
-				
-					write_neg_padding();
-
-					directive_coming = 0;
+		}
+
+		char buffer[NUMBER_BUFFER_LENGTH];
+		char *end = &buffer[NUMBER_BUFFER_LENGTH];
+		char *digits;
+
+		const char *prefix = "";
+		int        prefix_length = 0;
+		uint32_t   value;
+
+		switch (*(fmt++)) {
+			case 'd':
+			case 'i': {
+				int32_t _value = va_arg(ap, int32_t);
+
+				if (size == SIZE_CHAR)
+					_value = (int8_t) _value;
+				else if (size == SIZE_SHORT)
+					_value = (int16_t) _value;
+
+				if (_value < 0) {
+					prefix = "-";
+					value  = -((uint32_t) _value);
+				} else {
+					value  = _value;
+
+					if (flags & FLAG_SIGN)
+						prefix = "+";
+					else if (flags & FLAG_SPACE)
+						prefix = " ";
+				}
+
+				prefix_length = *prefix ? 1 : 0;
+				digits        = _format_decimal(end, value);
+				goto _put_integer;
+			}
+
+			case 'u':
+				value = va_arg(ap, uint32_t);
+
+				if (size == SIZE_CHAR)
+					value = (uint8_t) value;
+				else if (size == SIZE_SHORT)
+					value = (uint16_t) value;
+
+				digits = _format_decimal(end, value);
+				goto _put_integer;
+
+			case 'X':
+				flags |= FLAG_UPPER;
+				// fall through
+
+			case 'x':
+				value = va_arg(ap, uint32_t);
+
+				if (size == SIZE_CHAR)
+					value = (uint8_t) value;
+				else if (size == SIZE_SHORT)
+					value = (uint16_t) value;
+
+				if ((flags & FLAG_ALT) && value) {
+					prefix        = (flags & FLAG_UPPER) ? "0X" : "0x";
+					prefix_length = 2;
+				}
+
+				digits = _format_power_of_two(
+					end, value, 4, _hex_digits[(flags & FLAG_UPPER) ? 1 : 0]
+				);
+				goto _put_integer;
+
+			case 'p':
+				value = (uint32_t) (uintptr_t) va_arg(ap, void *);
+
+				if (!value) {
+					_put_string(&out, "(nil)", width, 0, flags & FLAG_LEFT);
+					break;
+				}
+
+				prefix        = "0x";
+				prefix_length = 2;
+				digits        = _format_power_of_two(end, value, 4, _hex_digits[0]);
+				goto _put_integer;
+
+			case 'o':
+				value = va_arg(ap, uint32_t);
+
+				if (size == SIZE_CHAR)
+					value = (uint8_t) value;
+				else if (size == SIZE_SHORT)
+					value = (uint16_t) value;
+
+				flags |= FLAG_OCTAL;
+				digits = _format_power_of_two(end, value, 3, _hex_digits[0]);
+				goto _put_integer;
+
+			case '@': // Binary (non-standard)
+				value  = va_arg(ap, uint32_t);
+				digits = _format_power_of_two(end, value, 1, _hex_digits[0]);
+
+			_put_integer:
+				// A zero value with zero precision produces no digits.
+				if ((flags & FLAG_PRECISION) && !precision && !value)
+					digits = end;
+
+				// The alternate octal form increases the precision so that the
+				// first digit is a zero.
+				if ((flags & (FLAG_OCTAL | FLAG_ALT)) == (FLAG_OCTAL | FLAG_ALT)) {
+					if (((end - digits) >= precision) && ((digits == end) || (*digits != '0')))
+						precision = (end - digits) + 1;
+				}
+
+				_put_number(
+					&out, prefix, prefix_length, digits, end - digits, width,
+					precision, flags
+				);
 				break;
-				case 'c': // character
-					arg = va_arg(ap, int);
-				
-					put_in_string(string, ssz, arg & 0xff, string_pos++);
-					
-					directive_coming = 0;
+
+			case 'c':
+				if (!(flags & FLAG_LEFT))
+					_put_fill(&out, ' ', width - 1);
+
+				_put_char(&out, (char) va_arg(ap, int));
+
+				if (flags & FLAG_LEFT)
+					_put_fill(&out, ' ', width - 1);
 				break;
-				case 's': // string
-					argcp = va_arg(ap, char *);
-					argcp_tmp = argcp;
-				
-					if(argcp == NULL)
-					{
-						// Non standard extension, but supported by Linux and the BSDs.
-					
-						put_in_string(string, ssz, '(', string_pos++);
-						put_in_string(string, ssz, 'n', string_pos++);
-						put_in_string(string, ssz, 'u', string_pos++);
-						put_in_string(string, ssz, 'l', string_pos++);
-						put_in_string(string, ssz, 'l', string_pos++);
-						put_in_string(string, ssz, ')', string_pos++);
-						
-						directive_coming = 0;
-						break;
-					}
-				
-					while(*argcp_tmp)
-					{
-						if(pad_quantity > 0) pad_quantity--;
-						argcp_tmp++;
-					}
-					
-					if(!(flags & SPRINTF_NEGFIELD_FLAG))
-					{
-						while(pad_quantity > 0)
-						{
-							put_in_string(string,ssz, ' ', string_pos++);
-							pad_quantity--;
-						}
-					}
-					
-					while(*argcp)
-					{
-						put_in_string(string, ssz, *argcp, string_pos++);
-						argcp++;
-					}
-					
-					if(flags & SPRINTF_NEGFIELD_FLAG)
-					{
-						while(pad_quantity > 0)
-						{
-							put_in_string(string,ssz, ' ', string_pos++);
-							pad_quantity--;
-						}
-					}
-						
-					directive_coming = 0;
+
+			case 's': {
+				const char *str = va_arg(ap, const char *);
+
+				// Non standard extension, but supported by Linux and the BSDs.
+				if (!str)
+					str = "(null)";
+
+				_put_string(&out, str, width, precision, flags);
 				break;
-				case 'o': // Octal
-					empty_digit = 1;
-					
-					//if(argsize < SPRINTF_SIZE_LONG_LONG)
-					arg = (unsigned long)va_arg(ap, unsigned int);
-					//else
-					//	arg = va_arg(ap, unsigned long long);
-				
-					for(x=21;x>=0;x--)
-					{
-						y = arg >> (x * 3);
-						y &= 0x7;
-						
-						if(y>=1)
-							empty_digit = 0;
-						
-						if(empty_digit == 0 || x == 0)
-							put_in_string(string, ssz, y + '0', string_pos++);	
-					}
-				
-					directive_coming = 0;
+			}
+
+#ifdef ALLOW_FLOAT
+			case 'f':
+			case 'F':
+				_put_float(&out, va_arg(ap, double), width, precision, flags);
 				break;
-				case '@': // Binary
-					empty_digit = 1;
-					
-					//if(argsize < SPRINTF_SIZE_LONG_LONG)
-					arg = (unsigned long)va_arg(ap, unsigned int);
-					//else
-					//	arg = va_arg(ap, unsigned long long);
-				
-					calculate_real_padding_bin();
-					write_padding();
-
-					for(x=31;x>=0;x--)
-					{
-						y = (arg >> x);
-						y &= 1;
-						
-						if(y>=1)
-							empty_digit = 0;
-						
-						if(empty_digit == 0 || x == 0)
-							put_in_string(string, ssz, y + '0', string_pos++);	
-					}
-				
-					write_neg_padding();
-				
-					directive_coming = 0;
+#endif
+
+			case 'n': // Number of characters written
+				*va_arg(ap, int *) = out.pos;
 				break;
 
-#ifdef ALLOW_FLOAT
-				case 'f':
-					libc_double_to_string(va_arg(ap, double), libc_sprintf_floatbuf, 64);
-					
-					for(x=0;libc_sprintf_floatbuf[x]!=0;x++)
-						put_in_string(string, ssz, libc_sprintf_floatbuf[x], string_pos++);
+			case '%':
+				_put_char(&out, '%');
+				break;
 
-					directive_coming = 0;
+			case '\0':
+				// Stray % at the end of the format string.
+				fmt--;
 				break;
-#endif
 
-				case 'n': // Number of characters written
-					*(va_arg(ap,unsigned int*)) = string_pos;
-					
-					directive_coming = 0;
+			default:
 				break;
-			//	default
-			}
 		}
-		else
-		{
-			if(fmt[fmt_pos] == '%')
-			{
-				directive_coming = 1;
-				flags = 0;
-				argsize = 2;
-				pad_quantity = 0;
-				zero_flag_imp = 0;
-			}
-			else
-				put_in_string(string, ssz, fmt[fmt_pos], string_pos++);
-		}	
 	}
-	string[string_pos] = 0;
-	return string_pos;	
+
+	string[(out.pos < out.limit) ? out.pos : out.limit] = 0;
+	return out.pos;
 }
 
-int vsprintf(char *string, const char *fmt, va_list ap)
-{
+int vsprintf(char *string, const char *fmt, va_list ap) {
 	return vsnprintf(string, 0xffffffff, fmt, ap);
 }
 
-int sprintf(char *string, const char *fmt, ...)
-{
-	int r;
-
+int sprintf(char *string, const char *fmt, ...) {
 	va_list ap;
 
 	va_start(ap, fmt);
-
-	r = vsprintf(string, fmt, ap);
-	
+	int r = vsprintf(string, fmt, ap);
 	va_end(ap);
-	
+
 	return r;
 }
 
-int snprintf(char *string, unsigned int size, const char *fmt, ...)
-{
-	int r;
-
+int snprintf(char *string, unsigned int size, const char *fmt, ...) {
 	va_list ap;
 
 	va_start(ap, fmt);
-
-	r = vsnprintf(string, size, fmt, ap);
-	
+	int r = vsnprintf(string, size, fmt, ap);
 	va_end(ap);
-	
+
 	return r;
 }
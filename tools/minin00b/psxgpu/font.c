@@ -59,8 +59,8 @@ void FntLoad(int x, int y) {
 		int i;
 
 		for( i=0; i<_nstreams; i++ ) {
-			free_kernel_memory(_stream[i].txtbuff);
-			free_kernel_memory(_stream[i].pribuff);
+			free(_stream[i].txtbuff);
+			free(_stream[i].pribuff);
 		}
 
 		_nstreams = 0;
@@ -80,15 +80,22 @@ int FntOpen(int x, int y, int w, int h, int isbg, int n) {
 	_stream[_nstreams].w = w;
 	_stream[_nstreams].h = h;
 
-	_stream[_nstreams].txtbuff = (char*)alloc_kernel_memory(n+1);
-
 	i = (sizeof(SPRT_8)*n)+sizeof(DR_TPAGE);
 
 	if( isbg ) {
 		i += sizeof(TILE);
 	}
 
-	_stream[_nstreams].pribuff = (char*)alloc_kernel_memory(i);
+	// Buffers are allocated from the heap, or from the kernel if InitHeap()
+	// hasn't been called yet.
+	_stream[_nstreams].txtbuff = (char*)_malloc_fallback(n+1);
+	_stream[_nstreams].pribuff = (char*)_malloc_fallback(i);
+
+	if( !_stream[_nstreams].txtbuff || !_stream[_nstreams].pribuff ) {
+		free(_stream[_nstreams].txtbuff);
+		free(_stream[_nstreams].pribuff);
+		return -1;
+	}
 	_stream[_nstreams].maxchars = n;
 
 	_stream[_nstreams].txtbuff[0] = 0x0;
@@ -57,7 +57,7 @@ HUFFMAN_TREE = {
 		"0011":		(  0, 10 ),
 		"0100":		(  2,  4 ),
 		"0101":		(  7,  2 ),
-		"0110":		( 21,  2 ),
+		"0110":		( 21,  1 ),
 		"0111":		( 20,  1 ),
 		"1000":		(  0,  9 ),
 		"1001":		( 19,  1 ),
@@ -142,6 +142,31 @@ HUFFMAN_TREE = {
 	}
 }
 
+# Version 3 DC coefficient length prefixes, indexed by coefficient length.
+DC_LUMA_CODES = [
+	"100", "00", "01", "101", "110", "1110", "11110", "111110", "1111110"
+]
+DC_CHROMA_CODES = [
+	"00", "01", "10", "110", "1110", "11110", "111110", "1111110", "11111110"
+]
+
+# Prefixes and index lengths of each VLC_TableV3 subtable, as expected by the
+# decompressor in vlc.s. The first two subtables also store code lengths.
+V3_SUBTABLES = (
+	( "ac0",  "11",           1, 16 ),
+	( "ac2",  "01",           3, 32 ),
+	( "ac3",  "001",          6, 32 ),
+	( "ac4",  "0001",         3, 16 ),
+	( "ac5",  "00001",        3, 16 ),
+	( "ac7",  "0000001",      4, 16 ),
+	( "ac8",  "00000001",     5, 16 ),
+	( "ac9",  "000000001",    5, 16 ),
+	( "ac10", "0000000001",   5, 16 ),
+	( "ac11", "00000000001",  5, 16 ),
+	( "ac12", "000000000001", 5, 16 )
+)
+V3_DC_INDEX_BITS = 7
+
 ## Utilities
 
 def to_int10(value):
@@ -157,6 +182,15 @@ def uint32_to_lines(data, indent = "\t", columns = 6):
 
 		yield line
 
+def uint_to_lines(data, bits, indent = "\t"):
+	digits  = bits // 4
+	columns = 48 // (digits + 4)
+
+	for offset in range(0, len(data), columns):
+		yield indent + ", ".join(
+			f"0x{item:0{digits}x}" for item in data[offset:(offset + columns)]
+		)
+
 ## Table generation
 
 def iterate_tree(tree):
@@ -189,6 +223,32 @@ def generate_table(codes, table_bits, prefix_bits = 0):
 
 	return table
 
+def generate_dc_table(luma_codes, chroma_codes):
+	# Each entry contains the luma and chroma coefficient lengths (packed as two
+	# nibbles) for a given 7-bit prefix. Codes longer than the prefix (i.e. the
+	# 8-bit chroma code) are matched on their first 7 bits only.
+	def find_length(codes, prefix):
+		for length, code in enumerate(codes):
+			if prefix.startswith(code[:V3_DC_INDEX_BITS]):
+				return length
+
+		return 0
+
+	dc = array("B", repeat(0, 2 ** V3_DC_INDEX_BITS))
+
+	for index in range(len(dc)):
+		prefix    = f"{index:0{V3_DC_INDEX_BITS}b}"
+		dc[index] = \
+			(find_length(luma_codes, prefix) << 4) | \
+			find_length(chroma_codes, prefix)
+
+	dc_len = array("B", (
+		(len(luma) << 4) | len(chroma)
+		for luma, chroma in zip(luma_codes, chroma_codes)
+	))
+
+	return dc, dc_len
+
 def compress_table(table):
 	values     = []
 	last_value = table[0]
@@ -210,11 +270,14 @@ def compress_table(table):
 
 ## Main
 
-UNCOMPRESSED_TEMPLATE = """static const DECDCTTAB {name} = {{
-	.lut = {{
+GENERATED_HEADER = """// This file was generated by generate_lookup_table.py, do not edit.
+
+"""
+UNCOMPRESSED_TEMPLATE = """{prefix}const DECDCTTAB {name}{attributes} = {{
+	.ac = {{
 {short}
 	}},
-	.lut00 = {{
+	.ac00 = {{
 {long}
 	}}
 }};
@@ -223,22 +286,52 @@ COMPRESSED_TEMPLATE = """static const uint32_t {name}[{length}] = {{
 {table}
 }};
 """
+V3_TEMPLATE = """{prefix}const VLC_TableV3 {name}{attributes} = {{
+{fields}
+}};
+"""
+V3_FIELD_TEMPLATE = """	.{name} = {{
+{table}
+	}}"""
 
 def get_args():
 	parser = ArgumentParser(
-		description = "Generates a Huffman lookup table structure, to be used by DecDCTvlc2()."
+		description = "Generates Huffman lookup tables for the psxpress .BS decompressors."
+	)
+	parser.add_argument(
+		"-f", "--format",
+		type    = str,
+		choices = ( "struct", "compressed", "v3", "binary" ),
+		default = "struct",
+		help    = (
+			"output a DECDCTTAB struct for DecDCTvlc2() (default), the same "
+			"table run-length compressed for DecDCTvlcBuild(), a VLC_TableV3 "
+			"struct for DecDCTvlc() or a raw DECDCTTAB binary to be loaded at "
+			"runtime"
+		)
 	)
 	parser.add_argument(
 		"-c", "--compress",
-		action = "store_true",
-		help   = "generate run-length compressed data instead of a DECDCTTAB struct"
+		action = "store_const",
+		const  = "compressed",
+		dest   = "format",
+		help   = "same as --format compressed"
 	)
 	parser.add_argument(
 		"-n", "--name",
 		type    = str,
 		default = "_default_huffman_table",
 		help    = "set the symbol name in the generated C source",
-		metavar = "file"
+		metavar = "name"
+	)
+	parser.add_argument(
+		"-s", "--section",
+		type    = str,
+		help    = (
+			"make the generated struct global and place it in the specified "
+			"section, so it can be relocated by the linker script"
+		),
+		metavar = "section"
 	)
 	parser.add_argument(
 		"-t", "--tree",
@@ -248,18 +341,29 @@ def get_args():
 	)
 	parser.add_argument(
 		"-o", "--output",
-		type    = FileType("wt"),
-		default = sys.stdout,
+		type    = str,
 		help    = "where to output generated table (stdout by default)",
 		metavar = "file"
 	)
 
 	return parser.parse_args()
 
-def main():
-	args = get_args()
-	tree = json.load(args.tree) if args.tree else HUFFMAN_TREE
+STANDALONE_HEADER = """#include <stdint.h>
+#include <psxpress.h>
+
+"""
 
+def get_linkage(args):
+	# Tables placed in a custom section are meant to be built as standalone
+	# source files rather than included by the decompressor.
+	if args.section is None:
+		return "static ", ""
+
+	return \
+		STANDALONE_HEADER, \
+		f" __attribute__((section(\"{args.section}\")))"
+
+def generate_decdcttab(tree):
 	short_codes, short_bits = [], 0
 	long_codes, long_bits   = [], 0
 
@@ -274,24 +378,93 @@ def main():
 	short_table = generate_table(short_codes, short_bits, 0)
 	long_table  = generate_table(long_codes,  long_bits,  8)
 
-	if args.compress:
-		short_table.extend(long_table)
-		table = compress_table(short_table)
+	return short_table, long_table
+
+def generate_v3_source(args, tree):
+	codes  = list(iterate_tree(tree))
+	fields = []
 
-		source = COMPRESSED_TEMPLATE.format(
-			name   = args.name,
-			length = len(table),
-			table  = ",\n".join(uint32_to_lines(table, "\t"))
+	for name, prefix, index_bits, bits in V3_SUBTABLES:
+		table = generate_table(
+			filter(lambda pair: pair[0].startswith(prefix), codes),
+			index_bits,
+			len(prefix)
 		)
+
+		# Subtables using 16-bit entries have a fixed code length, which is
+		# hardcoded in the decompressor.
+		if bits == 16:
+			table = array("H", ( (value & 0xffff) for value in table ))
+
+		fields.append(V3_FIELD_TEMPLATE.format(
+			name  = name,
+			table = ",\n".join(uint_to_lines(table, bits, "\t\t"))
+		))
+
+	for name, table in zip(
+		( "dc", "dc_len" ), generate_dc_table(DC_LUMA_CODES, DC_CHROMA_CODES)
+	):
+		fields.append(V3_FIELD_TEMPLATE.format(
+			name  = name,
+			table = ",\n".join(uint_to_lines(table, 8, "\t\t"))
+		))
+
+	prefix, attributes = get_linkage(args)
+
+	return V3_TEMPLATE.format(
+		prefix     = prefix,
+		name       = args.name,
+		attributes = attributes,
+		fields     = ",\n".join(fields)
+	)
+
+def main():
+	args = get_args()
+	tree = json.load(args.tree) if args.tree else HUFFMAN_TREE
+
+	if args.format == "v3":
+		source = generate_v3_source(args, tree)
 	else:
-		source = UNCOMPRESSED_TEMPLATE.format(
-			name  = args.name,
-			short = ",\n".join(uint32_to_lines(short_table, "\t\t")),
-			long  = ",\n".join(uint32_to_lines(long_table,  "\t\t"))
-		)
+		short_table, long_table = generate_decdcttab(tree)
+
+		if args.format == "binary":
+			short_table.extend(long_table)
+
+			if sys.byteorder != "little":
+				short_table.byteswap()
 
-	with args.output as _file:
-		_file.write(source)
+			if args.output:
+				with open(args.output, "wb") as _file:
+					short_table.tofile(_file)
+			else:
+				sys.stdout.buffer.write(short_table.tobytes())
+
+			return
+		elif args.format == "compressed":
+			short_table.extend(long_table)
+			table = compress_table(short_table)
+
+			source = COMPRESSED_TEMPLATE.format(
+				name   = args.name,
+				length = len(table),
+				table  = ",\n".join(uint32_to_lines(table, "\t"))
+			)
+		else:
+			prefix, attributes = get_linkage(args)
+
+			source = UNCOMPRESSED_TEMPLATE.format(
+				prefix     = prefix,
+				name       = args.name,
+				attributes = attributes,
+				short      = ",\n".join(uint32_to_lines(short_table, "\t\t")),
+				long       = ",\n".join(uint32_to_lines(long_table,  "\t\t"))
+			)
+
+	if args.output:
+		with open(args.output, "wt", newline = "\n") as _file:
+			_file.write(GENERATED_HEADER + source)
+	else:
+		sys.stdout.write(source)
 
 if __name__ == "__main__":
 	main()
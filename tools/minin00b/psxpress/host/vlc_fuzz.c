@@ -0,0 +1,390 @@
+/*
+ * PSn00bSDK MDEC library (VLC decompressor fuzzing harness)
+ * (C) 2022-2023 spicyjpeg - MPL licensed
+ *
+ * Checks DecDCTvlcStart()/DecDCTvlcContinue() (through the C model of vlc.s)
+ * and DecDCTvlcStart2()/DecDCTvlcContinue2() against the reference decoder.
+ * Each fuzzer input is laid out as follows:
+ *
+ * - Byte 0: flags. Bits 0-1 select the bitstream version (1 + value % 3), bit 2
+ *   selects structured mode and bits 3-7 select the chunk size passed to the
+ *   decoders (0 = decode the whole frame in one shot).
+ * - In structured mode, the remaining bytes are hashed and used to seed the
+ *   generator of a valid random stream, so that the fuzzer can reach deep into
+ *   the decoders without having to discover the Huffman codes first.
+ * - Otherwise, bytes 1-2 are the MDEC stream length (in 32-bit words, modulo
+ *   MAX_LENGTH, plus one), byte 3 is the quantization scale and the rest is
+ *   used as-is as bitstream data.
+ *
+ * The output of the decoders is only compared if the reference decoder deems
+ * the stream valid; invalid streams are still fed to all decoders in order to
+ * catch out-of-bounds accesses when built with AddressSanitizer.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <psxpress.h>
+#include "vlc_ref.h"
+
+#define MAX_LENGTH		0x800
+#define MAX_BLOCK_SIZE	65
+
+// Each MDEC code consumes at most 22 bits of input, so no decoder can read
+// more than this many words of bitstream data (plus the two words prefetched).
+#define MAX_DATA_LENGTH	(((MAX_LENGTH * 2 * 22) / 32) + 4)
+
+/* Random stream generator */
+
+typedef struct {
+	uint32_t	*data;
+	size_t		offset; // In bits
+} BitWriter;
+
+static uint32_t _xorshift(uint32_t *state) {
+	uint32_t value = *state;
+
+	value ^= value << 13;
+	value ^= value >> 17;
+	value ^= value << 5;
+
+	*state = value;
+	return value;
+}
+
+static void _write_bits(BitWriter *writer, uint32_t value, int length) {
+	for (int i = length - 1; i >= 0; i--) {
+		size_t   halfword = writer->offset / 16;
+		uint32_t bit      = (value >> i) & 1;
+
+		writer->data[halfword / 2] |=
+			bit << ((halfword % 2) * 16 + 15 - (writer->offset % 16));
+		writer->offset++;
+	}
+}
+
+static void _write_code(BitWriter *writer, const char *code) {
+	for (; *code; code++)
+		_write_bits(writer, *code - '0', 1);
+}
+
+// Generates a valid stream made up of random blocks and returns its length in
+// 32-bit words, including the header. The buffer must be zero-filled.
+static size_t _generate_stream(uint32_t *bs, int version, uint32_t seed) {
+	uint32_t  state  = seed ? seed : 1;
+	BitWriter writer = { &bs[2], 0 };
+	size_t    count  = 0;
+
+	int num_blocks = 6 * (1 + _xorshift(&state) % 24);
+
+	for (int block = 0; block < num_blocks; block++) {
+		if ((count + MAX_BLOCK_SIZE) > ((MAX_LENGTH - 4) * 2))
+			break;
+
+		if (version >= 3) {
+			int length = _xorshift(&state) % 9;
+
+			if ((block % 6) < 2)
+				_write_code(&writer, VLC_RefChromaDCCodes[length]);
+			else
+				_write_code(&writer, VLC_RefLumaDCCodes[length]);
+
+			_write_bits(&writer, _xorshift(&state), length);
+		} else {
+			uint32_t value = _xorshift(&state) & 0x3ff;
+			if (value == 0x1ff)
+				value = 0;
+
+			_write_bits(&writer, value, 10);
+		}
+
+		int num_ac = (_xorshift(&state) % 4) ?
+			(_xorshift(&state) % 16) : (_xorshift(&state) % 64);
+
+		for (int i = 0; i < num_ac; i++) {
+			if (!(_xorshift(&state) % 16)) {
+				_write_code(&writer, "000001");
+				_write_bits(&writer, _xorshift(&state), 16);
+			} else {
+				const VLC_RefCode *code =
+					&VLC_RefACCodes[_xorshift(&state) % VLC_RefNumACCodes];
+
+				_write_code(&writer, code->code);
+				_write_bits(&writer, _xorshift(&state), 1);
+			}
+		}
+
+		_write_code(&writer, "10");
+		count += num_ac + 2;
+	}
+
+	// Terminate the stream with the end-of-stream marker, then set its length
+	// to cover the data plus some padding. Occasionally the length is made
+	// shorter than the data in order to test early termination.
+	if (version >= 3)
+		_write_bits(&writer, 0x1ff, 9);
+	else
+		_write_bits(&writer, 0x1ff, 10);
+
+	size_t length = (count + 1) / 2;
+
+	if (_xorshift(&state) % 8)
+		length += _xorshift(&state) % 4;
+	else
+		length = 1 + _xorshift(&state) % length;
+
+	bs[0] = 0x38000000 | length;
+	bs[1] = (version << 16) | (_xorshift(&state) & 0xffff);
+
+	return 2 + (writer.offset + 31) / 32;
+}
+
+/* Decoder wrappers */
+
+typedef int (*StartFunc)(VLC_Context *, uint32_t *, size_t, const uint32_t *);
+typedef int (*ContinueFunc)(VLC_Context *, uint32_t *, size_t);
+
+static DECDCTTAB _vlc_table2;
+static int       _vlc_table2_built = 0;
+
+// Runs a decoder until it returns 0 or -1, concatenating the data it outputs
+// into a single buffer. The chunk buffer is filled with a marker before each
+// call so that any halfword left unwritten by a decoder is deterministic.
+static int _run_decoder(
+	const char *name, StartFunc start, ContinueFunc cont, const uint32_t *bs,
+	size_t chunk, uint16_t *output
+) {
+	static uint32_t buffer[MAX_LENGTH + 1];
+	VLC_Context     ctx;
+	size_t          offset = 0;
+	size_t          size   = (chunk ? chunk : (MAX_LENGTH + 1)) * sizeof(uint32_t);
+
+	memset(buffer, 0x55, size);
+	int ret = start(&ctx, buffer, chunk, bs);
+
+	for (size_t calls = 0; ret >= 0; calls++) {
+		size_t length = (buffer[0] & 0xffff) * 2;
+
+		if ((offset + length) > (MAX_LENGTH * 2)) {
+			fprintf(stderr, "%s: output overflow (%zu halfwords)\n", name, offset + length);
+			abort();
+		}
+		if (calls > (MAX_LENGTH * 2)) {
+			fprintf(stderr, "%s: decoder did not terminate\n", name);
+			abort();
+		}
+
+		memcpy(&output[offset], &buffer[1], length * sizeof(uint16_t));
+		offset += length;
+
+		if (!ret)
+			return (int) offset;
+
+		memset(buffer, 0x55, size);
+		ret = cont(&ctx, buffer, chunk);
+	}
+
+	return -1;
+}
+
+static void _check_decoder(
+	const char *name, int ret, const uint16_t *actual, int total,
+	const uint16_t *expected, size_t chunk
+) {
+	if (ret != total) {
+		fprintf(stderr, "%s: returned %d halfwords, expected %d\n", name, ret, total);
+		abort();
+	}
+
+	for (size_t i = 0; i < (size_t) total; i++) {
+		if (actual[i] == expected[i])
+			continue;
+
+		fprintf(
+			stderr, "%s: mismatch at halfword %zu, expected 0x%04x, got 0x%04x (chunk size %zu)\n",
+			name, i, expected[i], actual[i], chunk
+		);
+		abort();
+	}
+}
+
+/* Fuzzer entry point */
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+	static uint32_t bs[2 + MAX_DATA_LENGTH];
+	static uint16_t expected[MAX_LENGTH * 2], actual[MAX_LENGTH * 2];
+
+	if (size < 4)
+		return 0;
+	if (!_vlc_table2_built) {
+		DecDCTvlcBuild(&_vlc_table2);
+		_vlc_table2_built = 1;
+	}
+
+	int    flags   = data[0];
+	int    version = 1 + (flags & 3) % 3;
+	size_t chunk   = (flags >> 3) ? ((flags >> 3) * 3 + 1) : 0;
+	size_t length;
+
+	memset(bs, 0, sizeof(bs));
+
+	if (flags & 4) {
+		// FNV-1a hash of the input, used as generator seed.
+		uint32_t seed = 0x811c9dc5;
+
+		for (size_t i = 1; i < size; i++)
+			seed = (seed ^ data[i]) * 0x01000193;
+
+		length = _generate_stream(bs, version, seed);
+	} else {
+		size_t data_length = size - 4;
+		if (data_length > (MAX_DATA_LENGTH * 4))
+			data_length = MAX_DATA_LENGTH * 4;
+
+		bs[0] = 0x38000000 | (1 + ((data[1] | (data[2] << 8)) % MAX_LENGTH));
+		bs[1] = (version << 16) | data[3];
+
+		for (size_t i = 0; i < data_length; i++)
+			bs[2 + i / 4] |= (uint32_t) data[4 + i] << ((i % 4) * 8);
+
+		length = 2 + (data_length + 3) / 4;
+	}
+
+	int total = VLC_RefDecode(bs, length, expected, 0);
+
+	int ret = _run_decoder(
+		"DecDCTvlc", &DecDCTvlcStart, &DecDCTvlcContinue, bs, chunk, actual
+	);
+	if (total >= 0)
+		_check_decoder("DecDCTvlc", ret, actual, total, expected, chunk);
+
+	// DecDCTvlcContinue2() does not support version 3 bitstreams.
+	if (version >= 3)
+		return 0;
+
+	ret = _run_decoder(
+		"DecDCTvlc2", &DecDCTvlcStart2, &DecDCTvlcContinue2, bs, chunk, actual
+	);
+	if (total >= 0)
+		_check_decoder("DecDCTvlc2", ret, actual, total, expected, chunk);
+
+	return 0;
+}
+
+/* Standalone driver */
+
+#ifndef VLC_FUZZ_LIBFUZZER
+
+#define MAX_INPUT_SIZE	(4 + MAX_DATA_LENGTH * 4)
+
+static int _run_file(const char *path) {
+	static uint8_t input[MAX_INPUT_SIZE];
+
+	FILE *file = strcmp(path, "-") ? fopen(path, "rb") : stdin;
+	if (!file) {
+		perror(path);
+		return -1;
+	}
+
+	size_t size = fread(input, 1, sizeof(input), file);
+	if (file != stdin)
+		fclose(file);
+
+	LLVMFuzzerTestOneInput(input, size);
+	return 0;
+}
+
+// Builds a raw (non-structured) input from a valid generated stream, then
+// flips a few random bits in it.
+static size_t _mutate_stream(uint8_t *input, uint32_t *state) {
+	static uint32_t bs[2 + MAX_DATA_LENGTH];
+
+	int    version = 1 + _xorshift(state) % 3;
+	size_t length;
+
+	memset(bs, 0, sizeof(bs));
+	length = _generate_stream(bs, version, _xorshift(state));
+
+	size_t data_size = (length - 2) * 4;
+	int    flags     = (version - 1) | ((_xorshift(state) % 32) << 3);
+
+	input[0] = flags;
+	input[1] = ((bs[0] & 0xffff) - 1) & 0xff;
+	input[2] = ((bs[0] & 0xffff) - 1) >> 8;
+	input[3] = bs[1] & 63;
+
+	for (size_t i = 0; i < data_size; i++)
+		input[4 + i] = bs[2 + i / 4] >> ((i % 4) * 8);
+
+	for (int i = 1 + _xorshift(state) % 8; i; i--) {
+		size_t bit = _xorshift(state) % (data_size * 8);
+		input[4 + bit / 8] ^= 1 << (bit % 8);
+	}
+
+	return 4 + data_size;
+}
+
+int main(int argc, char **argv) {
+	static uint8_t input[MAX_INPUT_SIZE];
+
+	long     iterations = 100000;
+	uint32_t state      = 1;
+	int      i;
+
+	for (i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "-n") && (i + 1) < argc)
+			iterations = strtol(argv[++i], NULL, 0);
+		else if (!strcmp(argv[i], "-s") && (i + 1) < argc)
+			state = strtoul(argv[++i], NULL, 0) | 1;
+		else
+			break;
+	}
+
+	// If any file is given, run each of them once (this is how AFL invokes the
+	// harness), otherwise generate random and mutated inputs.
+	if (i < argc) {
+		for (; i < argc; i++) {
+			if (_run_file(argv[i]))
+				return 1;
+		}
+
+		return 0;
+	}
+
+	for (long n = 0; n < iterations; n++) {
+		size_t size;
+
+		switch (_xorshift(&state) % 3) {
+			case 0:
+				size = 5 + _xorshift(&state) % 16;
+
+				for (size_t j = 0; j < size; j++)
+					input[j] = _xorshift(&state);
+
+				input[0] |= 4;
+				break;
+
+			case 1:
+				size = 4 + _xorshift(&state) % 1024;
+
+				for (size_t j = 0; j < size; j++)
+					input[j] = _xorshift(&state);
+
+				input[0] &= ~4;
+				break;
+
+			default:
+				size = _mutate_stream(input, &state);
+				break;
+		}
+
+		LLVMFuzzerTestOneInput(input, size);
+	}
+
+	printf("%ld iterations passed\n", iterations);
+	return 0;
+}
+
+#endif
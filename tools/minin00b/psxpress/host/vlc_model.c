@@ -0,0 +1,248 @@
+/*
+ * PSn00bSDK MDEC library (C model of the GTE-accelerated VLC decompressor)
+ * (C) 2022-2023 spicyjpeg - MPL licensed
+ *
+ * This is a straightforward C translation of vlc.s, used to provide
+ * DecDCTvlcStart() and DecDCTvlcContinue() when building vlc.c on the host.
+ * It uses the same VLC_TableV3 lookup table and jump logic as the assembly
+ * version, so any change to vlc.s shall be mirrored here.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <psxpress.h>
+
+extern const VLC_TableV3 *_vlc_huffman_table;
+
+/* Private utilities */
+
+// Equivalent to the GTE's LZCS/LZCR registers for values whose MSB is clear.
+static int _count_leading_zeroes(uint32_t value) {
+	int count = 0;
+
+	for (; count < 32; count++, value <<= 1) {
+		if (value & 0x80000000)
+			break;
+	}
+
+	return count;
+}
+
+// The MIPS srlv/sllv instructions only use the lower 5 bits of the shift
+// amount, which the decoder relies upon.
+#define _srlv(value, shift)	((uint32_t) (value) >> ((shift) & 31))
+#define _sllv(value, shift)	((uint32_t) (value) << ((shift) & 31))
+
+/* Public API */
+
+int DecDCTvlcContinue(VLC_Context *ctx, uint32_t *buf, size_t max_size) {
+	const VLC_TableV3 *table = _vlc_huffman_table;
+
+	const uint32_t	*input		= ctx->input;
+	uint32_t		window		= ctx->window;
+	uint32_t		next_window	= ctx->next_window;
+	int32_t			remaining	= ctx->remaining;
+	int				is_v3		= ctx->is_v3;
+	int				bit_offset	= ctx->bit_offset;
+	int				block_index	= ctx->block_index;
+	int				coeff_index	= ctx->coeff_index;
+	uint32_t		quant_scale	= ctx->quant_scale;
+	int32_t			last_y		= ctx->last_y;
+	int32_t			last_cr		= ctx->last_cr;
+	int32_t			last_cb		= ctx->last_cb;
+
+	int32_t size = ((int32_t) max_size > 0) ? ((int32_t) max_size - 1) : 0x3fff0000;
+	size *= 2;
+
+	remaining -= size;
+	if (remaining < 0) {
+		size     += remaining;
+		remaining = 0;
+	}
+
+	buf[0] = 0x38000000 | (size / 2);
+	uint16_t *output = (uint16_t *) &buf[1];
+
+	while (size) {
+		int length;
+
+		if (!(coeff_index++)) {
+			if (!is_v3) {
+				uint32_t value = window >> 22;
+				if (value == 0x1ff) {
+					coeff_index = 0;
+					break;
+				}
+
+				*output = value | quant_scale;
+				length  = 10;
+			} else {
+				uint32_t prefix = window >> 23;
+				if (prefix == 0x1ff) {
+					coeff_index = 0;
+					break;
+				}
+
+				int      lengths = table->dc[prefix >> 2];
+				int32_t *last;
+				int      dc_length, prefix_length;
+
+				if (block_index < 4) {
+					last          = &last_y;
+					dc_length     = lengths >> 4;
+					prefix_length = table->dc_len[dc_length] >> 4;
+				} else {
+					last          = (block_index == 4) ? &last_cb : &last_cr;
+					dc_length     = lengths & 15;
+					prefix_length = table->dc_len[dc_length] & 15;
+				}
+
+				window      = _sllv(window, prefix_length);
+				bit_offset -= prefix_length;
+
+				if (dc_length) {
+					int32_t value = _srlv(window, 32 - dc_length);
+					if (!(window >> 31))
+						value -= _srlv(0xffffffff, 32 - dc_length);
+
+					*last = (*last + value * 4) & 0x3ff;
+				}
+
+				*output = *last | quant_scale;
+				length  = dc_length;
+			}
+		} else if (window >> 31) {
+			if ((window << 1) >> 31) {
+				// Prefix 11
+				*output = table->ac0[(window >> 29) & 1];
+				length  = 3;
+			} else {
+				// Prefix 10
+				*output     = 0xfe00;
+				length      = 2;
+				coeff_index = 0;
+
+				if (--block_index < 0)
+					block_index = 5;
+			}
+		} else {
+			uint32_t value;
+
+			switch (_count_leading_zeroes(window)) {
+				case 1:
+					value   = table->ac2[(window >> 27) & 7];
+					*output = (uint16_t) value;
+					length  = value >> 16;
+					break;
+
+				case 2:
+					value   = table->ac3[(window >> 23) & 63];
+					*output = (uint16_t) value;
+					length  = value >> 16;
+					break;
+
+				case 3:
+					*output = table->ac4[(window >> 25) & 7];
+					length  = 7;
+					break;
+
+				case 4:
+					*output = table->ac5[(window >> 24) & 7];
+					length  = 8;
+					break;
+
+				case 5:
+					*output = (uint16_t) (window >> 10);
+					length  = 22;
+					break;
+
+				case 6:
+					*output = table->ac7[(window >> 21) & 15];
+					length  = 11;
+					break;
+
+				case 7:
+					*output = table->ac8[(window >> 19) & 31];
+					length  = 13;
+					break;
+
+				case 8:
+					*output = table->ac9[(window >> 18) & 31];
+					length  = 14;
+					break;
+
+				case 9:
+					*output = table->ac10[(window >> 17) & 31];
+					length  = 15;
+					break;
+
+				case 10:
+					*output = table->ac11[(window >> 16) & 31];
+					length  = 16;
+					break;
+
+				case 11:
+					*output = table->ac12[(window >> 15) & 31];
+					length  = 17;
+					break;
+
+				default:
+					return -1;
+			}
+		}
+
+		window      = _sllv(window, length);
+		bit_offset -= length;
+		size--;
+
+		if (bit_offset < 0) {
+			window      = _sllv(next_window, -bit_offset);
+			next_window = (*input << 16) | (*input >> 16);
+			bit_offset += 32;
+			input++;
+		}
+
+		window |= _srlv(next_window, bit_offset);
+		output++;
+	}
+
+	for (; size; size--)
+		*(output++) = 0xfe00;
+
+	if (!remaining)
+		return 0;
+
+	ctx->input			= input;
+	ctx->window			= window;
+	ctx->next_window	= next_window;
+	ctx->remaining		= remaining;
+	ctx->bit_offset		= bit_offset;
+	ctx->block_index	= block_index;
+	ctx->coeff_index	= coeff_index;
+	ctx->last_y			= last_y;
+	ctx->last_cr		= last_cr;
+	ctx->last_cb		= last_cb;
+	return 1;
+}
+
+int DecDCTvlcStart(
+	VLC_Context *ctx, uint32_t *buf, size_t max_size, const uint32_t *bs
+) {
+	const BS_Header *header = (const BS_Header *) bs;
+	const uint32_t  *input  = (const uint32_t *) &header[1];
+
+	ctx->input			= &input[2];
+	ctx->window			= (input[0] << 16) | (input[0] >> 16);
+	ctx->next_window	= (input[1] << 16) | (input[1] >> 16);
+	ctx->remaining		= (header->mdec0_header & 0xffff) * 2;
+	ctx->is_v3			= !(header->version < 3);
+	ctx->bit_offset		= 32;
+	ctx->block_index	= 5;
+	ctx->coeff_index	= 0;
+	ctx->quant_scale	= (header->quant_scale & 63) << 10;
+	ctx->last_y			= 0;
+	ctx->last_cr		= 0;
+	ctx->last_cb		= 0;
+
+	return DecDCTvlcContinue(ctx, buf, max_size);
+}
@@ -0,0 +1,367 @@
+/*
+ * PSn00bSDK MDEC library (portable reference VLC decoder)
+ * (C) 2022-2023 spicyjpeg - MPL licensed
+ *
+ * This file is only used on the host, as a known-good model to check the
+ * optimized decoders against. Keep it simple rather than fast.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "vlc_ref.h"
+
+#define MAX_CODE_LENGTH		16
+#define MAX_AC_PER_BLOCK	63
+
+/* Code tables */
+
+// AC coefficient codes (MPEG-1 table B.14, without the special first
+// coefficient code). Each code is followed by a sign bit, 1 = negative.
+const VLC_RefCode VLC_RefACCodes[] = {
+	{ "11",                0,  1 },
+	{ "011",               1,  1 },
+	{ "0100",              0,  2 },
+	{ "0101",              2,  1 },
+	{ "00101",             0,  3 },
+	{ "00110",             4,  1 },
+	{ "00111",             3,  1 },
+	{ "000100",            7,  1 },
+	{ "000101",            6,  1 },
+	{ "000110",            1,  2 },
+	{ "000111",            5,  1 },
+	{ "0000100",           2,  2 },
+	{ "0000101",           9,  1 },
+	{ "0000110",           0,  4 },
+	{ "0000111",           8,  1 },
+	{ "00100000",         13,  1 },
+	{ "00100001",          0,  6 },
+	{ "00100010",         12,  1 },
+	{ "00100011",         11,  1 },
+	{ "00100100",          3,  2 },
+	{ "00100101",          1,  3 },
+	{ "00100110",          0,  5 },
+	{ "00100111",         10,  1 },
+	{ "0000001000",       16,  1 },
+	{ "0000001001",        5,  2 },
+	{ "0000001010",        0,  7 },
+	{ "0000001011",        2,  3 },
+	{ "0000001100",        1,  4 },
+	{ "0000001101",       15,  1 },
+	{ "0000001110",       14,  1 },
+	{ "0000001111",        4,  2 },
+	{ "000000010000",      0, 11 },
+	{ "000000010001",      8,  2 },
+	{ "000000010010",      4,  3 },
+	{ "000000010011",      0, 10 },
+	{ "000000010100",      2,  4 },
+	{ "000000010101",      7,  2 },
+	{ "000000010110",     21,  1 },
+	{ "000000010111",     20,  1 },
+	{ "000000011000",      0,  9 },
+	{ "000000011001",     19,  1 },
+	{ "000000011010",     18,  1 },
+	{ "000000011011",      1,  5 },
+	{ "000000011100",      3,  3 },
+	{ "000000011101",      0,  8 },
+	{ "000000011110",      6,  2 },
+	{ "000000011111",     17,  1 },
+	{ "0000000010000",    10,  2 },
+	{ "0000000010001",     9,  2 },
+	{ "0000000010010",     5,  3 },
+	{ "0000000010011",     3,  4 },
+	{ "0000000010100",     2,  5 },
+	{ "0000000010101",     1,  7 },
+	{ "0000000010110",     1,  6 },
+	{ "0000000010111",     0, 15 },
+	{ "0000000011000",     0, 14 },
+	{ "0000000011001",     0, 13 },
+	{ "0000000011010",     0, 12 },
+	{ "0000000011011",    26,  1 },
+	{ "0000000011100",    25,  1 },
+	{ "0000000011101",    24,  1 },
+	{ "0000000011110",    23,  1 },
+	{ "0000000011111",    22,  1 },
+	{ "00000000010000",    0, 31 },
+	{ "00000000010001",    0, 30 },
+	{ "00000000010010",    0, 29 },
+	{ "00000000010011",    0, 28 },
+	{ "00000000010100",    0, 27 },
+	{ "00000000010101",    0, 26 },
+	{ "00000000010110",    0, 25 },
+	{ "00000000010111",    0, 24 },
+	{ "00000000011000",    0, 23 },
+	{ "00000000011001",    0, 22 },
+	{ "00000000011010",    0, 21 },
+	{ "00000000011011",    0, 20 },
+	{ "00000000011100",    0, 19 },
+	{ "00000000011101",    0, 18 },
+	{ "00000000011110",    0, 17 },
+	{ "00000000011111",    0, 16 },
+	{ "000000000010000",   0, 40 },
+	{ "000000000010001",   0, 39 },
+	{ "000000000010010",   0, 38 },
+	{ "000000000010011",   0, 37 },
+	{ "000000000010100",   0, 36 },
+	{ "000000000010101",   0, 35 },
+	{ "000000000010110",   0, 34 },
+	{ "000000000010111",   0, 33 },
+	{ "000000000011000",   0, 32 },
+	{ "000000000011001",   1, 14 },
+	{ "000000000011010",   1, 13 },
+	{ "000000000011011",   1, 12 },
+	{ "000000000011100",   1, 11 },
+	{ "000000000011101",   1, 10 },
+	{ "000000000011110",   1,  9 },
+	{ "000000000011111",   1,  8 },
+	{ "0000000000010000",  1, 18 },
+	{ "0000000000010001",  1, 17 },
+	{ "0000000000010010",  1, 16 },
+	{ "0000000000010011",  1, 15 },
+	{ "0000000000010100",  6,  3 },
+	{ "0000000000010101", 16,  2 },
+	{ "0000000000010110", 15,  2 },
+	{ "0000000000010111", 14,  2 },
+	{ "0000000000011000", 13,  2 },
+	{ "0000000000011001", 12,  2 },
+	{ "0000000000011010", 11,  2 },
+	{ "0000000000011011", 31,  1 },
+	{ "0000000000011100", 30,  1 },
+	{ "0000000000011101", 29,  1 },
+	{ "0000000000011110", 28,  1 },
+	{ "0000000000011111", 27,  1 }
+};
+
+const size_t VLC_RefNumACCodes = sizeof(VLC_RefACCodes) / sizeof(VLC_RefCode);
+
+const char *const VLC_RefLumaDCCodes[9] = {
+	"100", "00", "01", "101", "110", "1110", "11110", "111110", "1111110"
+};
+const char *const VLC_RefChromaDCCodes[9] = {
+	"00", "01", "10", "110", "1110", "11110", "111110", "1111110", "11111110"
+};
+
+/* Bitstream reader */
+
+typedef struct {
+	const uint32_t	*data;
+	size_t			length, offset; // In bits
+} BitReader;
+
+// Sony's decoder reads the bitstream 16 bits at a time starting from the MSB
+// of each halfword, so the first halfword is the lower half of each word.
+static int _read_bit(BitReader *reader) {
+	if (reader->offset >= reader->length)
+		return -1;
+
+	size_t   halfword = reader->offset / 16;
+	uint32_t word     = reader->data[halfword / 2] >> ((halfword % 2) * 16);
+	int      bit      = (word >> (15 - (reader->offset % 16))) & 1;
+
+	reader->offset++;
+	return bit;
+}
+
+static int _read_bits(BitReader *reader, int length, uint32_t *value) {
+	*value = 0;
+
+	for (; length; length--) {
+		int bit = _read_bit(reader);
+		if (bit < 0)
+			return -1;
+
+		*value = (*value << 1) | bit;
+	}
+
+	return 0;
+}
+
+static int _peek_bits(BitReader *reader, int length, uint32_t *value) {
+	size_t offset = reader->offset;
+	int    error  = _read_bits(reader, length, value);
+
+	reader->offset = offset;
+	return error;
+}
+
+// Reads bits one at a time until they match one of the given codes, returning
+// the index of the code matched.
+static int _match_code(BitReader *reader, const char *const *codes, int num_codes) {
+	char prefix[MAX_CODE_LENGTH + 1];
+
+	for (int length = 0; length < MAX_CODE_LENGTH;) {
+		int bit = _read_bit(reader);
+		if (bit < 0)
+			return -1;
+
+		prefix[length++] = '0' + bit;
+		prefix[length]   = 0;
+
+		for (int i = 0; i < num_codes; i++) {
+			if (!strcmp(prefix, codes[i]))
+				return i;
+		}
+	}
+
+	return -1;
+}
+
+/* Coefficient decoders */
+
+static int _decode_dc_v3(
+	BitReader *reader, int block, int16_t *last_y, int16_t *last_c
+) {
+	// Blocks are stored in Cr, Cb, Y1, Y2, Y3, Y4 order, each chroma block type
+	// using its own predictor.
+	const char *const *codes = block < 2 ? VLC_RefChromaDCCodes : VLC_RefLumaDCCodes;
+	int16_t *last = block < 2 ? &last_c[block] : last_y;
+
+	int length = _match_code(reader, codes, 9);
+	if (length < 0)
+		return -1;
+
+	if (length) {
+		uint32_t value;
+		if (_read_bits(reader, length, &value))
+			return -1;
+
+		int32_t delta = (int32_t) value;
+		if (!(value >> (length - 1)))
+			delta -= (1 << length) - 1;
+
+		*last = (*last + delta * 4) & 0x3ff;
+	}
+
+	return *last;
+}
+
+// Parsing the code strings on every bit read would make the reference decoder
+// too slow for fuzzing, so they are converted to integers once.
+static uint32_t _ac_code_values[sizeof(VLC_RefACCodes) / sizeof(VLC_RefCode)];
+static int      _ac_code_lengths[sizeof(VLC_RefACCodes) / sizeof(VLC_RefCode)];
+
+static void _parse_ac_codes(void) {
+	if (_ac_code_lengths[0])
+		return;
+
+	for (size_t i = 0; i < VLC_RefNumACCodes; i++) {
+		const char *code = VLC_RefACCodes[i].code;
+
+		for (; *code; code++) {
+			_ac_code_values[i] = (_ac_code_values[i] << 1) | (*code - '0');
+			_ac_code_lengths[i]++;
+		}
+	}
+}
+
+static int _decode_ac(BitReader *reader, uint16_t *output) {
+	uint32_t prefix = 0;
+
+	for (int length = 1; length <= MAX_CODE_LENGTH; length++) {
+		int bit = _read_bit(reader);
+		if (bit < 0)
+			return -1;
+
+		prefix = (prefix << 1) | bit;
+
+		if ((length == 2) && (prefix == 0b10)) {
+			*output = 0xfe00;
+			return 1;
+		}
+		if ((length == 6) && (prefix == 0b000001)) {
+			uint32_t value;
+			if (_read_bits(reader, 16, &value))
+				return -1;
+
+			*output = (uint16_t) value;
+			return 0;
+		}
+
+		for (size_t i = 0; i < VLC_RefNumACCodes; i++) {
+			if ((_ac_code_lengths[i] != length) || (_ac_code_values[i] != prefix))
+				continue;
+
+			int sign = _read_bit(reader);
+			if (sign < 0)
+				return -1;
+
+			const VLC_RefCode *code = &VLC_RefACCodes[i];
+
+			int level = sign ? -((int) code->level) : code->level;
+			*output   = (code->run << 10) | (level & 0x3ff);
+			return 0;
+		}
+	}
+
+	return -1;
+}
+
+/* Public API */
+
+int VLC_RefDecode(
+	const uint32_t *bs, size_t length, uint16_t *output, size_t *decoded
+) {
+	if (length < 2)
+		return -1;
+
+	_parse_ac_codes();
+
+	uint32_t mdec0_header = bs[0];
+	uint32_t quant_scale  = (bs[1] & 63) << 10;
+	uint32_t version      = bs[1] >> 16;
+
+	if ((version < 1) || (version > 3))
+		return -1;
+
+	BitReader reader = { &bs[2], (length - 2) * 32, 0 };
+
+	size_t  total = (mdec0_header & 0xffff) * 2, offset = 0;
+	int16_t last_y = 0, last_c[2] = { 0, 0 };
+
+	for (int block = 0; offset < total; block = (block + 1) % 6) {
+		// Decode the DC coefficient, checking for the end-of-stream marker
+		// first.
+		uint32_t value;
+
+		if (version >= 3) {
+			if (_peek_bits(&reader, 9, &value))
+				return -1;
+			if (value == 0x1ff)
+				break;
+
+			int dc = _decode_dc_v3(&reader, block, &last_y, last_c);
+			if (dc < 0)
+				return -1;
+
+			output[offset++] = dc | quant_scale;
+		} else {
+			if (_peek_bits(&reader, 10, &value))
+				return -1;
+			if (value == 0x1ff)
+				break;
+
+			reader.offset += 10;
+			output[offset++] = value | quant_scale;
+		}
+
+		// Decode AC coefficients until the end of the block.
+		for (int coeff = 0; offset < total; coeff++) {
+			if (coeff > MAX_AC_PER_BLOCK)
+				return -1;
+
+			int eob = _decode_ac(&reader, &output[offset++]);
+			if (eob < 0)
+				return -1;
+			if (eob)
+				break;
+		}
+	}
+
+	if (decoded)
+		*decoded = offset;
+
+	for (; offset < total; offset++)
+		output[offset] = 0xfe00;
+
+	return (int) total;
+}
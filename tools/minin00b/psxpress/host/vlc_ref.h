@@ -0,0 +1,59 @@
+/*
+ * PSn00bSDK MDEC library (portable reference VLC decoder)
+ * (C) 2022-2023 spicyjpeg - MPL licensed
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/* Structure definitions */
+
+typedef struct {
+	const char	*code;	// Huffman code as a string of 0s and 1s, sign bit excluded
+	uint8_t		run, level;
+} VLC_RefCode;
+
+/* Code tables */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern const VLC_RefCode	VLC_RefACCodes[];
+extern const size_t			VLC_RefNumACCodes;
+
+// Version 3 DC coefficient length prefixes, indexed by coefficient length.
+extern const char *const	VLC_RefLumaDCCodes[9];
+extern const char *const	VLC_RefChromaDCCodes[9];
+
+/* Public API */
+
+/**
+ * @brief Decodes a .BS file into MDEC codes, one bit at a time.
+ *
+ * @details A deliberately naive and slow implementation of the .BS bitstream
+ * format, written against the code tables above rather than any lookup table
+ * used by the optimized decoders. It outputs exactly what DecDCTvlcStart() and
+ * DecDCTvlcStart2() would write after the first word of their output buffer
+ * when decoding a frame in one shot, including the end-of-block padding.
+ *
+ * A stream is only considered valid if all of its codes are valid, no block
+ * has more than 63 AC coefficients and no bit past the end of the input is
+ * read; anything else makes the output of the optimized decoders undefined, so
+ * -1 is returned instead.
+ *
+ * @param bs Pointer to .BS header followed by bitstream data
+ * @param length Length of the header and data in 32-bit words
+ * @param output Buffer for at least (mdec0_header & 0xffff) * 2 halfwords
+ * @param decoded Optional, set to the number of halfwords preceding padding
+ * @return Number of halfwords written or -1 if the stream is invalid
+ */
+int VLC_RefDecode(
+	const uint32_t *bs, size_t length, uint16_t *output, size_t *decoded
+);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,216 @@
+/*
+ * PSn00bSDK MDEC library (pipelined frame decoder)
+ * (C) 2022-2023 spicyjpeg - MPL licensed
+ */
+
+#include <stdint.h>
+#include <assert.h>
+#include <psxetc.h>
+#include <psxapi.h>
+#include <psxgpu.h>
+#include <psxpress.h>
+#include <hwregs_c.h>
+
+#define DMA_CHUNK_LENGTH	32
+#define PIPELINE_TIMEOUT	0x100000
+
+typedef enum {
+	CHUNK_STATE_FREE	= 0,	// Can be overwritten by the decompressor
+	CHUNK_STATE_READY	= 1,	// Decompressed, waiting to be fed to the MDEC
+	CHUNK_STATE_BUSY	= 2		// Currently being read by the MDEC
+} ChunkState;
+
+/* Internal globals */
+
+static MDEC_Pipeline *volatile _active_pipe = 0;
+static void *_saved_in_callback, *_saved_out_callback;
+
+/* Private utilities */
+
+static void _feed_chunk(MDEC_Pipeline *pipe, int index) {
+	const uint32_t *chunk = pipe->vlc_buf[index];
+
+	pipe->chunk_state[index] = CHUNK_STATE_BUSY;
+	pipe->in_index           = index;
+
+	// The first word of each chunk holds the length written by the
+	// decompressor. The MDEC0 command itself has already been issued for the
+	// whole frame, so only the data following the length is transferred.
+	DecDCTinRaw(&chunk[1], chunk[0] & 0xffff);
+}
+
+static void _release_pipeline(void) {
+	DMACallback(DMA_MDEC_IN,  _saved_in_callback);
+	DMACallback(DMA_MDEC_OUT, _saved_out_callback);
+
+	_active_pipe = 0;
+}
+
+/* Private interrupt handlers */
+
+static void _mdec_in_handler(void) {
+	MDEC_Pipeline *pipe = _active_pipe;
+	if (!pipe)
+		return;
+
+	// Hand the chunk that was just consumed back to the main thread and, if
+	// the next one has already been decompressed, feed it to the MDEC right
+	// away so that it doesn't stall waiting for the CPU.
+	int index = pipe->in_index;
+	pipe->chunk_state[index] = CHUNK_STATE_FREE;
+
+	index ^= 1;
+	if (pipe->chunk_state[index] == CHUNK_STATE_READY)
+		_feed_chunk(pipe, index);
+}
+
+static void _mdec_out_handler(void) {
+	MDEC_Pipeline *pipe = _active_pipe;
+	if (!pipe)
+		return;
+
+	// Upload the slice that was just decoded and let the MDEC carry on into
+	// the other buffer. LoadImage() copies the RECT and queues the transfer,
+	// so the upload will be overlapped with decoding of the next slice.
+	int  index = pipe->out_index;
+	RECT rect;
+
+	rect.x = pipe->x;
+	rect.y = pipe->y;
+	rect.w = pipe->slice_width;
+	rect.h = pipe->height;
+	LoadImage(&rect, pipe->slice_buf[index]);
+
+	pipe->x += pipe->slice_width;
+	if (!(--pipe->slices_left))
+		return;
+
+	index ^= 1;
+	pipe->out_index = index;
+	DecDCTout(pipe->slice_buf[index], pipe->slice_size);
+}
+
+/* Public API */
+
+void DecDCTPipelineInit(
+	MDEC_Pipeline *pipe,
+	uint32_t *vlc_buf,
+	size_t vlc_size,
+	uint32_t *slice_buf,
+	int width,
+	int height,
+	int mode
+) {
+	_sdk_validate_args_void(pipe && vlc_buf && slice_buf);
+	_sdk_validate_args_void((vlc_size >= DMA_CHUNK_LENGTH) && (width > 0) && (height > 0));
+
+	// Chunks must be a multiple of the DMA block size, as the MDEC will only
+	// fetch whole blocks. One more word is reserved for the length header
+	// written by DecDCTvlcContinue().
+	vlc_size -= vlc_size % DMA_CHUNK_LENGTH;
+
+	pipe->vlc_buf[0] = vlc_buf;
+	pipe->vlc_buf[1] = &vlc_buf[vlc_size + 1];
+	pipe->vlc_size   = vlc_size;
+
+	if (mode & DECDCT_MODE_24BPP) {
+		pipe->slice_width = 24;
+		pipe->slice_size  = height * 12;
+	} else {
+		pipe->slice_width = 16;
+		pipe->slice_size  = height * 8;
+	}
+
+	pipe->slice_buf[0] = slice_buf;
+	pipe->slice_buf[1] = &slice_buf[pipe->slice_size];
+	pipe->height       = height;
+	pipe->num_slices   = (width + 15) / 16;
+	pipe->slices_left  = 0;
+	pipe->mode         = mode;
+}
+
+int DecDCTPipelineDecode(MDEC_Pipeline *pipe, const uint32_t *bs, int x, int y) {
+	_sdk_validate_args(pipe && bs, -1);
+
+	if (DecDCTPipelineSync(0))
+		return -1;
+
+	// Decompress the first chunk before touching the MDEC, so that a broken
+	// frame is rejected without leaving the hardware in a half-configured
+	// state.
+	int ret = DecDCTvlcStart(&(pipe->ctx), pipe->vlc_buf[0], pipe->vlc_size + 1, bs);
+	if (ret < 0)
+		return -1;
+
+	uint32_t length = ((const BS_Header *) bs)->mdec0_header & 0xffff;
+
+	pipe->x              = x;
+	pipe->y              = y;
+	pipe->slices_left    = pipe->num_slices;
+	pipe->in_index       = 0;
+	pipe->out_index      = 0;
+	pipe->chunk_state[0] = CHUNK_STATE_READY;
+	pipe->chunk_state[1] = CHUNK_STATE_FREE;
+
+	_active_pipe        = pipe;
+	_saved_in_callback  = DMACallback(DMA_MDEC_IN,  &_mdec_in_handler);
+	_saved_out_callback = DMACallback(DMA_MDEC_OUT, &_mdec_out_handler);
+
+	DecDCTinSync(0);
+	if (pipe->mode & DECDCT_MODE_24BPP)
+		MDEC0 = 0x30000000 | length;
+	else
+		MDEC0 = 0x38000000 | length | ((pipe->mode & 2) << 24); // Bit 25 = mask
+
+	DecDCTout(pipe->slice_buf[0], pipe->slice_size);
+	_feed_chunk(pipe, 0);
+
+	// Keep decompressing chunks into whichever buffer the MDEC is not reading
+	// from. If the MDEC is idle by the time a chunk is ready (i.e. the CPU is
+	// the bottleneck) the chunk is fed directly, otherwise the DMA callback
+	// will pick it up as soon as the previous one has been consumed.
+	for (int index = 1; ret; index ^= 1) {
+		for (int i = PIPELINE_TIMEOUT; pipe->chunk_state[index] != CHUNK_STATE_FREE; i--) {
+			if (!i) {
+				_sdk_log("DecDCTPipelineDecode() timeout, MDEC1=0x%08x\n", MDEC1);
+				_release_pipeline();
+				return -1;
+			}
+		}
+
+		ret = DecDCTvlcContinue(&(pipe->ctx), pipe->vlc_buf[index], pipe->vlc_size + 1);
+		if (ret < 0) {
+			_release_pipeline();
+			return -1;
+		}
+
+		FastEnterCriticalSection();
+
+		if (pipe->chunk_state[index ^ 1] == CHUNK_STATE_FREE)
+			_feed_chunk(pipe, index);
+		else
+			pipe->chunk_state[index] = CHUNK_STATE_READY;
+
+		FastExitCriticalSection();
+	}
+
+	return 0;
+}
+
+int DecDCTPipelineSync(int mode) {
+	MDEC_Pipeline *pipe = _active_pipe;
+	if (!pipe)
+		return 0;
+	if (mode)
+		return pipe->slices_left;
+
+	for (int i = PIPELINE_TIMEOUT; i; i--) {
+		if (!pipe->slices_left) {
+			_release_pipeline();
+			return 0;
+		}
+	}
+
+	_sdk_log("DecDCTPipelineSync() timeout, %d slices left\n", pipe->slices_left);
+	return -1;
+}
@@ -178,7 +178,7 @@ _vlc_skip_context_load:
 	#   if (prefix == 0x1ff) break
 	#   *output = prefix | quant_scale
 	srl   value, window, 22
-	beq   value, temp, .Lstop_processing
+	beq   value, temp, .Lstop_at_end_marker
 	or    value, quant_scale
 	sll   window, 10
 	addiu bit_offset, -10
@@ -198,7 +198,7 @@ _vlc_skip_context_load:
 	#   if (prefix == 0x1ff) break
 	#   lengths = huffman_table->dc[prefix >> 2]
 	srl   length, window, 23
-	beq   length, temp, .Lstop_processing
+	beq   length, temp, .Lstop_at_end_marker
 	srl   length, 2
 	addu  length, huffman_table
 
@@ -321,6 +321,13 @@ _vlc_skip_context_load:
 	b     .Lreturn
 	li    $v0, -1
 
+.Lstop_at_end_marker:
+	# The end-of-stream marker is left in the bitstream, so that it is detected
+	# again if decoding is resumed. coeff_index has already been incremented at
+	# this point and must be reset for the same reason.
+	b     .Lstop_processing
+	li    coeff_index, 0
+
 .Lac_prefix_1: # if (window >> 31)
 	sll   window, 1
 	bltz  window, .Lac_prefix_11
@@ -539,12 +546,23 @@ _vlc_skip_context_load:
 	addiu output, 2
 
 .Lstop_processing:
-	# If remaining = 0, skip flushing the context, pad the output buffer with
-	# end-of-block codes if necessary and return 0. Otherwise flush the context
-	# and return 1.
-	beqz  remaining, .Lpad_output_buffer
+	# Pad the output buffer with end-of-block codes if the end of the bitstream
+	# was reached before filling it.
+	beqz  max_size, .Lflush_context
 	li    temp, 0xfe00
 
+.Lpad_output_buffer_loop: # while (max_size)
+	sh    temp, 0(output)
+	addiu max_size, -1
+	bnez  max_size, .Lpad_output_buffer_loop
+	addiu output, 2
+
+.Lflush_context:
+	# If remaining = 0, skip flushing the context and return 0. Otherwise flush
+	# the context and return 1.
+	beqz  remaining, .Lreturn
+	li    $v0, 0
+
 	sw    input, VLC_Context_input(ctx)
 	sw    window, VLC_Context_window(ctx)
 	sw    next_window, VLC_Context_next_window(ctx)
@@ -559,16 +577,6 @@ _vlc_skip_context_load:
 	b     .Lreturn
 	li    $v0, 1
 
-.Lpad_output_buffer:
-	beqz  max_size, .Lreturn
-	li    $v0, 0
-
-.Lpad_output_buffer_loop: # while (max_size)
-	sh    temp, 0(output)
-	addiu max_size, -1
-	bnez  max_size, .Lpad_output_buffer_loop
-	addiu output, 2
-
 .Lreturn:
 	lw    $s0,  0($sp)
 	lw    $s1,  4($sp)
@@ -0,0 +1,33 @@
+/*
+ * PSn00bSDK profiling library (on-screen statistics)
+ * (C) 2022-2023 spicyjpeg - MPL licensed
+ *
+ * This is kept separate from the rest of the library, and from ProfLog() in
+ * log.c, so that the font library is only linked in if ProfPrint() is used.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <psxgpu.h>
+#include <psxprof.h>
+
+/* Internal API (see prof.c) */
+
+void _prof_format_line(
+	char *output, size_t size, const PROF_Marker *marker, uint32_t frame_time
+);
+
+/* Public API */
+
+void ProfPrint(int stream) {
+	PROF_Marker *marker = ProfGetMarkers();
+	uint32_t    frame   = marker->avg;
+	char        line[40];
+
+	FntPrint(stream, "%-8s%6s%6s%6s%5s\n", "us", "min", "avg", "max", "");
+
+	for (; marker; marker = marker->next) {
+		_prof_format_line(line, sizeof(line), marker, frame);
+		FntPrint(stream, "%s", line);
+	}
+}
@@ -0,0 +1,31 @@
+/*
+ * PSn00bSDK profiling library (serial statistics output)
+ * (C) 2022-2023 spicyjpeg - MPL licensed
+ *
+ * This is kept separate from ProfPrint() in hud.c, so that the serial port
+ * library is only linked in if ProfLog() is used.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <psxsio.h>
+#include <psxprof.h>
+
+/* Internal API (see prof.c) */
+
+void _prof_format_line(
+	char *output, size_t size, const PROF_Marker *marker, uint32_t frame_time
+);
+
+/* Public API */
+
+void ProfLog(void) {
+	PROF_Marker *marker = ProfGetMarkers();
+	uint32_t    frame   = marker->avg;
+	char        line[40];
+
+	for (; marker; marker = marker->next) {
+		_prof_format_line(line, sizeof(line), marker, frame);
+		SIO_Log("prof: %s", line);
+	}
+}
@@ -0,0 +1,222 @@
+/*
+ * PSn00bSDK profiling library (timing and statistics)
+ * (C) 2022-2023 spicyjpeg - MPL licensed
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+#include <stdio.h>
+#include <psxapi.h>
+#include <psxprof.h>
+#include <hwregs_c.h>
+
+#define DEFAULT_WINDOW	60
+
+// Root counter 2 in free-running mode, clocked at 1/8 of the system clock.
+#define TIMER2_MODE		0x0200
+
+// Approximate number of ticks per horizontal blank (63.6 us on NTSC, 64 us on
+// PAL). Only used to count how many times the 16-bit counter wrapped around
+// between two reads, so a small error is harmless.
+#define TICKS_PER_LINE	270
+
+/* Internal globals */
+
+static PROF_Marker _frame_marker = PROF_MARKER("frame");
+static PROF_Marker *_last_marker = &_frame_marker;
+
+static uint32_t _now         = 0;
+static uint16_t _last_value  = 0;
+static uint16_t _last_hblank = 0;
+
+static int _window       = DEFAULT_WINDOW;
+static int _window_count = 0;
+static int _timer_started = 0;
+
+/* Private utilities */
+
+static void _reset_window(PROF_Marker *marker) {
+	marker->window_min   = 0xffffffff;
+	marker->window_max   = 0;
+	marker->window_total = 0;
+	marker->window_calls = 0;
+}
+
+static void _clear(PROF_Marker *marker) {
+	marker->registered  = 1;
+	marker->frame_time  = 0;
+	marker->frame_calls = 0;
+	marker->min         = 0;
+	marker->avg         = 0;
+	marker->max         = 0;
+	marker->calls       = 0;
+	_reset_window(marker);
+}
+
+static void _register(PROF_Marker *marker) {
+	_clear(marker);
+
+	marker->next       = (void *) 0;
+	_last_marker->next = marker;
+	_last_marker       = marker;
+}
+
+/* Internal API (shared with trace.c, hud.c and log.c) */
+
+// The timer is only set up once, so that timestamps keep increasing if both
+// ProfInit() and ProfTraceInit() are called.
+void _prof_init_timer(void) {
+	if (_timer_started)
+		return;
+
+	FastEnterCriticalSection();
+
+	TIMER_CTRL(2) = TIMER2_MODE;
+
+	_now         = 0;
+	_last_value  = TIMER_VALUE(2);
+	_last_hblank = TIMER_VALUE(1);
+
+	_timer_started = 1;
+
+	FastExitCriticalSection();
+}
+
+// Formats the statistics of a marker as a line of the table printed by
+// ProfPrint() and ProfLog(), with its average as a percentage of frame_time.
+void _prof_format_line(
+	char *output, size_t size, const PROF_Marker *marker, uint32_t frame_time
+) {
+	int percentage = frame_time ? ((marker->avg * 100) / frame_time) : 0;
+
+	snprintf(
+		output,
+		size,
+		"%-8.8s%6d%6d%6d%4d%%\n",
+		marker->name,
+		ProfTicksToUs(marker->min),
+		ProfTicksToUs(marker->avg),
+		ProfTicksToUs(marker->max),
+		percentage
+	);
+}
+
+/* Public API */
+
+void ProfInit(int window) {
+	_prof_init_timer();
+
+	_window       = window ? window : DEFAULT_WINDOW;
+	_window_count = 0;
+
+	// Markers registered before a reinitialization stay in the list but their
+	// statistics are cleared.
+	for (PROF_Marker *marker = &_frame_marker; marker; marker = marker->next) {
+		_clear(marker);
+		marker->depth = 0;
+	}
+
+	_frame_marker.start = 0;
+}
+
+uint32_t ProfGetTime(void) {
+	FastEnterCriticalSection();
+
+	uint16_t value  = TIMER_VALUE(2);
+	uint16_t hblank = TIMER_VALUE(1);
+
+	uint32_t delta = (uint16_t) (value - _last_value);
+	uint32_t lines = (uint16_t) (hblank - _last_hblank);
+
+	// If more than half of the counter's period has elapsed according to the
+	// horizontal blank count, add the number of whole wraparounds that best
+	// matches it.
+	uint32_t expected = lines * TICKS_PER_LINE;
+
+	if (expected > 0x8000)
+		delta += (expected + 0x8000 - delta) & 0xffff0000;
+
+	_now        += delta;
+	_last_value  = value;
+	_last_hblank = hblank;
+
+	uint32_t now = _now;
+
+	FastExitCriticalSection();
+	return now;
+}
+
+uint32_t ProfTicksToUs(uint32_t ticks) {
+	// 1 tick = 8 / 33.8688 MHz = 0.23621 us ~= 3870 / 16384 us
+	return (ticks * 3870) >> 14;
+}
+
+void ProfBegin(PROF_Marker *marker) {
+	if (marker->depth++)
+		return;
+	if (!marker->registered)
+		_register(marker);
+
+	marker->start = ProfGetTime();
+}
+
+void ProfEnd(PROF_Marker *marker) {
+	if (!marker->depth) {
+		_sdk_log("ProfEnd() without ProfBegin() on %s\n", marker->name);
+		return;
+	}
+	if (--marker->depth)
+		return;
+
+	marker->frame_time += ProfGetTime() - marker->start;
+	marker->frame_calls++;
+}
+
+void ProfFrame(void) {
+	uint32_t now = ProfGetTime();
+
+	// The first call only marks the start of the first frame. A start time of
+	// zero is used to tell whether this is the first call.
+	uint32_t start      = _frame_marker.start;
+	_frame_marker.start = now ? now : 1;
+
+	if (!start)
+		return;
+
+	_frame_marker.frame_time  = now - start;
+	_frame_marker.frame_calls = 1;
+
+	for (PROF_Marker *marker = &_frame_marker; marker; marker = marker->next) {
+		uint32_t time = marker->frame_time;
+
+		if (time < marker->window_min)
+			marker->window_min = time;
+		if (time > marker->window_max)
+			marker->window_max = time;
+
+		marker->window_total += time;
+		marker->window_calls += marker->frame_calls;
+		marker->frame_time    = 0;
+		marker->frame_calls   = 0;
+	}
+
+	if (++_window_count < _window)
+		return;
+
+	// Publish the statistics for the window that just ended. The divisions are
+	// only done once per window.
+	for (PROF_Marker *marker = &_frame_marker; marker; marker = marker->next) {
+		marker->min   = marker->window_min;
+		marker->avg   = marker->window_total / _window_count;
+		marker->max   = marker->window_max;
+		marker->calls = marker->window_calls / _window_count;
+		_reset_window(marker);
+	}
+
+	_window_count = 0;
+}
+
+PROF_Marker *ProfGetMarkers(void) {
+	return &_frame_marker;
+}
@@ -0,0 +1,89 @@
+/*
+ * PSn00bSDK profiling library (function call tracing)
+ * (C) 2022-2023 spicyjpeg - MPL licensed
+ *
+ * When code is compiled with -finstrument-functions, GCC inserts calls to
+ * __cyg_profile_func_enter() and __cyg_profile_func_exit() at the beginning and
+ * end of every function. These record the function's address and a timestamp
+ * into a ring buffer, which is never read back on the console: the mod-builder
+ * dumps it from the emulator's RAM instead, locating it through the _prof_trace
+ * header, and turns it into a flame graph.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+#include <psxapi.h>
+#include <psxprof.h>
+#include <hwregs_c.h>
+
+#define TRACE_MAGIC	0x43525450 // "PTRC"
+
+#define _no_instrument	__attribute__((no_instrument_function))
+
+/* Internal globals */
+
+// The layout of this structure is relied upon by the mod-builder and shall not
+// be changed without updating profiler.py accordingly.
+PROF_TraceHeader _prof_trace = {
+	.magic    = TRACE_MAGIC,
+	.entries  = (void *) 0,
+	.mask     = 0,
+	.count    = 0,
+	.enabled  = 0
+};
+
+void _prof_init_timer(void);
+
+/* Private utilities */
+
+static inline void _no_instrument _record(uint32_t value) {
+	if (!_prof_trace.enabled)
+		return;
+
+	// Interrupts are disabled so that events logged from IRQ handlers can't
+	// end up interleaved with this one.
+	FastEnterCriticalSection();
+
+	uint32_t *entry = &_prof_trace.entries[(_prof_trace.count & _prof_trace.mask) * 2];
+	entry[0]        = value;
+	entry[1]        = ProfGetTime();
+	_prof_trace.count++;
+
+	FastExitCriticalSection();
+}
+
+/* Public API */
+
+int _no_instrument ProfTraceInit(uint32_t *buffer, size_t length) {
+	// Checked explicitly rather than through _sdk_validate_args(), as a bad
+	// length would make every instrumented call write out of bounds.
+	if (!buffer || !length || (length & (length - 1)))
+		return -1;
+
+	_prof_init_timer();
+
+	_prof_trace.enabled = 0;
+	_prof_trace.entries = buffer;
+	_prof_trace.mask    = length - 1;
+	_prof_trace.count   = 0;
+	_prof_trace.enabled = 1;
+	return 0;
+}
+
+void _no_instrument ProfTraceEnable(int enable) {
+	if (_prof_trace.entries)
+		_prof_trace.enabled = enable;
+}
+
+/* GCC instrumentation hooks */
+
+// Function addresses are always 4-byte aligned, so the lowest bit is used to
+// tell exit events apart from enter events.
+void _no_instrument __cyg_profile_func_enter(void *func, void *call_site) {
+	_record((uint32_t) func);
+}
+
+void _no_instrument __cyg_profile_func_exit(void *func, void *call_site) {
+	_record((uint32_t) func | 1);
+}
@@ -0,0 +1,138 @@
+/*
+ * PSn00bSDK serial port buffered logging
+ * (C) 2022-2023 spicyjpeg - MPL licensed
+ *
+ * Messages are formatted into a ring buffer in main RAM and moved to the TX
+ * buffer later on, either from the serial port's IRQ handler (whenever the TX
+ * buffer runs empty) or by calling SIO_FlushLog(), e.g. from a VSync callback.
+ * Logging never waits for the serial port: messages that don't fit into the
+ * ring buffer are dropped and counted instead.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <assert.h>
+#include <psxapi.h>
+#include <psxsio.h>
+
+#define DEFAULT_LOG_LENGTH	2048
+#define MAX_MESSAGE_LENGTH	128
+
+/* Internal globals */
+
+static char _default_log_data[DEFAULT_LOG_LENGTH];
+
+// Same layout as the ring buffers in sio.c: free-running indices masked by a
+// power-of-two length.
+static volatile struct {
+	char		*data;
+	uint32_t	mask;
+	uint32_t	head, tail;
+} _log = {
+	.data = _default_log_data,
+	.mask = DEFAULT_LOG_LENGTH - 1
+};
+
+static volatile uint32_t _dropped = 0;
+
+/* Private utilities */
+
+// Must be called with interrupts disabled.
+static void _flush_log(void) {
+	uint32_t head = _log.head;
+	uint32_t tail = _log.tail;
+
+	// The pending data may wrap around the end of the ring buffer, in which
+	// case it is sent in two chunks.
+	while (head != tail) {
+		uint32_t offset = head & _log.mask;
+		uint32_t length = tail - head;
+
+		if (length > (_log.mask + 1 - offset))
+			length = _log.mask + 1 - offset;
+
+		int _write = SIO_Write((const void *) &_log.data[offset], length);
+		head      += _write;
+
+		if ((uint32_t) _write < length)
+			break;
+	}
+
+	_log.head = head;
+}
+
+/* Public API */
+
+int SIO_InitLog(char *buffer, size_t length) {
+	if (!buffer) {
+		buffer = _default_log_data;
+		length = DEFAULT_LOG_LENGTH;
+	}
+
+	_sdk_validate_args(length && !(length & (length - 1)), -1);
+
+	FastEnterCriticalSection();
+
+	_log.data = buffer;
+	_log.mask = length - 1;
+	_log.head = 0;
+	_log.tail = 0;
+	_dropped  = 0;
+
+	SIO_WriteCallback(&_flush_log);
+
+	FastExitCriticalSection();
+	return 0;
+}
+
+int SIO_Log(const char *fmt, ...) {
+	char    message[MAX_MESSAGE_LENGTH];
+	va_list ap;
+
+	// Formatting is done outside of the critical section, as it is by far the
+	// slowest part. Messages longer than MAX_MESSAGE_LENGTH are truncated.
+	va_start(ap, fmt);
+	int length = vsnprintf(message, sizeof(message), fmt, ap);
+	va_end(ap);
+
+	if (length <= 0)
+		return 0;
+	if (length >= (int) sizeof(message))
+		length = sizeof(message) - 1;
+
+	FastEnterCriticalSection();
+
+	uint32_t tail = _log.tail;
+
+	if (((_log.mask + 1) - (tail - _log.head)) < (uint32_t) length) {
+		_dropped++;
+
+		FastExitCriticalSection();
+		return -1;
+	}
+
+	for (int i = 0; i < length; i++)
+		_log.data[(tail++) & _log.mask] = message[i];
+
+	_log.tail = tail;
+
+	FastExitCriticalSection();
+	return length;
+}
+
+void SIO_FlushLog(void) {
+	FastEnterCriticalSection();
+	_flush_log();
+	FastExitCriticalSection();
+}
+
+uint32_t SIO_GetLogDropped(int reset) {
+	uint32_t dropped = _dropped;
+
+	if (reset)
+		_dropped = 0;
+
+	return dropped;
+}
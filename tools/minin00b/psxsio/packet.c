@@ -0,0 +1,192 @@
+/*
+ * PSn00bSDK serial port packet framing
+ * (C) 2022-2023 spicyjpeg - MPL licensed
+ *
+ * Packets are framed as follows (all fields little endian):
+ *
+ *   "PK" magic | 16-bit payload length | payload | 16-bit CRC
+ *
+ * The CRC is CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xffff)
+ * computed over the length field and the payload.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+#include <psxsio.h>
+
+#define PACKET_MAGIC1		'P'
+#define PACKET_MAGIC2		'K'
+#define CRC_INITIAL_VALUE	0xffff
+#define SIO_SYNC_TIMEOUT	0x100000
+
+/* Private types */
+
+typedef enum {
+	STATE_MAGIC1	= 0,
+	STATE_MAGIC2	= 1,
+	STATE_LENGTH1	= 2,
+	STATE_LENGTH2	= 3,
+	STATE_PAYLOAD	= 4,
+	STATE_CRC1		= 5,
+	STATE_CRC2		= 6
+} ParserState;
+
+/* Internal globals */
+
+// 4-bit lookup table (32 bytes rather than 512 for a full table), each byte is
+// processed in two steps.
+static const uint16_t _crc_table[16] = {
+	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+	0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef
+};
+
+static struct {
+	ParserState	state;
+	uint16_t	length, offset, crc, packet_crc;
+} _parser = { .state = STATE_MAGIC1 };
+
+/* Private utilities */
+
+static uint16_t _update_crc(uint16_t crc, const uint8_t *data, size_t length) {
+	for (; length; length--) {
+		crc ^= *(data++) << 8;
+		crc  = (crc << 4) ^ _crc_table[crc >> 12];
+		crc  = (crc << 4) ^ _crc_table[crc >> 12];
+	}
+
+	return crc;
+}
+
+// Writes the entire buffer, flushing the TX buffer manually whenever it is full
+// so that this also works with interrupts disabled. Gives up if no progress is
+// made for too long (e.g. if CTS is never asserted).
+static int _write_all(const uint8_t *data, size_t length) {
+	for (int i = SIO_SYNC_TIMEOUT; length; i--) {
+		if (!i)
+			return -1;
+
+		int _write = SIO_Write(data, length);
+
+		if (_write) {
+			data   += _write;
+			length -= _write;
+			i       = SIO_SYNC_TIMEOUT;
+		} else {
+			SIO_FlushTX();
+		}
+	}
+
+	return 0;
+}
+
+/* Public API */
+
+int SIO_SendPacket(const void *data, size_t length) {
+	_sdk_validate_args(data && length && (length <= SIO_MAX_PACKET_LENGTH), -1);
+
+	uint8_t header[4] = {
+		PACKET_MAGIC1,
+		PACKET_MAGIC2,
+		(uint8_t) length,
+		(uint8_t) (length >> 8)
+	};
+
+	uint16_t crc = _update_crc(CRC_INITIAL_VALUE, &header[2], 2);
+	crc          = _update_crc(crc, (const uint8_t *) data, length);
+
+	uint8_t footer[2] = { (uint8_t) crc, (uint8_t) (crc >> 8) };
+
+	if (_write_all(header, sizeof(header)))
+		return -1;
+	if (_write_all((const uint8_t *) data, length))
+		return -1;
+
+	return _write_all(footer, sizeof(footer));
+}
+
+int SIO_ReceivePacket(void *data, size_t max_length) {
+	uint8_t *ptr = (uint8_t *) data;
+
+	for (;;) {
+		// Copy the payload in bulk rather than one byte at a time.
+		if (_parser.state == STATE_PAYLOAD) {
+			int _read = SIO_Read(
+				&ptr[_parser.offset],
+				_parser.length - _parser.offset
+			);
+			if (!_read)
+				return 0;
+
+			_parser.crc     = _update_crc(_parser.crc, &ptr[_parser.offset], _read);
+			_parser.offset += _read;
+
+			if (_parser.offset == _parser.length)
+				_parser.state = STATE_CRC1;
+
+			continue;
+		}
+
+		int value = SIO_ReadByte2();
+
+		if (value < 0)
+			return 0;
+
+		switch (_parser.state) {
+			case STATE_MAGIC1:
+				if (value == PACKET_MAGIC1)
+					_parser.state = STATE_MAGIC2;
+				break;
+
+			case STATE_MAGIC2:
+				if (value == PACKET_MAGIC2)
+					_parser.state = STATE_LENGTH1;
+				else if (value != PACKET_MAGIC1)
+					_parser.state = STATE_MAGIC1;
+				break;
+
+			case STATE_LENGTH1:
+				_parser.length = value;
+				_parser.state  = STATE_LENGTH2;
+				break;
+
+			case STATE_LENGTH2:
+				_parser.length |= value << 8;
+				_parser.offset  = 0;
+				_parser.state   = STATE_PAYLOAD;
+
+				if (!_parser.length || (_parser.length > max_length)) {
+					_sdk_log("invalid packet length %d\n", _parser.length);
+					_parser.state = STATE_MAGIC1;
+					return -1;
+				}
+
+				uint8_t length[2] = { (uint8_t) _parser.length, (uint8_t) value };
+				_parser.crc       = _update_crc(CRC_INITIAL_VALUE, length, 2);
+				break;
+
+			case STATE_CRC1:
+				_parser.packet_crc = value;
+				_parser.state      = STATE_CRC2;
+				break;
+
+			case STATE_CRC2:
+				_parser.packet_crc |= value << 8;
+				_parser.state       = STATE_MAGIC1;
+
+				if (_parser.packet_crc != _parser.crc) {
+					_sdk_log("packet CRC mismatch\n");
+					return -1;
+				}
+
+				return _parser.length;
+
+			default:
+				break;
+		}
+	}
+}
+
+void SIO_ResetPacketParser(void) {
+	_parser.state = STATE_MAGIC1;
+}
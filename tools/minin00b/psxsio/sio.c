@@ -6,20 +6,27 @@
  */
 
 #include <stdint.h>
+#include <stddef.h>
 #include <assert.h>
 #include <psxetc.h>
 #include <psxapi.h>
 #include <psxsio.h>
 #include <hwregs_c.h>
 
-#define BUFFER_LENGTH		128
-#define SIO_SYNC_TIMEOUT	0x100000
+#define DEFAULT_BUFFER_LENGTH	256
+#define SIO_SYNC_TIMEOUT		0x100000
 
 /* Private types */
 
+// The head and tail indices are free-running and only masked when accessing
+// the buffer, so the length is always tail - head (even after wrapping around)
+// and the buffer can be completely filled. The IRQ handler only ever moves one
+// of the two indices of each buffer, so most accesses from the main thread
+// don't require disabling interrupts.
 typedef struct {
-	uint8_t data[BUFFER_LENGTH];
-	uint8_t head, tail, length;
+	uint8_t		*data;
+	uint32_t	mask;
+	uint32_t	head, tail;
 } RingBuffer;
 
 /* Internal globals */
@@ -28,9 +35,49 @@ static SIO_FlowControl _flow_control;
 static uint16_t _ctrl_reg_flag;
 
 static int  (*_read_callback)(uint8_t) = (void *) 0;
+static void (*_write_callback)(void)   = (void *) 0;
 static void (*_old_sio_handler)(void)  = (void *) 0;
 
-static volatile RingBuffer _tx_buffer, _rx_buffer;
+static uint8_t _default_tx_data[DEFAULT_BUFFER_LENGTH];
+static uint8_t _default_rx_data[DEFAULT_BUFFER_LENGTH];
+
+static volatile RingBuffer _tx_buffer = {
+	.data = _default_tx_data,
+	.mask = DEFAULT_BUFFER_LENGTH - 1
+};
+static volatile RingBuffer _rx_buffer = {
+	.data = _default_rx_data,
+	.mask = DEFAULT_BUFFER_LENGTH - 1
+};
+
+/* Private utilities */
+
+static inline size_t _length(volatile RingBuffer *buffer) {
+	return buffer->tail - buffer->head;
+}
+
+static inline size_t _space(volatile RingBuffer *buffer) {
+	return (buffer->mask + 1) - (buffer->tail - buffer->head);
+}
+
+// Moves as many bytes from the TX buffer to the serial port as the hardware
+// can currently accept (up to 2, one in the holding register and one in the
+// shift register) and enables the TX IRQ if there is more data left. Must be
+// called with interrupts disabled.
+static void _flush_tx(void) {
+	uint32_t head = _tx_buffer.head;
+	uint32_t tail = _tx_buffer.tail;
+
+	while ((head != tail) && (SIO_STAT(1) & SR_TXRDY))
+		SIO_DATA(1) = _tx_buffer.data[(head++) & _tx_buffer.mask];
+
+	_tx_buffer.head = head;
+
+	if (head != tail)
+		SIO_CTRL(1) |= CR_TXIEN;
+	else
+		SIO_CTRL(1) &= CR_TXIEN ^ 0xffff;
+}
 
 /* Private interrupt handler */
 
@@ -46,40 +93,28 @@ static void _sio_handler(void) {
 				continue;
 		}
 
-		int length = _rx_buffer.length;
-
-		if (length >= BUFFER_LENGTH) {
+		if (!_space(&_rx_buffer)) {
 			//_sdk_log("RX overrun, dropping bytes\n");
 			break;
 		}
 
-		int tail          = _rx_buffer.tail;
-		_rx_buffer.tail   = (tail + 1) % BUFFER_LENGTH;
-		_rx_buffer.length = length + 1;
+		uint32_t tail = _rx_buffer.tail;
 
-		_rx_buffer.data[tail] = value;
+		_rx_buffer.data[tail & _rx_buffer.mask] = value;
+		_rx_buffer.tail = tail + 1;
 	}
 
-	// Send the next byte in the buffer if the TX unit is ready. Note that
-	// checking for CTS is unnecessary as the serial port is already hardwired
-	// to do so.
-	if (SIO_STAT(1) & (SR_TXRDY | SR_TXU)) {
-		int length = _tx_buffer.length;
-
-		if (length) {
-			int head          = _tx_buffer.head;
-			_tx_buffer.head   = (head + 1) % BUFFER_LENGTH;
-			_tx_buffer.length = length - 1;
-
-			SIO_CTRL(1) |= CR_TXIEN;
-			SIO_DATA(1)  = _tx_buffer.data[head];
-		} else {
-			SIO_CTRL(1) &= CR_TXIEN ^ 0xffff;
-		}
-	}
+	// Give the write callback a chance to refill the TX buffer once it runs
+	// dry, then send the next bytes in the buffer if the TX unit is ready. Note
+	// that checking for CTS is unnecessary as the serial port is already
+	// hardwired to do so.
+	if (_write_callback && !_length(&_tx_buffer))
+		_write_callback();
+
+	_flush_tx();
 
 	// Acknowledge the IRQ and update flow control signals.
-	if (_rx_buffer.length < BUFFER_LENGTH)
+	if (_space(&_rx_buffer))
 		SIO_CTRL(1) = CR_INTRST | (SIO_CTRL(1) | _ctrl_reg_flag);
 	else
 		SIO_CTRL(1) = CR_INTRST | (SIO_CTRL(1) & (_ctrl_reg_flag ^ 0xffff));
@@ -96,12 +131,10 @@ void SIO_Init(int baud, uint16_t mode) {
 	SIO_BAUD(1) = (uint16_t) ((int) 0x1fa400 / baud);
 	SIO_CTRL(1) = CR_TXEN | CR_RXEN | CR_RXIEN;
 
-	_tx_buffer.head   = 0;
-	_tx_buffer.tail   = 0;
-	_tx_buffer.length = 0;
-	_rx_buffer.head   = 0;
-	_rx_buffer.tail   = 0;
-	_rx_buffer.length = 0;
+	_tx_buffer.head = 0;
+	_tx_buffer.tail = 0;
+	_rx_buffer.head = 0;
+	_rx_buffer.tail = 0;
 
 	_flow_control  = SIO_FC_NONE;
 	_ctrl_reg_flag = 0;
@@ -120,6 +153,41 @@ void SIO_Quit(void) {
 		ExitCriticalSection();
 }
 
+int SIO_SetBuffers(uint8_t *tx, size_t tx_length, uint8_t *rx, size_t rx_length) {
+	if (!tx) {
+		tx        = _default_tx_data;
+		tx_length = DEFAULT_BUFFER_LENGTH;
+	}
+	if (!rx) {
+		rx        = _default_rx_data;
+		rx_length = DEFAULT_BUFFER_LENGTH;
+	}
+
+	// Lengths must be powers of two so that indices can be masked.
+	_sdk_validate_args(
+		tx_length && !(tx_length & (tx_length - 1)) &&
+		rx_length && !(rx_length & (rx_length - 1)),
+		-1
+	);
+
+	FastEnterCriticalSection();
+
+	// Any pending data is discarded.
+	_tx_buffer.data = tx;
+	_tx_buffer.mask = tx_length - 1;
+	_tx_buffer.head = 0;
+	_tx_buffer.tail = 0;
+	_rx_buffer.data = rx;
+	_rx_buffer.mask = rx_length - 1;
+	_rx_buffer.head = 0;
+	_rx_buffer.tail = 0;
+
+	SIO_CTRL(1) &= CR_TXIEN ^ 0xffff;
+
+	FastExitCriticalSection();
+	return 0;
+}
+
 void SIO_SetFlowControl(SIO_FlowControl mode) {
 	FastEnterCriticalSection();
 
@@ -153,38 +221,51 @@ void SIO_SetFlowControl(SIO_FlowControl mode) {
 
 int SIO_ReadByte(void) {
 	/*for (int i = SIO_SYNC_TIMEOUT; i; i--) {
-		if (_rx_buffer.length)
+		if (_length(&_rx_buffer))
 			return SIO_ReadByte2();
 	}*/
-	while (!_rx_buffer.length)
+	while (!_length(&_rx_buffer))
 		__asm__ volatile("");
 
 	return SIO_ReadByte2();
 }
 
 int SIO_ReadByte2(void) {
-	if (!_rx_buffer.length)
+	uint32_t head = _rx_buffer.head;
+
+	if (head == _rx_buffer.tail)
 		return -1;
 
-	FastEnterCriticalSection();
+	int value       = _rx_buffer.data[head & _rx_buffer.mask];
+	_rx_buffer.head = head + 1;
+
+	return value;
+}
 
-	int head        = _rx_buffer.head;
-	_rx_buffer.head = (head + 1) % BUFFER_LENGTH;
-	_rx_buffer.length--;
+int SIO_Read(void *data, size_t length) {
+	uint8_t  *ptr  = (uint8_t *) data;
+	uint32_t head  = _rx_buffer.head;
+	size_t   _read = _rx_buffer.tail - head;
 
-	FastExitCriticalSection();
-	return _rx_buffer.data[head];
+	if (_read > length)
+		_read = length;
+
+	for (size_t i = _read; i; i--)
+		*(ptr++) = _rx_buffer.data[(head++) & _rx_buffer.mask];
+
+	_rx_buffer.head = head;
+	return _read;
 }
 
 int SIO_ReadSync(int mode) {
 	if (mode)
-		return _rx_buffer.length;
+		return _length(&_rx_buffer);
 
 	/*for (int i = SIO_SYNC_TIMEOUT; i; i--) {
-		if (_rx_buffer.length)
+		if (_length(&_rx_buffer))
 			return 0;
 	}*/
-	while (!_rx_buffer.length)
+	while (!_length(&_rx_buffer))
 		__asm__ volatile("");
 
 	return 0;
@@ -197,13 +278,24 @@ void *SIO_ReadCallback(int (*func)(uint8_t)) {
 	_read_callback      = func;
 
 	FastExitCriticalSection();
+	return old_callback;
 }
 
 /* Writing API */
 
+void *SIO_WriteCallback(void (*func)(void)) {
+	FastEnterCriticalSection();
+
+	void *old_callback  = _write_callback;
+	_write_callback     = func;
+
+	FastExitCriticalSection();
+	return old_callback;
+}
+
 int SIO_WriteByte(uint8_t value) {
 	for (int i = SIO_SYNC_TIMEOUT; i; i--) {
-		if (_tx_buffer.length < BUFFER_LENGTH)
+		if (_space(&_tx_buffer))
 			return SIO_WriteByte2(value);
 	}
 
@@ -212,51 +304,71 @@ int SIO_WriteByte(uint8_t value) {
 }
 
 int SIO_WriteByte2(uint8_t value) {
-	// If the TX unit is currently busy, append the byte to the buffer instead
-	// of sending it immediately. Note that interrupts must be disabled *prior*
-	// to checking if TX is busy; disabling them afterwards would create a race
+	// The byte is always appended to the buffer, then sent immediately if the
+	// TX unit is idle. Note that interrupts must be disabled *prior* to
+	// checking if TX is busy; disabling them afterwards would create a race
 	// condition where the transfer could end while interrupts are being
 	// disabled. Interrupts are disabled through the IRQ_MASK register rather
 	// than via syscalls for performance reasons.
 	FastEnterCriticalSection();
 
-	if (SIO_STAT(1) & (SR_TXRDY | SR_TXU)) {
-		SIO_DATA(1) = value;
-		FastExitCriticalSection();
-		return 0;
-	}
-
-	int length = _tx_buffer.length;
+	int length = _length(&_tx_buffer);
 
-	if (length >= BUFFER_LENGTH) {
+	if (!_space(&_tx_buffer)) {
 		FastExitCriticalSection();
 
 		//_sdk_log("TX overrun, dropping bytes\n");
 		return -1;
 	}
 
-	int tail          = _tx_buffer.tail;
-	_tx_buffer.tail   = (tail + 1) % BUFFER_LENGTH;
-	_tx_buffer.length = length + 1;
+	uint32_t tail = _tx_buffer.tail;
 
-	_tx_buffer.data[tail] = value;
-	SIO_CTRL(1) |= CR_TXIEN;
+	_tx_buffer.data[tail & _tx_buffer.mask] = value;
+	_tx_buffer.tail = tail + 1;
+	_flush_tx();
 
 	FastExitCriticalSection();
 	return length;
 }
 
+int SIO_Write(const void *data, size_t length) {
+	const uint8_t *ptr = (const uint8_t *) data;
+
+	FastEnterCriticalSection();
+
+	uint32_t tail   = _tx_buffer.tail;
+	size_t   _write = _space(&_tx_buffer);
+
+	if (_write > length)
+		_write = length;
+
+	for (size_t i = _write; i; i--)
+		_tx_buffer.data[(tail++) & _tx_buffer.mask] = *(ptr++);
+
+	_tx_buffer.tail = tail;
+	_flush_tx();
+
+	FastExitCriticalSection();
+	return _write;
+}
+
+void SIO_FlushTX(void) {
+	FastEnterCriticalSection();
+	_flush_tx();
+	FastExitCriticalSection();
+}
+
 int SIO_WriteSync(int mode) {
 	if (mode)
-		return _tx_buffer.length;
+		return _length(&_tx_buffer);
 
 	// Wait for the buffer to become empty.
 	for (int i = SIO_SYNC_TIMEOUT; i; i--) {
-		if (!_tx_buffer.length)
+		if (!_length(&_tx_buffer))
 			break;
 	}
 
-	if (!_tx_buffer.length) {
+	if (!_length(&_tx_buffer)) {
 		// Wait for the TX unit to finish sending the last byte.
 		while (!(SIO_STAT(1) & (SR_TXRDY | SR_TXU)))
 			__asm__ volatile("");
@@ -264,5 +376,5 @@ int SIO_WriteSync(int mode) {
 		//_sdk_log("SIO_WriteSync() timeout\n");
 	}
 
-	return _tx_buffer.length;
+	return _length(&_tx_buffer);
 }
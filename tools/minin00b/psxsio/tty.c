@@ -2,10 +2,11 @@
  * PSn00bSDK serial port BIOS TTY driver
  * (C) 2019-2022 Lameguy64, spicyjpeg - MPL licensed
  *
- * This driver is designed to be as simple and reliable as possible: as such it
- * only relies on the SIO_*() API for receiving and sends data synchronously.
- * This allows printf() to work without issues, albeit slowly, if called from a
- * critical section or even from an interrupt handler.
+ * This driver is designed to be as simple and reliable as possible. Writes go
+ * through the TX buffer and only block once it is full, in which case the
+ * buffer is flushed by polling the serial port rather than by waiting for the
+ * TX IRQ. This allows printf() to work without issues if called from a critical
+ * section or even from an interrupt handler.
  */
 
 #include <sys/ioctl.h>
@@ -31,11 +32,13 @@ static int _sio_inout(FCB *fcb, int cmd) {
 			return fcb->trns_len;
 
 		case 2: // write
-			for (int i = 0; i < fcb->trns_len; i++) {
-				while (!(SIO_STAT(1) & (SR_TXRDY | SR_TXU)))
-					__asm__ volatile("");
+			for (int i = fcb->trns_len; i;) {
+				int length = SIO_Write(ptr, i);
+				ptr       += length;
+				i         -= length;
 
-				SIO_DATA(1) = *(ptr++);
+				if (i)
+					SIO_FlushTX();
 			}
 
 			return fcb->trns_len;
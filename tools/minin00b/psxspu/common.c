@@ -6,6 +6,7 @@
 #include <stdint.h>
 #include <assert.h>
 #include <psxetc.h>
+#include <psxapi.h>
 #include <psxspu.h>
 #include <hwregs_c.h>
 
@@ -14,16 +15,31 @@
 #define WRITABLE_AREA_ADDR	0x200
 #define DMA_CHUNK_LENGTH	16
 #define STATUS_TIMEOUT		0x100000
+#define QUEUE_LENGTH		16
 
 static const uint32_t _dummy_block[4] = {
 	0x00000500, 0x00000000, 0x00000000, 0x00000000
 };
 
+/* Private types */
+
+typedef struct {
+	uint32_t	*data;
+	size_t		length;
+	uint16_t	addr;
+	uint8_t		write;
+} TransferOp;
+
 /* Internal globals */
 
 static SPU_TransferMode	_transfer_mode = SPU_TRANSFER_BY_DMA;
 static uint16_t			_transfer_addr = WRITABLE_AREA_ADDR;
 
+static void (*_transfer_callback)(void) = (void *) 0;
+
+static volatile TransferOp	_transfer_queue[QUEUE_LENGTH];
+static volatile uint8_t		_queue_head, _queue_tail, _queue_length;
+
 /* Private utilities */
 
 static void _wait_status(uint16_t mask, uint16_t value) {
@@ -35,7 +51,7 @@ static void _wait_status(uint16_t mask, uint16_t value) {
 	_sdk_log("timeout, status=0x%04x\n", SPU_STAT);
 }
 
-static size_t _dma_transfer(uint32_t *data, size_t length, int write) {
+static size_t _dma_length(size_t length) {
 	if (length % 4)
 		_sdk_log("can't transfer a number of bytes that isn't multiple of 4\n");
 
@@ -43,8 +59,14 @@ static size_t _dma_transfer(uint32_t *data, size_t length, int write) {
 	if ((length >= DMA_CHUNK_LENGTH) && (length % DMA_CHUNK_LENGTH)) {
 		_sdk_log("transfer data length (%d) is not a multiple of %d, rounding\n", length, DMA_CHUNK_LENGTH);
 		length += DMA_CHUNK_LENGTH - 1;
+		length -= length % DMA_CHUNK_LENGTH;
 	}
 
+	return length;
+}
+
+// Length is in words and must have been already rounded by _dma_length().
+static void _dma_transfer(uint32_t *data, size_t length, uint16_t addr, int write) {
 	// Increase bus delay for DMA reads
 	BUS_SPU_CFG &= ~(0xf << 24);
 	if (!write)
@@ -56,7 +78,7 @@ static size_t _dma_transfer(uint32_t *data, size_t length, int write) {
 	// Enable DMA request for writing (2) or reading (3)
 	uint16_t ctrl = write ? 0x0020 : 0x0030;
 
-	SPU_ADDR  = _transfer_addr;
+	SPU_ADDR  = addr;
 	SPU_CTRL |= ctrl;
 	_wait_status(0x0030, ctrl);
 
@@ -68,7 +90,51 @@ static size_t _dma_transfer(uint32_t *data, size_t length, int write) {
 			((length / DMA_CHUNK_LENGTH) << 16);
 
 	DMA_CHCR(DMA_SPU) = 0x01000200 | write;
-	return length;
+}
+
+// Starts a DMA transfer or, if one is already in progress, appends it to the
+// queue to be started by the DMA IRQ handler. This is the same scheme used by
+// EnqueueDrawOp(), where _queue_length also counts the transfer in progress.
+static int _enqueue_transfer(uint32_t *data, size_t length, uint16_t addr, int write) {
+	FastEnterCriticalSection();
+	int queue_length = _queue_length;
+
+	if (!queue_length) {
+		_queue_length = 1;
+		FastExitCriticalSection();
+
+		_dma_transfer(data, length, addr, write);
+		return 0;
+	}
+	if (queue_length >= QUEUE_LENGTH) {
+		FastExitCriticalSection();
+
+		_sdk_log("transfer queue overflow, dropping transfer\n");
+		return -1;
+	}
+
+	int tail      = _queue_tail;
+	_queue_tail   = (tail + 1) % QUEUE_LENGTH;
+	_queue_length = queue_length + 1;
+
+	volatile TransferOp *entry = &_transfer_queue[tail];
+	entry->data   = data;
+	entry->length = length;
+	entry->addr   = addr;
+	entry->write  = write;
+
+	FastExitCriticalSection();
+	return queue_length;
+}
+
+static int _wait_queue(void) {
+	for (int i = STATUS_TIMEOUT; i; i--) {
+		if (!_queue_length)
+			return 0;
+	}
+
+	_sdk_log("transfer queue timeout\n");
+	return -1;
 }
 
 static size_t _manual_write(const uint16_t *data, size_t length) {
@@ -106,9 +172,43 @@ static size_t _manual_write(const uint16_t *data, size_t length) {
 	return length;
 }
 
+/* Private interrupt handlers */
+
+static void _spu_dma_handler(void) {
+	int length = _queue_length;
+	if (!length)
+		return;
+
+	if (--length) {
+		int head    = _queue_head;
+		_queue_head = (head + 1) % QUEUE_LENGTH;
+
+		volatile TransferOp *entry = &_transfer_queue[head];
+		_dma_transfer(entry->data, entry->length, entry->addr, entry->write);
+		_queue_length = length;
+	} else {
+		SPU_CTRL &= 0xffcf; // Disable DMA request
+
+		// The queue must already be idle when the callback runs, so that
+		// it can start the next transfer by calling SpuEnqueueWrite().
+		_queue_length = 0;
+		if (_transfer_callback)
+			_transfer_callback();
+	}
+}
+
 /* Public API */
 
 void SpuInit(void) {
+	_queue_head   = 0;
+	_queue_tail   = 0;
+	_queue_length = 0;
+
+	int _exit = EnterCriticalSection();
+	DMACallback(DMA_SPU, &_spu_dma_handler);
+	if (_exit)
+		ExitCriticalSection();
+
 	BUS_SPU_CFG = 0x200931e1;
 
 	SPU_CTRL = 0x0000; // SPU disabled
@@ -166,7 +266,11 @@ void SpuInit(void) {
 size_t SpuRead(uint32_t *data, size_t size) {
 	_sdk_validate_args(data && size, 0);
 
-	return _dma_transfer(data, size, 0) * 4;
+	size_t length = _dma_length(size);
+	if (_enqueue_transfer(data, length, _transfer_addr, 0) < 0)
+		return 0;
+
+	return length * 4;
 }
 
 size_t SpuWrite(const uint32_t *data, size_t size) {
@@ -177,11 +281,18 @@ size_t SpuWrite(const uint32_t *data, size_t size) {
 		return 0;
 	}
 
-	// I/O transfer mode is not that useful, but whatever.
-	if (_transfer_mode)
+	// I/O transfer mode is not that useful, but whatever. Manual transfers
+	// can't run alongside DMA, so any queued transfer has to be flushed first.
+	if (_transfer_mode) {
+		_wait_queue();
 		return _manual_write((const uint16_t *) data, size) * 2;
-	else
-		return _dma_transfer((uint32_t *) data, size, 1) * 4;
+	}
+
+	size_t length = _dma_length(size);
+	if (_enqueue_transfer((uint32_t *) data, length, _transfer_addr, 1) < 0)
+		return 0;
+
+	return length * 4;
 }
 
 size_t SpuWritePartly(const uint32_t *data, size_t size) {
@@ -189,10 +300,33 @@ size_t SpuWritePartly(const uint32_t *data, size_t size) {
 
 	size_t _size = SpuWrite(data, size);
 
-	_transfer_addr += (_size + 1) / 2;
+	_transfer_addr += getSPUAddr(_size);
 	return _size;
 }
 
+int SpuEnqueueWrite(const uint32_t *data, size_t size, uint32_t addr) {
+	_sdk_validate_args(data && size && (addr <= 0x7ffff), -1);
+
+	uint16_t _addr = getSPUAddr(addr);
+
+	if (_addr < WRITABLE_AREA_ADDR) {
+		_sdk_log("ignoring attempt to write to capture buffers at 0x%05x\n", _addr);
+		return -1;
+	}
+
+	return _enqueue_transfer((uint32_t *) data, _dma_length(size), _addr, 1);
+}
+
+void *SpuSetTransferCallback(void (*func)(void)) {
+	FastEnterCriticalSection();
+
+	void *old_callback = _transfer_callback;
+	_transfer_callback = func;
+
+	FastExitCriticalSection();
+	return old_callback;
+}
+
 SPU_TransferMode SpuSetTransferMode(SPU_TransferMode mode) {
 	_transfer_mode = mode;
 	return mode;
@@ -216,7 +350,10 @@ uint32_t SpuGetTransferStartAddr(void) {
 
 int SpuIsTransferCompleted(int mode) {
 	if (!mode)
-		return ((SPU_STAT >> 10) & 1) ^ 1;
+		return !_queue_length && !(SPU_STAT & 0x0400);
+
+	if (_wait_queue())
+		return 0;
 
 	_wait_status(0x0400, 0x0000);
 	return 1;
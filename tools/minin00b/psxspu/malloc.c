@@ -0,0 +1,222 @@
+/*
+ * PSn00bSDK SPU library (SPU RAM allocator)
+ * (C) 2022-2023 spicyjpeg - MPL licensed
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+#include <string.h>
+#include <psxspu.h>
+#include <hwregs_c.h>
+
+// The first 4 KB of SPU RAM hold the CD audio and voice capture buffers, while
+// the next 16 bytes are used by SpuInit() for a dummy looping ADPCM block. All
+// addresses below are in 8-byte units, as in SPU registers.
+#define HEAP_START_ADDR	0x202
+#define MIN_COMPACT_CHUNK	64
+
+/* Internal globals */
+
+// Allocated blocks, sorted by address. Free space is not tracked explicitly:
+// any gap between two blocks is free, so adjacent free areas are always merged.
+static SPU_MallocRec	*_blocks      = (void *) 0;
+static int				_max_blocks   = 0;
+static int				_num_blocks   = 0;
+static uint16_t			_heap_end     = 0;
+
+/* Private utilities */
+
+// Returns the index of the first block whose address is >= addr.
+static int _find_block(uint16_t addr) {
+	int low = 0, high = _num_blocks;
+
+	while (low < high) {
+		int mid = (low + high) / 2;
+
+		if (_blocks[mid].addr < addr)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return low;
+}
+
+static int _insert_block(int index, uint16_t addr, uint16_t size) {
+	if (_num_blocks >= _max_blocks) {
+		_sdk_log("out of allocation records\n");
+		return -1;
+	}
+
+	memmove(
+		&_blocks[index + 1],
+		&_blocks[index],
+		(_num_blocks - index) * sizeof(SPU_MallocRec)
+	);
+
+	_blocks[index].addr = addr;
+	_blocks[index].size = size;
+	_num_blocks++;
+
+	return addr * 8;
+}
+
+static inline uint16_t _block_end(int index) {
+	if (index < 0)
+		return HEAP_START_ADDR;
+
+	return _blocks[index].addr + _blocks[index].size;
+}
+
+/* Public API */
+
+void SpuInitMalloc(int num, SPU_MallocRec *table) {
+	_blocks     = table;
+	_max_blocks = num;
+	_num_blocks = 0;
+
+	// Anything past the start of the reverb work area is off limits. Reverb
+	// should thus be configured before the allocator is initialized.
+	_heap_end = SPU_REVERB_ADDR;
+}
+
+int SpuMalloc(int size) {
+	_sdk_validate_args((size > 0) && _blocks, -1);
+
+	uint16_t _size = getSPUAddr(size);
+
+	// First-fit search through the gaps between allocated blocks.
+	for (int i = 0; i <= _num_blocks; i++) {
+		uint16_t start = _block_end(i - 1);
+		uint16_t end   = (i < _num_blocks) ? _blocks[i].addr : _heap_end;
+
+		if ((end > start) && ((end - start) >= _size))
+			return _insert_block(i, start, _size);
+	}
+
+	_sdk_log("can't allocate %d bytes\n", size);
+	return -1;
+}
+
+int SpuMallocWithStartAddr(uint32_t addr, int size) {
+	_sdk_validate_args((size > 0) && (addr <= 0x7ffff) && _blocks, -1);
+
+	uint16_t start = addr / 8;
+	uint16_t end   = start + getSPUAddr(size);
+
+	if ((start < HEAP_START_ADDR) || (end > _heap_end)) {
+		_sdk_log("0x%05x is outside the heap\n", addr);
+		return -1;
+	}
+
+	int index = _find_block(start);
+
+	if ((_block_end(index - 1) > start) || ((index < _num_blocks) && (_blocks[index].addr < end))) {
+		_sdk_log("0x%05x is already allocated\n", addr);
+		return -1;
+	}
+
+	return _insert_block(index, start, end - start);
+}
+
+void SpuFree(uint32_t addr) {
+	uint16_t _addr = addr / 8;
+	int      index = _find_block(_addr);
+
+	if ((index >= _num_blocks) || (_blocks[index].addr != _addr)) {
+		_sdk_log("0x%05x was not allocated\n", addr);
+		return;
+	}
+
+	_num_blocks--;
+	memmove(
+		&_blocks[index],
+		&_blocks[index + 1],
+		(_num_blocks - index) * sizeof(SPU_MallocRec)
+	);
+}
+
+size_t SpuGetFreeSize(size_t *largest) {
+	size_t total = 0, _largest = 0;
+
+	for (int i = 0; i <= _num_blocks; i++) {
+		uint16_t start = _block_end(i - 1);
+		uint16_t end   = (i < _num_blocks) ? _blocks[i].addr : _heap_end;
+
+		if (end <= start)
+			continue;
+
+		size_t gap = (end - start) * 8;
+		total     += gap;
+
+		if (gap > _largest)
+			_largest = gap;
+	}
+
+	if (largest)
+		*largest = _largest;
+
+	return total;
+}
+
+int SpuMallocCompact(
+	uint32_t *buffer, size_t buffer_size, SPU_RelocateCallback callback
+) {
+	_sdk_validate_args(buffer && (buffer_size >= MIN_COMPACT_CHUNK), -1);
+
+	// Transfers must be a multiple of the DMA chunk size, so the buffer size is
+	// rounded down accordingly.
+	buffer_size -= buffer_size % MIN_COMPACT_CHUNK;
+
+	uint32_t old_addr = SpuGetTransferStartAddr();
+	int      moved    = 0;
+
+	SpuIsTransferCompleted(SPU_TRANSFER_WAIT);
+
+	for (int i = 0; i < _num_blocks; i++) {
+		uint32_t src  = _blocks[i].addr * 8;
+		uint32_t dest = _block_end(i - 1) * 8;
+		size_t   size = _blocks[i].size * 8;
+
+		if (src == dest)
+			continue;
+
+		// Blocks are only ever moved towards the beginning of SPU RAM and
+		// copied front to back, so overlapping moves are not an issue.
+		for (size_t offset = 0; offset < size; offset += buffer_size) {
+			size_t chunk = size - offset;
+			if (chunk > buffer_size)
+				chunk = buffer_size;
+
+			// Reads are rounded up to the DMA chunk size, as reading a few
+			// bytes past the end of the block is harmless. Writes are not, so
+			// any leftover data is written separately (transfers shorter than
+			// a DMA chunk do not have to be aligned).
+			size_t tail = chunk % MIN_COMPACT_CHUNK;
+
+			SpuSetTransferStartAddr(src + offset);
+			SpuRead(buffer, chunk + (tail ? (MIN_COMPACT_CHUNK - tail) : 0));
+			SpuIsTransferCompleted(SPU_TRANSFER_WAIT);
+
+			SpuSetTransferStartAddr(dest + offset);
+			if (chunk - tail) {
+				SpuWritePartly(buffer, chunk - tail);
+				SpuIsTransferCompleted(SPU_TRANSFER_WAIT);
+			}
+			if (tail) {
+				SpuWrite(&buffer[(chunk - tail) / 4], tail);
+				SpuIsTransferCompleted(SPU_TRANSFER_WAIT);
+			}
+		}
+
+		_blocks[i].addr = dest / 8;
+		moved++;
+
+		if (callback)
+			callback(src, dest, size);
+	}
+
+	SpuSetTransferStartAddr(old_addr);
+	return moved;
+}
@@ -0,0 +1,145 @@
+/*
+ * PSn00bSDK SPU library (voice allocator)
+ * (C) 2022-2023 spicyjpeg - MPL licensed
+ */
+
+#include <stdint.h>
+#include <assert.h>
+#include <psxapi.h>
+#include <psxspu.h>
+#include <hwregs_c.h>
+
+#define NUM_VOICES 24
+
+/* Internal globals */
+
+static uint32_t	_voice_mask = (1 << NUM_VOICES) - 1;
+static uint32_t	_voice_used = 0;
+static uint32_t	_alloc_counter = 0;
+
+static uint8_t	_voice_priority[NUM_VOICES];
+static uint32_t	_voice_age[NUM_VOICES];
+
+/* Private utilities */
+
+static void _key_off(int ch) {
+	uint32_t bit = 1 << ch;
+
+	SPU_KEY_OFF1 = (uint16_t) bit;
+	SPU_KEY_OFF2 = (uint16_t) (bit >> 16);
+}
+
+// Picks the voice to (re)use out of the given set: the one with the lowest
+// priority first, then the quietest one, then the one allocated longest ago.
+static int _pick_voice(uint32_t candidates) {
+	int      best          = -1;
+	int      best_priority = 0;
+	uint16_t best_volume   = 0;
+	uint32_t best_age      = 0;
+
+	for (int ch = 0; candidates; ch++, candidates >>= 1) {
+		if (!(candidates & 1))
+			continue;
+
+		int      priority = _voice_priority[ch];
+		uint16_t volume   = SPU_CH_ADSR_VOL(ch);
+		uint32_t age      = _alloc_counter - _voice_age[ch];
+
+		if (best >= 0) {
+			if (priority > best_priority)
+				continue;
+			if (priority == best_priority) {
+				if (volume > best_volume)
+					continue;
+				if ((volume == best_volume) && (age <= best_age))
+					continue;
+			}
+		}
+
+		best          = ch;
+		best_priority = priority;
+		best_volume   = volume;
+		best_age      = age;
+	}
+
+	return best;
+}
+
+/* Public API */
+
+uint32_t SpuSetVoiceAllocMask(uint32_t mask) {
+	FastEnterCriticalSection();
+
+	uint32_t old_mask = _voice_mask;
+	_voice_mask       = mask & ((1 << NUM_VOICES) - 1);
+	_voice_used      &= _voice_mask;
+
+	FastExitCriticalSection();
+	return old_mask;
+}
+
+int SpuAllocVoice(int priority) {
+	FastEnterCriticalSection();
+
+	// Free voices may still be in their release phase; _pick_voice() will pick
+	// a silent one if possible. If there are none, steal the allocated voice
+	// with the lowest priority, as long as it's not higher than the requested
+	// one.
+	uint32_t free_voices = _voice_mask & ~_voice_used;
+	int      ch;
+
+	if (free_voices) {
+		for (int i = 0; i < NUM_VOICES; i++) {
+			if (free_voices & (1 << i))
+				_voice_priority[i] = 0;
+		}
+
+		ch = _pick_voice(free_voices);
+	} else {
+		ch = _pick_voice(_voice_used & _voice_mask);
+
+		if ((ch >= 0) && (_voice_priority[ch] > priority))
+			ch = -1;
+		if (ch >= 0)
+			_key_off(ch);
+	}
+
+	if (ch >= 0) {
+		_voice_used        |= 1 << ch;
+		_voice_priority[ch] = priority;
+		_voice_age[ch]      = _alloc_counter++;
+	}
+
+	FastExitCriticalSection();
+
+	if (ch < 0)
+		_sdk_log("no voice available for priority %d\n", priority);
+
+	return ch;
+}
+
+void SpuFreeVoice(int ch) {
+	_sdk_validate_args_void((ch >= 0) && (ch < NUM_VOICES));
+
+	FastEnterCriticalSection();
+
+	if (_voice_used & (1 << ch))
+		_key_off(ch);
+
+	_voice_used &= ~(1 << ch);
+
+	FastExitCriticalSection();
+}
+
+int SpuSetVoicePriority(int ch, int priority) {
+	_sdk_validate_args((ch >= 0) && (ch < NUM_VOICES), -1);
+
+	int old_priority     = _voice_priority[ch];
+	_voice_priority[ch] = priority;
+
+	return old_priority;
+}
+
+uint32_t SpuGetAllocatedVoices(void) {
+	return _voice_used;
+}
@@ -0,0 +1,304 @@
+"""
+Encoder for SPU ADPCM samples
+
+Converts .wav files into the 16-byte ADPCM blocks played back by the SPU (the
+same format as _dummy_block in minin00b/psxspu/common.c), wrapped in a .VAG
+header. Each block holds 28 samples, encoded with whichever of the 5 prediction
+filters and 13 shift values gives the lowest error.
+"""
+from __future__ import annotations # to use type in python 3.7
+
+import concurrent.futures
+import logging
+import os
+import pathlib
+import struct
+import wave
+
+logger = logging.getLogger(__name__)
+
+# Prediction filter coefficients (in 1/64 units) applied to the last two
+# decoded samples, as implemented by the SPU
+FILTERS = (
+    (0, 0),
+    (60, 0),
+    (115, -52),
+    (98, -55),
+    (122, -60)
+)
+NUM_SHIFTS = 13
+
+SAMPLES_PER_BLOCK = 28
+BLOCK_SIZE = 16
+
+FLAG_LOOP_END = 1 << 0
+FLAG_LOOP_REPEAT = 1 << 1
+FLAG_LOOP_START = 1 << 2
+
+VAG_MAGIC = b"VAGp"
+VAG_VERSION = 0x20
+VAG_HEADER_SIZE = 48
+
+sounds = [] # global
+
+## Encoder
+
+def clamp16(value: int) -> int:
+    return max(-0x8000, min(0x7fff, value))
+
+def decode_block(block: bytes, hist: tuple[int, int]) -> tuple[list[int], tuple[int, int]]:
+    """ Reference decoder, returns (samples, history) """
+    shift = block[0] & 0xf
+    k0, k1 = FILTERS[block[0] >> 4]
+    s1, s2 = hist
+    samples = []
+    for i in range(SAMPLES_PER_BLOCK):
+        nibble = (block[2 + (i // 2)] >> ((i % 2) * 4)) & 0xf
+        nibble -= (nibble & 8) << 1
+        sample = clamp16(((nibble << 12) >> shift) + ((s1 * k0 + s2 * k1 + 32) >> 6))
+        samples.append(sample)
+        s1, s2 = sample, s1
+    return samples, (s1, s2)
+
+def try_block(samples: list[int], hist: tuple[int, int], filt: int, shift: int, bound: int) -> tuple[int, list[int], tuple[int, int]]:
+    """
+    Encodes a block with the given filter and shift, feeding decoded (rather
+    than original) samples back into the predictor the way the SPU does
+    Gives up as soon as the squared error reaches bound, returns
+    (error, nibbles, history)
+    """
+    k0, k1 = FILTERS[filt]
+    step = 1 << (12 - shift)
+    half = step >> 1
+    s1, s2 = hist
+    error = 0
+    nibbles = []
+    for sample in samples:
+        pred = (s1 * k0 + s2 * k1 + 32) >> 6
+        nibble = max(-8, min(7, (sample - pred + half) // step))
+        decoded = clamp16(nibble * step + pred)
+        error += (sample - decoded) ** 2
+        if error >= bound:
+            return error, None, None
+        nibbles.append(nibble & 0xf)
+        s1, s2 = decoded, s1
+    return error, nibbles, (s1, s2)
+
+def search_order(samples: list[int], hist: tuple[int, int], filters) -> list[tuple[int, int]]:
+    """
+    Orders the (filter, shift) candidates so that the likely best ones are tried
+    first: filters by their peak prediction residual on the source samples, and
+    for each filter the shift that just fits that residual, then its neighbours
+    """
+    estimates = []
+    for filt in filters:
+        k0, k1 = FILTERS[filt]
+        s1, s2 = hist
+        peak = 0
+        for sample in samples:
+            peak = max(peak, abs(sample - ((s1 * k0 + s2 * k1 + 32) >> 6)))
+            s1, s2 = sample, s1
+        shift = NUM_SHIFTS - 1
+        while shift > 0 and (7 << (12 - shift)) < peak:
+            shift -= 1
+        estimates.append((peak, filt, shift))
+
+    order = []
+    for _, filt, best_shift in sorted(estimates):
+        shifts = sorted(range(NUM_SHIFTS), key = lambda shift: abs(shift - best_shift))
+        order.extend((filt, shift) for shift in shifts)
+    return order
+
+def encode_block(samples: list[int], hist: tuple[int, int], flags: int = 0, filters = range(len(FILTERS))) -> tuple[bytes, tuple[int, int]]:
+    """
+    Searches every filter and shift combination for the one with the lowest
+    squared error. Candidates are bounded by the best error found so far, which
+    makes most of them bail out after a few samples without changing the result
+    of the exhaustive search
+    """
+    best = None
+    best_error = 1 << 62
+    for filt, shift in search_order(samples, hist, filters):
+        error, nibbles, new_hist = try_block(samples, hist, filt, shift, best_error)
+        if nibbles is not None:
+            best = (filt, shift, nibbles, new_hist)
+            best_error = error
+            if error == 0:
+                break
+
+    filt, shift, nibbles, new_hist = best
+    data = bytearray((shift | (filt << 4), flags))
+    for i in range(0, SAMPLES_PER_BLOCK, 2):
+        data.append(nibbles[i] | (nibbles[i + 1] << 4))
+    return bytes(data), new_hist
+
+def encode_samples(samples: list[int], loop_start: int = None) -> bytes:
+    """
+    Encodes 16-bit samples into ADPCM blocks. One-shot samples end with a block
+    flagged as loop end (the SPU then releases the voice), looping ones repeat
+    from the block at loop_start
+    Looping samples are padded at the beginning so that the loop starts on a
+    block boundary, and at the end with the beginning of the loop. The first
+    block of the loop only uses filter 0, as it must not depend on the samples
+    preceding it
+    """
+    samples = list(samples)
+    loop_block = None
+    if loop_start is not None:
+        padding = (-loop_start) % SAMPLES_PER_BLOCK
+        samples = ([0] * padding) + samples
+        loop_start += padding
+        loop = samples[loop_start:] or [0]
+        while len(samples) % SAMPLES_PER_BLOCK:
+            samples.append(loop[(len(samples) - loop_start) % len(loop)])
+        loop_block = loop_start // SAMPLES_PER_BLOCK
+    if not len(samples) or len(samples) % SAMPLES_PER_BLOCK:
+        samples += [0] * (SAMPLES_PER_BLOCK - (len(samples) % SAMPLES_PER_BLOCK))
+
+    num_blocks = len(samples) // SAMPLES_PER_BLOCK
+    hist = (0, 0)
+    data = bytearray()
+    for i in range(num_blocks):
+        flags = 0
+        filters = range(len(FILTERS))
+        if i == loop_block:
+            flags |= FLAG_LOOP_START
+            filters = (0,)
+        if i == num_blocks - 1:
+            flags |= FLAG_LOOP_END
+            if loop_block is not None:
+                flags |= FLAG_LOOP_REPEAT
+        block, hist = encode_block(samples[i * SAMPLES_PER_BLOCK:(i + 1) * SAMPLES_PER_BLOCK], hist, flags, filters)
+        data += block
+    return bytes(data)
+
+def build_vag(data: bytes, sample_rate: int, name: str) -> bytes:
+    header = struct.pack(">4sIIII12x16s", VAG_MAGIC, VAG_VERSION, 0, len(data), sample_rate, name.encode("ascii", "replace")[:16])
+    return header + data
+
+## Assets
+
+def read_loop_start(fname) -> tuple[int, int]:
+    """
+    Looks for a loop in the RIFF "smpl" chunk written by most audio editors,
+    returns (start, end) in samples or (None, None)
+    """
+    with open(fname, "rb") as file:
+        riff = file.read()
+    offset = 12
+    while offset + 8 <= len(riff):
+        chunk_id, chunk_size = struct.unpack_from("<4sI", riff, offset)
+        if chunk_id == b"smpl" and chunk_size >= 36 + 24:
+            num_loops = struct.unpack_from("<I", riff, offset + 8 + 28)[0]
+            if num_loops:
+                start, end = struct.unpack_from("<II", riff, offset + 8 + 36 + 8)
+                return start, end
+        offset += 8 + chunk_size + (chunk_size & 1)
+    return None, None
+
+def load_wav(fname) -> tuple[list[int], int]:
+    """ Returns (samples, sample_rate), stereo files are mixed down to mono """
+    with wave.open(str(fname), "rb") as wav:
+        channels = wav.getnchannels()
+        width = wav.getsampwidth()
+        rate = wav.getframerate()
+        frames = wav.readframes(wav.getnframes())
+
+    if width == 1:
+        values = [(value - 0x80) << 8 for value in frames]
+    elif width == 2:
+        values = list(struct.unpack(f"<{len(frames) // 2}h", frames))
+    else:
+        raise ValueError(f"{fname}: only 8 and 16-bit wav files are supported")
+
+    if channels == 1:
+        return values, rate
+    return [sum(values[i:i + channels]) // channels for i in range(0, len(values), channels)], rate
+
+def encode_file(fname, loop_start: int = None) -> tuple[bytes, int, int, int]:
+    """ Worker entry point, returns (data, sample_rate, num_samples, loop_start) """
+    samples, rate = load_wav(fname)
+    smpl_start, smpl_end = read_loop_start(fname)
+    if smpl_start is not None:
+        loop_start = smpl_start
+        samples = samples[:smpl_end + 1]
+    if loop_start is not None and loop_start >= len(samples):
+        logger.warning(f"{fname}: loop start is past the end of the sample, ignoring")
+        loop_start = None
+    return encode_samples(samples, loop_start), rate, len(samples), loop_start
+
+class Sound:
+    """
+    Class for SPU ADPCM assets
+
+    A .wav file is encoded to a .VAG file. The loop is taken from the smpl
+    chunk if there is one, or from the file name
+    """
+    def __init__(self, path: pathlib.Path) -> None:
+        self.valid = self.check_naming_convention(path.stem)
+        if not self.is_valid():
+            return
+
+        fname_parts = path.stem.split("_")
+        self.path = path
+        self.name = fname_parts[0]
+        self.loop_start = int(fname_parts[1]) if len(fname_parts) > 1 else None
+        self.output_path = None
+
+    @staticmethod
+    def check_naming_convention(fname):
+        """
+        Any sound file should be of the form NAME (one-shot) or NAME_# (looping
+        from the given sample)
+        """
+        list_parts = fname.split("_")
+        if len(list_parts) > 2 or (len(list_parts) == 2 and not list_parts[1].isdigit()):
+            logger.error(f"wrong naming convention for sound: {fname}")
+            return False
+
+        return True
+
+    def is_valid(self) -> bool:
+        return self.valid
+
+    def get_path(self) -> str:
+        return self.output_path
+
+    def save(self, dir_out: pathlib.Path, data: bytes, rate: int, num_samples: int, loop_start: int) -> None:
+        self.output_path = dir_out / f"{self.name}.vag"
+        with open(self.output_path, "wb") as file:
+            file.write(build_vag(data, rate, self.name))
+        loop = "one-shot" if loop_start is None else f"loop from {loop_start}"
+        logger.info(f"{self.name}: {num_samples} samples at {rate} Hz, {loop}, {len(data)} bytes -> {self.output_path}")
+
+def get_sound_list() -> list[Sound]:
+    return sounds
+
+def clear_sounds() -> None:
+    sounds.clear()
+
+def create_sounds(directory) -> int:
+    """
+    Looks for .wav files, skipping the output directory
+    Affects the global sound list
+    """
+    count = 0
+    dir_path = pathlib.Path(directory)
+    if not dir_path.exists():
+        return count
+    for path in sorted(dir_path.glob("*.wav")):
+        count += 1
+        logger.debug(path)
+        sound = Sound(path)
+        if sound.is_valid():
+            sounds.append(sound)
+    return count
+
+def encode_sounds(dir_out: str) -> None:
+    """ Encodes every sound in parallel, one process per core """
+    logger.info("Encoding sounds...")
+    path_out = pathlib.Path(dir_out)
+    with concurrent.futures.ProcessPoolExecutor(max_workers = os.cpu_count()) as executor:
+        jobs = [executor.submit(encode_file, sound.path, sound.loop_start) for sound in sounds]
+        for sound, job in zip(sounds, jobs):
+            sound.save(path_out, *job.result())
@@ -0,0 +1,81 @@
+"""
+Overlay placement
+Places the buildList sections declared with an "auto" address into the free
+regions of game RAM listed in disc.json, and finds overlapping sections.
+Ranges are (start, end) tuples with an exclusive end.
+"""
+from __future__ import annotations # to use type in python 3.7
+
+# Keeps the alignment of doubles and long longs within a section the same
+# wherever it is placed, so that its size doesn't change between links.
+ALIGNMENT = 8
+
+class PlacementError(Exception):
+    pass
+
+def align(value: int, alignment: int = ALIGNMENT) -> int:
+    return (value + alignment - 1) & ~(alignment - 1)
+
+def subtract(regions: list[tuple[int, int]], used: list[tuple[int, int]]) -> list[tuple[int, int]]:
+    """ Removes the used ranges from a list of regions. """
+    holes = sorted(regions)
+    for used_start, used_end in used:
+        out = []
+        for start, end in holes:
+            if used_end <= start or used_start >= end:
+                out.append((start, end))
+                continue
+            if start < used_start:
+                out.append((start, used_start))
+            if used_end < end:
+                out.append((used_end, end))
+        holes = out
+    return holes
+
+def best_fit(holes: dict[str, list[tuple[int, int]]], requests: list[tuple[str, str, int]]) -> dict[str, int]:
+    """
+    Places each (name, region group, size) request in the smallest hole of its
+    group that fits it, largest requests first. Returns the address of each
+    request, or raises PlacementError listing the ones that don't fit.
+    """
+    holes = {group: list(ranges) for group, ranges in holes.items()}
+    placements = dict()
+    failed = []
+    for name, group, size in sorted(requests, key=lambda req: (-req[2], req[0])):
+        best = None
+        for i, (start, end) in enumerate(holes.get(group, [])):
+            addr = align(start)
+            if addr + size > end:
+                continue
+            if best is None or (end - start) < (holes[group][best][1] - holes[group][best][0]):
+                best = i
+        if best is None:
+            failed.append(f"{name} ({size} bytes)")
+            continue
+        start, end = holes[group].pop(best)
+        addr = align(start)
+        placements[name] = addr
+        holes[group] += [hole for hole in [(start, addr), (addr + size, end)] if hole[0] < hole[1]]
+    if failed:
+        raise PlacementError("not enough free space for " + ", ".join(failed))
+    return placements
+
+def find_overlaps(sections: list[tuple[str, str, int, int]]) -> list[tuple[str, str]]:
+    """
+    Returns the pairs of (name, region group, start, end) sections whose ranges
+    overlap within the same group. Sections in different groups can legitimately
+    share addresses, e.g. game overlays which are loaded in place of each other.
+    """
+    overlaps = []
+    by_group = dict()
+    for section in sections:
+        by_group.setdefault(section[1], []).append(section)
+    for group in by_group.values():
+        group.sort(key=lambda section: section[2])
+        for i, (name, _, start, end) in enumerate(group):
+            for other, _, other_start, other_end in group[i + 1:]:
+                if other_start >= end:
+                    break
+                if other_end > other_start and end > start:
+                    overlaps.append((name, other))
+    return overlaps
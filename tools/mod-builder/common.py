@@ -2,8 +2,10 @@
 Contains all of the global directory names and functions for user input
 TODO: Make the user pass in the game dir
 """
+import ast
 import copy
 import logging
+import operator
 import os
 import pathlib
 import sys
@@ -79,11 +81,21 @@ DEP_FOLDER = DEBUG_FOLDER / "dep/"
 COMP_SOURCE = DEBUG_FOLDER / "source.txt"
 TEXTURES_FOLDER = pathlib.Path("newtex")
 TEXTURES_OUTPUT_FOLDER = TEXTURES_FOLDER / "output"
+FMV_FOLDER = pathlib.Path("newfmv")
+FMV_OUTPUT_FOLDER = FMV_FOLDER / "output"
+FMV_ENV_FILE = FMV_FOLDER / "env.bin"
+SOUNDS_FOLDER = pathlib.Path("newsnd")
+SOUNDS_OUTPUT_FOLDER = SOUNDS_FOLDER / "output"
 GCC_MAP_FILE = DEBUG_FOLDER / "mod.map"
 GCC_OUT_FILE = DEBUG_FOLDER / "gcc_out.txt"
-TRIMBIN_OFFSET = DEBUG_FOLDER / "offset.txt"
+COMPILE_TIMES_LOG = DEBUG_FOLDER / "compile_times.log"
+COMPILE_TIMES = DEBUG_FOLDER / "compile_times.json"
+OVERLAY_MANIFEST = DEBUG_FOLDER / "overlays.json"
+SIZE_REPORT = DEBUG_FOLDER / "size_report.txt"
+LAYOUT_PROFILE = "profile.folded"
 COMPILATION_RESIDUES = ["overlay.ld", MAKEFILE, "comport.txt"]
 REDUX_MAP_FILE = DEBUG_FOLDER / "redux.map"
+SYMBOL_INDEX = DEBUG_FOLDER / "symbols.json"
 SETTINGS_FILE = "settings.json"
 SETTINGS_PATH = DIR_GAME.parent / SETTINGS_FILE
 DISC_FILE = "disc.json"
@@ -149,6 +161,45 @@ def is_number(s: str) -> bool:
             return False
     return True
 
+ARITHMETIC_OPERATORS = {
+    ast.Add: operator.add,
+    ast.Sub: operator.sub,
+    ast.Mult: operator.mul,
+    ast.Div: operator.floordiv, # addresses are integers
+    ast.FloorDiv: operator.floordiv,
+    ast.Mod: operator.mod,
+    ast.LShift: operator.lshift,
+    ast.RShift: operator.rshift,
+    ast.BitAnd: operator.and_,
+    ast.BitOr: operator.or_,
+    ast.BitXor: operator.xor,
+    ast.USub: operator.neg,
+    ast.UAdd: operator.pos,
+    ast.Invert: operator.invert,
+}
+
+def eval_arithmetic(expression: str) -> int:
+    """
+    Evaluates an integer arithmetic expression such as "0x10 * (2 + 1)",
+    without running any other python code. Raises ValueError otherwise.
+    """
+    def evaluate(node):
+        if isinstance(node, ast.Expression):
+            return evaluate(node.body)
+        # python 3.7 parses numbers as ast.Num
+        value = getattr(node, "value", getattr(node, "n", None)) if type(node).__name__ in ("Constant", "Num") else None
+        if type(value) is int:
+            return value
+        if isinstance(node, ast.BinOp) and type(node.op) in ARITHMETIC_OPERATORS:
+            return ARITHMETIC_OPERATORS[type(node.op)](evaluate(node.left), evaluate(node.right))
+        if isinstance(node, ast.UnaryOp) and type(node.op) in ARITHMETIC_OPERATORS:
+            return ARITHMETIC_OPERATORS[type(node.op)](evaluate(node.operand))
+        raise ValueError(f"unsupported expression: {expression}")
+    try:
+        return evaluate(ast.parse(expression.strip(), mode="eval"))
+    except (SyntaxError, ZeroDivisionError) as error:
+        raise ValueError(f"invalid expression: {expression}") from error
+
 def cli_clear() -> None:
     if os.name == "nt":
         os.system("cls")
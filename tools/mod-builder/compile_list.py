@@ -2,10 +2,13 @@
 Parses the buildList.txt file line by line assuming a tabluar format
 Use pathlib.Path().resolve() to handle concatenation of ../.. syntax
 """
+from __future__ import annotations # to use type in python 3.7
+
 import _files # check_file
-from common import COMMENT_SYMBOL, CONFIG_PATH, OUTPUT_FOLDER, MOD_PATH, is_number
+from common import COMMENT_SYMBOL, COMPILE_LIST, CONFIG_PATH, OUTPUT_FOLDER, OVERLAY_MANIFEST, MOD_PATH, is_number, eval_arithmetic
 from syms import Syms
 
+import functools
 import json
 import logging
 import re
@@ -14,7 +17,10 @@ import pathlib
 
 logger = logging.getLogger(__name__)
 
+AUTO_ADDRESS = "auto"
+
 sections = dict()
+placements = dict() # addresses picked for auto sections by the last compilation, by prefix
 line_count = [0]
 print_errors = [False]
 
@@ -25,6 +31,49 @@ def error_print(error: str):
     logger.error(error)
     print_errors[0] = True
 
+def get_mtime(path) -> int | None:
+    try:
+        return os.stat(path).st_mtime_ns
+    except OSError:
+        return None
+
+config_8mb = dict() # config.json mtime -> 8mb flag
+
+def is_8mb_config() -> bool:
+    mtime = get_mtime(CONFIG_PATH)
+    if mtime not in config_8mb:
+        config_8mb.clear()
+        with open(CONFIG_PATH, "r") as file:
+            config_8mb[mtime] = json.load(file)["compiler"]["8mb"] == 1
+    return config_8mb[mtime]
+
+@functools.lru_cache(maxsize=None)
+def compile_glob(name: str) -> re.Pattern:
+    return re.compile(name.replace("*", "(.*)"))
+
+directory_files = dict() # directory -> (mtime, files)
+
+def list_directory(directory: pathlib.Path) -> list[str] | None:
+    """ Files in a directory, cached until the directory changes. None if it doesn't exist. """
+    mtime = get_mtime(directory)
+    if mtime is None:
+        return None
+    cached = directory_files.get(directory)
+    if cached is None or cached[0] != mtime:
+        cached = (mtime, [entry.name for entry in os.scandir(directory) if entry.is_file()])
+        directory_files[directory] = cached
+    return cached[1]
+
+def get_placement(prefix: str, section_name: str) -> int:
+    if prefix not in placements:
+        placements[prefix] = dict()
+        manifest = pathlib.Path(prefix) / OVERLAY_MANIFEST
+        if manifest.exists():
+            with open(manifest, "r") as file:
+                for overlay in json.load(file)["overlays"]:
+                    placements[prefix][overlay["section"]] = int(overlay["address"], 0)
+    return placements[prefix].get(section_name)
+
 class CompileList:
     def __init__(self, line: str, sym: Syms, prefix: str) -> None:
         self.original_line = line
@@ -32,6 +81,8 @@ class CompileList:
         self.prefix = prefix # path prefix
         self.ignore = False
         self.is_bin = False
+        self.is_auto = False
+        self.budget = None # maximum size in bytes
         self.path_build_list = None
         self.source = None
         self.pch = str()
@@ -41,9 +92,7 @@ class CompileList:
         line_count[0] += 1
 
     def is_8mb(self) -> bool:
-        with open(CONFIG_PATH, "r") as file:
-            data = json.load(file)["compiler"]
-            return data["8mb"] == 1
+        return is_8mb_config()
 
     @staticmethod
     def tokenize_line(string, delimiter = ","):
@@ -94,31 +143,33 @@ class CompileList:
         self.game_file = list_tokens[1]
         offset = 0
         try:
-            offset = eval(list_tokens[3])
-        except Exception:
+            offset = eval_arithmetic(list_tokens[3])
+        except ValueError:
             error_print(f"Invalid arithmetic expression for offset at line {line_count[0]}: {self.original_line}\n")
 
-        self.address = self.calculate_address_base(list_tokens[2], offset)
+        self.is_auto = list_tokens[2].lower() == AUTO_ADDRESS
+        if self.is_auto:
+            self.address = None # resolved once the section name is known
+        else:
+            self.address = self.calculate_address_base(list_tokens[2], offset)
         # construct source_directories
         srcs = [l.strip() for l in list_tokens[4].split()]
         self.source = []
-        dict_folders = dict()
+        self.directories = [] # checked by CompilePlan to notice new or deleted files
         for src in srcs:
             src_path = pathlib.Path(self.prefix + src).resolve()
             directory = src_path.parent
-            regex = re.compile(src_path.name.replace("*", "(.*)"))
+            regex = compile_glob(src_path.name)
             output_name = src_path.stem
-            if not directory in dict_folders:
-                for _, _, files in os.walk(directory):
-                    dict_folders[directory] = files
-                    break
+            files = list_directory(directory)
+            self.directories.append(directory)
             # TODO: Figure out why we need this weird if-block
             # TODO: Workaround until OUTPUT_FOLDER is a pathlib object
             if (directory.name + os.sep == OUTPUT_FOLDER) and output_name in sections:
                 self.source.append(directory / src_path.name)
             else:
-                if directory in dict_folders:
-                    for file in dict_folders[directory]:
+                if files is not None:
+                    for file in files:
                         if regex.search(file):
                             self.source.append(directory / file)
                 else:
@@ -130,18 +181,31 @@ class CompileList:
             error_print(f"No file(s) found at line: {line_count[0]}: {self.original_line}")
             self.ignore = True
             return
-        if len(list_tokens) == 6:
+        if len(list_tokens) >= 6:
             self.section_name = list_tokens[5].split(".")[0]
         else:
             self.section_name = self.get_section_name_from_filepath(self.source[0])
 
+        if len(list_tokens) >= 7:
+            if is_number(list_tokens[6]):
+                self.budget = int(list_tokens[6], 0)
+            else:
+                error_print(f"Invalid max size at line {line_count[0]}: {self.original_line}\n")
+
         extension = self.source[0].suffix
         if extension.lower() not in [".c", ".s", ".cpp", ".cc"]:
             self.is_bin = True
             self.ignore = True
+            if self.is_auto:
+                error_print(f"The {AUTO_ADDRESS} address can only be used with source files at line {line_count[0]}: {self.original_line}\n")
+                self.is_bin = False
             return
 
-        if (self.address != 0) and ((self.address < self.min_addr) or (self.address > self.max_addr)):
+        if self.is_auto:
+            # Compiling places the section in a free region of its disc.json
+            # section, other commands reuse the address it picked.
+            self.address = get_placement(self.prefix, self.section_name)
+        elif (self.address != 0) and ((self.address < self.min_addr) or (self.address > self.max_addr)):
             if self.address != -1:
                 error_print(f"address specified is not in the [{hex(self.min_addr)}, {hex(self.max_addr)}] range.")
                 error_print(f"at line {line_count[0]}: {self.original_line}\n")
@@ -184,9 +248,46 @@ class CompileList:
     def should_build(self) -> bool:
         if self.ignore and not self.is_bin:
             return False
+        if self.is_auto and self.address is None: # never compiled
+            return False
         return True
 
+class CompilePlan:
+    """
+    The parsed lines of a buildList.txt for one game version. It stays valid
+    until the build list, the configuration, the symbol files, the placements
+    of the last compilation or the source directories it uses change.
+    """
+    def __init__(self, sym: Syms, prefix: str) -> None:
+        free_sections()
+        self.build_list = pathlib.Path(prefix) / COMPILE_LIST
+        dependencies = [self.build_list, CONFIG_PATH, pathlib.Path(prefix) / OVERLAY_MANIFEST] + list(sym.get_files() or [])
+        self.lines = []
+        with open(self.build_list, "r") as file:
+            for line in file:
+                self.lines.append(CompileList(line, sym, prefix))
+        for cl in self.lines:
+            dependencies += getattr(cl, "directories", [])
+        self.has_errors = print_errors[0]
+        self.mtimes = {str(path): get_mtime(path) for path in dependencies}
+
+    def is_valid(self) -> bool:
+        return all(get_mtime(path) == mtime for path, mtime in self.mtimes.items())
+
+compile_plans = dict() # (prefix, build id, version) -> CompilePlan
+
+def get_compile_plan(sym: Syms, prefix: str = "./") -> list[CompileList]:
+    """ Returns the parsed lines of the build list at prefix, parsing it again only if it changed. """
+    key = (prefix, sym.get_build_id(), sym.get_version())
+    plan = compile_plans.get(key)
+    if plan is None or not plan.is_valid():
+        plan = CompilePlan(sym, prefix)
+        compile_plans[key] = plan
+    print_errors[0] = plan.has_errors
+    return plan.lines
+
 def free_sections() -> None:
     sections.clear()
+    placements.clear()
     line_count[0] = 0
     print_errors[0] = False
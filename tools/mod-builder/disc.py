@@ -7,6 +7,11 @@ class DiscFile:
         self.address = int(metadata["address"], 0)
         self.offset = int(metadata["offset"], 0)
         self.physical_file = physical_file.replace("\\", "/")
+        # RAM ranges which aren't used by the game and can hold auto placed sections
+        self.free_regions = []
+        for region in metadata.get("free", []):
+            start = int(region["address"], 0)
+            self.free_regions.append((start, start + int(region["size"], 0)))
 
 
 class Disc:
@@ -0,0 +1,126 @@
+"""
+Minimal reader for the little endian 32-bit elf files produced by the
+mipsel toolchain. Only parses what the mod-builder needs: the section and
+program header tables, and the symbol table.
+"""
+from __future__ import annotations # to use type in python 3.7
+
+import struct
+from dataclasses import dataclass
+
+ELF_MAGIC = b"\x7fELF"
+ELF_HEADER = struct.Struct("<16sHHIIIIIHHHHHH")
+SECTION_HEADER = struct.Struct("<10I")
+PROGRAM_HEADER = struct.Struct("<8I")
+SYMBOL = struct.Struct("<IIIBBH")
+
+SHT_NOBITS = 8
+PT_LOAD = 1
+
+STT_NOTYPE = 0
+STT_OBJECT = 1
+STT_FUNC = 2
+STT_SECTION = 3
+STT_FILE = 4
+STB_LOCAL = 0
+
+SHN_UNDEF = 0
+SHN_ABS = 0xFFF1
+SHN_COMMON = 0xFFF2
+ABS_SECTION = "*ABS*"
+
+@dataclass
+class Section:
+    name: str
+    type: int
+    flags: int
+    addr: int
+    offset: int
+    size: int
+
+@dataclass
+class Symbol:
+    name: str
+    value: int
+    size: int
+    type: int
+    bind: int
+    section: str | None # None when undefined
+
+@dataclass
+class Segment:
+    type: int
+    offset: int
+    vaddr: int
+    paddr: int
+    filesz: int
+    memsz: int
+
+class Elf:
+    def __init__(self, data: bytes) -> None:
+        self.data = data
+        header = ELF_HEADER.unpack_from(data, 0)
+        ident = header[0]
+        if ident[:4] != ELF_MAGIC or ident[4] != 1 or ident[5] != 1:
+            raise ValueError("not a little endian 32-bit elf file")
+        phoff, shoff = header[5], header[6]
+        phentsize, phnum, shentsize, shnum, shstrndx = header[9:14]
+
+        self.segments = []
+        for i in range(phnum):
+            p_type, offset, vaddr, paddr, filesz, memsz, _, _ = PROGRAM_HEADER.unpack_from(data, phoff + i * phentsize)
+            self.segments.append(Segment(p_type, offset, vaddr, paddr, filesz, memsz))
+
+        headers = [SECTION_HEADER.unpack_from(data, shoff + i * shentsize) for i in range(shnum)]
+        self.sections = dict()
+        self.section_names = [] # by index, as referenced by the symbols
+        if not headers:
+            return
+        strtab = headers[shstrndx]
+        strtab = data[strtab[4] : strtab[4] + strtab[5]]
+        for name, sh_type, flags, addr, offset, size, _, _, _, _ in headers:
+            name = strtab[name : strtab.index(b"\0", name)].decode()
+            self.sections[name] = Section(name, sh_type, flags, addr, offset, size)
+            self.section_names.append(name)
+
+    @staticmethod
+    def from_file(path) -> Elf:
+        with open(path, "rb") as file:
+            return Elf(file.read())
+
+    def get_section(self, name: str) -> Section | None:
+        return self.sections.get(name)
+
+    def section_data(self, section: Section) -> bytes:
+        """ Sections holding only bss have no contents in the file. """
+        if section.type == SHT_NOBITS:
+            return b""
+        return self.data[section.offset : section.offset + section.size]
+
+    def symbols(self) -> list[Symbol]:
+        """ Returns the entries of .symtab, or nothing if the elf was stripped. """
+        symtab, strtab = self.get_section(".symtab"), self.get_section(".strtab")
+        if symtab is None or strtab is None:
+            return []
+        names = self.section_data(strtab)
+        symbols = []
+        # The first entry is always the null symbol
+        for name, value, size, info, _, shndx in SYMBOL.iter_unpack(self.section_data(symtab)[SYMBOL.size:]):
+            name = names[name : names.index(b"\0", name)].decode(errors="replace")
+            if shndx == SHN_UNDEF:
+                section = None
+            elif shndx == SHN_ABS:
+                section = ABS_SECTION
+            elif shndx < len(self.section_names):
+                section = self.section_names[shndx]
+            else: # SHN_COMMON and other reserved indexes
+                section = ""
+            symbols.append(Symbol(name, value, size, info & 0xF, info >> 4, section))
+        return symbols
+
+    def get_load_segment(self, section: Section) -> Segment | None:
+        """ Returns the loadable segment the section is placed in. """
+        for segment in self.segments:
+            if segment.type == PT_LOAD and segment.vaddr <= section.addr < segment.vaddr + segment.memsz:
+                return segment
+        return None
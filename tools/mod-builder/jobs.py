@@ -0,0 +1,93 @@
+"""
+Scheduling of the make jobs
+Picks how many jobs make runs in parallel, and keeps the time each source
+took to compile in the last builds so that the slowest ones are started first.
+"""
+from __future__ import annotations # to use type in python 3.7
+
+import functools
+import json
+import os
+import re
+import subprocess
+
+SOURCE_SUFFIXES = (".c", ".cpp", ".cc")
+COMPILERS = ("cc1", "cc1plus")
+
+def get_job_count(configured: int = 0) -> int:
+    """
+    Returns the configured job count if there is one, otherwise one job per
+    CPU minus the ones already busy according to the load average.
+    """
+    if configured > 0:
+        return configured
+    cpus = os.cpu_count() or 1
+    try:
+        load = os.getloadavg()[0]
+    except (AttributeError, OSError): # not available on Windows
+        load = 0.0
+    return max(1, cpus - int(load))
+
+def get_load_limit() -> int:
+    """ make doesn't start new jobs while the load average is above this. """
+    return os.cpu_count() or 1
+
+@functools.lru_cache(maxsize=None)
+def make_supports_output_sync(make: str = "make") -> bool:
+    """ --output-sync needs GNU make 4.0 or newer. """
+    try:
+        result = subprocess.run([make, "--version"], stdout=subprocess.PIPE, stderr=subprocess.DEVNULL, text=True)
+    except OSError:
+        return False
+    match = re.search(r"GNU Make (\d+)\.", result.stdout)
+    return match is not None and int(match.group(1)) >= 4
+
+def parse_compile_times(text: str) -> dict[str, float]:
+    """
+    Parses the file written by gcc -time=file, which has one
+    "user system program arguments..." line per compiler pass, and returns the
+    CPU time spent compiling each source file.
+    """
+    times = dict()
+    for line in text.splitlines():
+        tokens = line.split()
+        if len(tokens) < 4 or os.path.basename(tokens[2]) not in COMPILERS:
+            continue
+        try:
+            seconds = float(tokens[0]) + float(tokens[1])
+        except ValueError:
+            continue
+        arguments = tokens[3:]
+        for i, argument in enumerate(arguments):
+            if argument.endswith(SOURCE_SUFFIXES) and (i == 0 or arguments[i - 1] != "-dumpbase"):
+                times[argument] = times.get(argument, 0.0) + seconds
+                break
+    return times
+
+def load_compile_times(path) -> dict[str, float]:
+    try:
+        with open(path, "r") as file:
+            return json.load(file)
+    except (OSError, ValueError):
+        return dict()
+
+def update_compile_times(path, log_path) -> None:
+    """ Merges the times of the sources compiled by the last build into the saved ones. """
+    try:
+        with open(log_path, "r") as file:
+            new_times = parse_compile_times(file.read())
+    except OSError:
+        return
+    if not new_times:
+        return
+    times = load_compile_times(path)
+    times.update(new_times)
+    with open(path, "w") as file:
+        json.dump(times, file, indent=4, sort_keys=True)
+
+def order_by_compile_time(srcs: list[str], times: dict[str, float]) -> list[str]:
+    """
+    Sorts the sources from the slowest to the fastest to compile. Sources never
+    compiled before come first, as nothing is known about them.
+    """
+    return sorted(srcs, key=lambda src: -times.get(src, float("inf")))
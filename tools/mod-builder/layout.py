@@ -0,0 +1,65 @@
+"""
+Profile guided function layout
+Orders the functions that show up in a profile so that callers and callees with
+the heaviest calls between them end up next to each other (Pettis-Hansen
+chain merging), in order to keep code that runs every frame packed in as few
+I-cache lines as possible. Functions missing from the profile are considered
+cold and are placed after everything else.
+
+The profile is a list of stacks in the collapsed format written by the
+profiler ("root;caller;callee time" per line). A plain histogram with one
+"function count" line per function, as written by a sampler, is also valid.
+"""
+from __future__ import annotations # to use type in python 3.7
+
+from collections import defaultdict
+
+ICACHE_SIZE = 4096
+
+def clean_name(name: str) -> str | None:
+    """ Drops the offset from names symbolized as "func+0x10", and unknown addresses. """
+    name = name.split("+")[0]
+    if name.startswith("0x"):
+        return None
+    return name
+
+def load_profile(path) -> tuple[dict[str, int], dict[tuple[str, str], int]]:
+    """
+    Returns the self time of each function and the time spent in each
+    (caller, callee) call.
+    """
+    heat = defaultdict(int)
+    edges = defaultdict(int)
+    with open(path, "r") as file:
+        for line in file:
+            line = line.rsplit(None, 1)
+            if len(line) != 2 or not line[1].isdigit():
+                continue
+            stack = [clean_name(name) for name in line[0].split(";")]
+            value = int(line[1])
+            if stack[-1] is not None:
+                heat[stack[-1]] += value
+            for caller, callee in zip(stack, stack[1:]):
+                if caller is not None:
+                    heat.setdefault(caller, 0)
+                if caller is not None and callee is not None and caller != callee:
+                    edges[(caller, callee)] += value
+    return dict(heat), dict(edges)
+
+def order_functions(heat: dict[str, int], edges: dict[tuple[str, str], int]) -> list[str]:
+    """
+    Merges the functions into chains following the heaviest calls first, and
+    returns the chains sorted by their total self time.
+    """
+    chains = {name: [name] for name in heat}
+    for (caller, callee), _ in sorted(edges.items(), key=lambda edge: (-edge[1], edge[0])):
+        a, b = chains[caller], chains[callee]
+        # Only the ends of two different chains can be joined
+        if a is b or a[-1] != caller or b[0] != callee:
+            continue
+        a += b
+        for name in b:
+            chains[name] = a
+    unique = {id(chain): chain for chain in chains.values()}.values()
+    ordered = sorted(unique, key=lambda chain: (-sum(heat[name] for name in chain), chain[0]))
+    return [name for chain in ordered for name in chain]
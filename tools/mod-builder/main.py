@@ -6,16 +6,20 @@ TODO: Replace with Click
 """
 import _files # check_file, check_files, delete_file, create_directory, delete_directory
 from makefile import Makefile, clean_pch
-from compile_list import CompileList, free_sections, print_errors
+from compile_list import get_compile_plan, print_errors
 from syms import Syms
 from redux import Redux
-from common import MOD_NAME, GAME_NAME, LOG_FILE, COMPILE_LIST, DEBUG_FOLDER, BACKUP_FOLDER, OUTPUT_FOLDER, COMPILATION_RESIDUES, TEXTURES_FOLDER, TEXTURES_OUTPUT_FOLDER, IS_WINDOWS_OS, request_user_input, cli_clear, cli_pause, DISC_PATH, SETTINGS_PATH
+from common import MOD_NAME, GAME_NAME, LOG_FILE, COMPILE_LIST, DEBUG_FOLDER, BACKUP_FOLDER, OUTPUT_FOLDER, COMPILATION_RESIDUES, TEXTURES_FOLDER, TEXTURES_OUTPUT_FOLDER, FMV_FOLDER, FMV_OUTPUT_FOLDER, FMV_ENV_FILE, SYMBOL_INDEX, SOUNDS_FOLDER, SOUNDS_OUTPUT_FOLDER, IS_WINDOWS_OS, request_user_input, cli_clear, cli_pause, DISC_PATH, SETTINGS_PATH
 from mkpsxiso import Mkpsxiso
 from nops import Nops
 from game_options import game_options
 from image import create_images, clear_images, dump_images
 from clut import clear_cluts, dump_cluts
+from mdec import create_bitstreams, clear_bitstreams, encode_bitstreams
+from adpcm import create_sounds, clear_sounds, encode_sounds
 from c import export_as_c
+from symbol_index import SymbolIndex, annotate_disassembly
+from watch import WatchMode
 
 import logging
 import os
@@ -46,12 +50,16 @@ class Main:
             11  :   self.replace_textures,
             12  :   self.redux.restore_textures,
             13  :   self.redux.start_emulation, # would like to pass settings path here
-            14  :   self.nops.hot_reload,
-            15  :   self.nops.restore,
-            16  :   self.disasm,
-            17  :   export_as_c,
-            18  :   self.clean_all,
-            19  :   self.shutdown
+            14  :   self.redux.dump_profile,
+            15  :   self.watch,
+            16  :   self.nops.hot_reload,
+            17  :   self.nops.restore,
+            18  :   self.disasm,
+            19  :   export_as_c,
+            20  :   self.encode_bitstreams,
+            21  :   self.encode_sounds,
+            22  :   self.clean_all,
+            23  :   self.shutdown
         }
         self.num_options = len(self.actions)
         self.window_title = f"{GAME_NAME} - {MOD_NAME}"
@@ -94,16 +102,20 @@ class Main:
         11 - Replace Textures
         12 - Restore Textures
         13 - Start Emulation
+        14 - Dump Function Profile
+        15 - Watch Mode (compile and hot reload on save)
 
         NotPSXSerial:
-        14 - Hot Reload Code
-        15 - Hot Reload Code Restore
+        16 - Hot Reload Code
+        17 - Hot Reload Code Restore
 
         General:
-        16 - Disassemble Elf
-        17 - Export textures as C file
-        18 - Clean All
-        19 - Quit
+        18 - Disassemble Elf
+        19 - Export textures as C file
+        20 - Encode MDEC bitstreams
+        21 - Encode SPU ADPCM sounds
+        22 - Clean All
+        23 - Quit
         """
         error_msg = f"ERROR: Wrong option. Please type a number from 1-{self.num_options}.\n"
         return request_user_input(first_option=1, last_option=self.num_options, intro_msg=intro_msg, error_msg=error_msg)
@@ -119,12 +131,9 @@ class Main:
         instance_symbols = Syms()
         make = Makefile(instance_symbols.get_build_id(), instance_symbols.get_files())
         # parsing compile list
-        free_sections()
-        with open(COMPILE_LIST, "r") as file:
-            for line in file:
-                cl = CompileList(line, instance_symbols, "./")
-                if not cl.should_ignore():
-                    make.add_cl(cl)
+        for cl in get_compile_plan(instance_symbols, "./"):
+            if not cl.should_ignore():
+                make.add_cl(cl)
         if print_errors[0]:
             intro_msg = "[Compile-py] Would you like to continue to compilation process?\n\n1 - Yes\n2 - No\n"
             error_msg = "ERROR: Wrong option. Please type a number from 1-2.\n"
@@ -136,11 +145,16 @@ class Main:
         else:
             self.abort_compilation(is_warning=True)
 
+    def watch(self) -> None:
+        WatchMode(self.redux).run()
+
     def clean_files(self) -> None:
         _files.delete_directory(DEBUG_FOLDER)
         _files.delete_directory(BACKUP_FOLDER)
         _files.delete_directory(OUTPUT_FOLDER)
         _files.delete_directory(TEXTURES_OUTPUT_FOLDER)
+        _files.delete_directory(FMV_OUTPUT_FOLDER)
+        _files.delete_directory(SOUNDS_OUTPUT_FOLDER)
         clean_pch()
         for file in COMPILATION_RESIDUES:
             _files.delete_file(file)
@@ -179,12 +193,35 @@ class Main:
         clear_images()
         clear_cluts()
 
+    def encode_bitstreams(self) -> None:
+        _files.create_directory(FMV_OUTPUT_FOLDER)
+        bs_count = create_bitstreams(FMV_FOLDER)
+        if bs_count == 0:
+            logger.warning("0 images found. No bitstreams were encoded")
+            return
+        env = FMV_ENV_FILE if _files.check_file(FMV_ENV_FILE, quiet=True) else None
+        encode_bitstreams(FMV_OUTPUT_FOLDER, env)
+        clear_bitstreams()
+
+    def encode_sounds(self) -> None:
+        _files.create_directory(SOUNDS_OUTPUT_FOLDER)
+        sound_count = create_sounds(SOUNDS_FOLDER)
+        if sound_count == 0:
+            logger.warning("0 sounds found. No sounds were encoded")
+            return
+        encode_sounds(SOUNDS_OUTPUT_FOLDER)
+        clear_sounds()
+
     def disasm(self) -> None:
         path_in = DEBUG_FOLDER / 'mod.elf'
         path_out = DEBUG_FOLDER / 'disasm.txt'
+        command = ["mipsel-none-elf-objdump", "-d", str(path_in)]
+        result = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+        output = result.stdout
+        if _files.check_file(SYMBOL_INDEX, quiet=True):
+            output = annotate_disassembly(output, SymbolIndex.load(SYMBOL_INDEX))
         with open(path_out, "w") as file:
-            command = ["mipsel-none-elf-objdump", "-d", str(path_in)]
-            subprocess.call(command, stdout=file, stderr=subprocess.STDOUT)
+            file.write(output)
         logger.info(f"Disassembly saved at {path_out}")
 
     def exec(self):
@@ -6,12 +6,22 @@ TODO: Use subprocess instead of os.system
 """
 
 from compile_list import CompileList
+from elf import Elf
+from disc import Disc
+from game_options import game_options
+from allocator import PlacementError, align, subtract, best_fit, find_overlaps
+from mapfile import MapFile, size_report
+from layout import ICACHE_SIZE, load_profile, order_functions
+from symbol_index import SymbolIndex
+from jobs import get_job_count, get_load_limit, make_supports_output_sync, load_compile_times, update_compile_times, order_by_compile_time
+from pch import get_build_flags, get_compiler_version, get_cache_key, get_cache_path, get_dep_path, prepare_cache, prune_cache
 import _files # create_directory, delete_file
-from common import cli_clear, MAKEFILE, TRIMBIN_OFFSET, GCC_OUT_FILE, COMP_SOURCE, GAME_INCLUDE_PATH, CONFIG_PATH, SRC_FOLDER, DEBUG_FOLDER, OUTPUT_FOLDER, BACKUP_FOLDER, OBJ_FOLDER, DEP_FOLDER, GCC_MAP_FILE, REDUX_MAP_FILE, CONFIG_PATH, MOD_NAME, MOD_DIR
+from common import cli_clear, MAKEFILE, OVERLAY_MANIFEST, SIZE_REPORT, LAYOUT_PROFILE, GCC_OUT_FILE, COMPILE_TIMES_LOG, COMPILE_TIMES, COMP_SOURCE, GAME_INCLUDE_PATH, CONFIG_PATH, SRC_FOLDER, DEBUG_FOLDER, OUTPUT_FOLDER, BACKUP_FOLDER, OBJ_FOLDER, DEP_FOLDER, GCC_MAP_FILE, REDUX_MAP_FILE, SYMBOL_INDEX, CONFIG_PATH, MOD_NAME, MOD_DIR
 
 import logging
 import json
 import os
+import pathlib
 import shutil
 import subprocess
 import textwrap
@@ -22,11 +32,11 @@ from time import time
 logger = logging.getLogger(__name__)
 
 def clean_pch() -> None:
+    """ The precompiled headers are shared by all the mods, so only the ones unused for a while are deleted. """
     with open(CONFIG_PATH, "r") as file:
         data = json.load(file)["compiler"]
         if "pch" in data:
-            pch = data["pch"] + ".gch"
-            _files.delete_file(GAME_INCLUDE_PATH / pch)
+            prune_cache(GAME_INCLUDE_PATH / data["pch"])
 
 class Makefile:
     def __init__(self, build_id: int, files_symbols: list[str]) -> None:
@@ -37,12 +47,18 @@ class Makefile:
         self.opt_ccflags = str()
         self.opt_ldflags = str()
         self.srcs = None # list
+        self.free_regions = None # dict, by disc.json section
+        self.overlay_sizes = dict()
         self.load_config()
 
     def load_config(self) -> None:
         with open(CONFIG_PATH, "r") as file:
             data = json.load(file)["compiler"]
             self.disable_function_reorder = str(data["reorder_functions"] == 0).lower()
+            # Lets --gc-sections remove everything that isn't reachable from an entry point
+            self.gc_sections = data.get("gc_sections", 0) != 0
+            self.profile_layout = data.get("profile_layout", 0) != 0
+            self.jobs = data.get("jobs", 0) # 0 picks it from the CPU count and load
             optimization_level = data["optimization"]
             if optimization_level > 3:
                 self.compiler_flags = "-Os"
@@ -52,8 +68,15 @@ class Makefile:
                 self.compiler_flags += " -g"
             self.use_psyq_str = str(data["psyq"] != 0).lower()
             self.use_mininoob_str = str(data["mininoob"] != 0).lower()
+            # The call tracing runtime lives in minin00b's psxprof library
+            self.use_profile_str = "false"
+            if data.get("profile", 0) != 0:
+                if data["mininoob"] != 0:
+                    self.use_profile_str = "true"
+                else:
+                    logger.warning("The profile option requires mininoob to be enabled. Ignoring it.")
             if "pch" in data:
-                self.pch = data["pch"] + ".gch"
+                self.pch = data["pch"]
             if "ccflags" in data:
                 self.opt_ccflags = data["ccflags"]
             if "ldflags" in data:
@@ -62,6 +85,29 @@ class Makefile:
     def add_cl(self, instance: CompileList) -> None:
         self.list_compile_lists.append(instance)
 
+    def load_free_regions(self) -> None:
+        if self.free_regions is not None:
+            return
+        disc = Disc(game_options.get_gv_by_build_id(self.build_id).version)
+        self.free_regions = {name: df.free_regions for name, df in disc.df_by_name.items()}
+
+    def set_provisional_addresses(self) -> bool:
+        """
+        Sections with an auto address need one for the first link, which tells
+        their size. The address from the last compilation is kept if there is one,
+        otherwise they start at the first free region of their disc.json section.
+        """
+        for instance in self.list_compile_lists:
+            if not instance.is_auto or instance.address is not None:
+                continue
+            self.load_free_regions()
+            regions = self.free_regions.get(instance.game_file, [])
+            if not regions:
+                logger.critical(f"No free regions declared in disc.json for section {instance.game_file}, needed by {instance.section_name}")
+                return False
+            instance.address = align(min(regions)[0])
+        return True
+
     def set_base_address(self) -> bool:
         address = 0x807FFFFF
         for instance in self.list_compile_lists:
@@ -76,12 +122,77 @@ class Makefile:
         for instance in self.list_compile_lists:
             for src in instance.source: #pathlibs
                 self.srcs.append(str(src).replace("\\", "/").replace(str(MOD_DIR), ""))
-            self.ovrs.append((instance.section_name, instance.source, instance.address))
+            self.ovrs.append((instance.section_name, instance.source, instance.address, instance.game_file))
             # self.ovr_section += "." + instance.section_name + " "
             self.ovr_section.append("." + instance.section_name)
 
+    def load_layout(self) -> tuple[list[str], MapFile] | None:
+        """
+        Returns the functions of the layout profile from the hottest to the
+        coldest, along with the map of the last link, which tells the object
+        each of them comes from.
+        """
+        if not self.profile_layout:
+            return None
+        if not _files.check_file(LAYOUT_PROFILE, quiet=True):
+            logger.warning(f"profile_layout is enabled but {LAYOUT_PROFILE} was not found. Using the default layout.")
+            return None
+        if not _files.check_file(GCC_MAP_FILE, quiet=True):
+            logger.warning("profile_layout needs the map of a previous compilation. Using the default layout for now.")
+            return None
+        order = order_functions(*load_profile(LAYOUT_PROFILE))
+        map_file = MapFile.from_file(GCC_MAP_FILE)
+        hot = set(order)
+        hot_size = sum(input.size for section in map_file.sections.values() for input in section.inputs
+            if input.name.startswith(".text.") and input.symbol() in hot)
+        print(f"Profile guided layout: {len(order)} hot functions, {hot_size} bytes of code")
+        if hot_size > ICACHE_SIZE:
+            logger.warning(f"The hot functions don't fit in the {ICACHE_SIZE} bytes of I-cache, only the hottest ones will stay cached.")
+        return order, map_file
+
+    def build_hot_text(self, layout: tuple[list[str], MapFile], objects: list[str], is_last: bool) -> list[str]:
+        """
+        Returns the input section patterns for the hot functions of an overlay,
+        starting with the section that was first in it last time, since the
+        game may jump to the start of the overlay.
+        """
+        order, map_file = layout
+        files = dict()
+        first = None
+        for section in map_file.sections.values():
+            for input in section.inputs:
+                if input.name.startswith(".text."):
+                    files[input.symbol()] = input.file
+                if input.size and input.file in objects and (first is None or input.address < first.address):
+                    first = input
+        mod_objects = {src_o for ovr in self.ovrs for src_o in self.get_objects(ovr[1])}
+        lines = []
+        if first is not None and first.name.startswith(".text"):
+            lines.append(f"{first.file}({first.name})")
+        pinned = len(lines)
+        for name in order:
+            file = files.get(name)
+            if file is None:
+                continue
+            if file in objects:
+                line = f"{file}(.text.{name})"
+            elif is_last and file not in mod_objects: # libraries
+                line = f"*(.text.{name})"
+            else:
+                continue
+            if line not in lines:
+                lines.append(line)
+        if len(lines) == pinned:
+            return [] # nothing to reorder
+        return lines
+
+    @staticmethod
+    def get_objects(source: list) -> list[str]:
+        # TODO: Utilize pathlib completely
+        return [str(src.with_suffix(".o")).replace("\\", "/").replace(str(MOD_DIR), "") for src in source]
+
     def build_linker_script(self, filename="overlay.ld") -> str:
-        offset_buffer = str()
+        layout = self.load_layout()
         buffer =  "__heap_base = __ovr_end;\n"
         buffer += "\n"
         buffer += "__ovr_start = " + hex(self.base_addr) + ";\n"
@@ -93,22 +204,34 @@ class Makefile:
             source = self.ovrs[i][1] # list of pathlib
             addr = self.ovrs[i][2]
             offset = addr - self.base_addr
-            offset_buffer += section_name + " " + hex(offset) + "\n"
             buffer += " " * 8 + "." + section_name + " {\n"
             if addr > self.base_addr:
                 buffer += " " * 12 + ". = . + " + hex(offset) + ";\n"
             text, rodata, sdata, data, sbss, bss, ctors = [], [], [], [], [], [], []
             sections = [text, rodata, sdata, data, sbss, bss, ctors]
-            for src in source: # pathlib objects
-                # TODO: Utilize pathlib completely
-                src_o = src.with_suffix(".o") # remove suffix
-                src_o = str(src_o).replace("\\", "/").replace(str(MOD_DIR), "")
-                text.append(" " * 12 + f"KEEP({src_o}(.text*))\n")
-                rodata.append(" " * 12 + f"KEEP({src_o}(.rodata*))\n")
-                sdata.append(" " * 12 + f"KEEP({src_o}(.sdata*))\n")
-                data.append(" " * 12 + f"KEEP({src_o}(.data*))\n")
-                sbss.append(" " * 12 + f"KEEP({src_o}(.sbss*))\n")
-                bss.append(" " * 12 + f"KEEP({src_o}(.bss*))\n")
+            # With a layout profile, the hot functions are placed first and the
+            # rest of the code (cold or new) after the data.
+            hot = []
+            if layout is not None:
+                hot = self.build_hot_text(layout, self.get_objects(source), i == len(self.ovrs) - 1)
+            if hot:
+                # Functions which ran are reachable anyway, and the first one may be a hook
+                hot = [" " * 12 + f"KEEP({line})\n" for line in hot]
+                sections = [hot, rodata, sdata, data, sbss, bss, text, ctors]
+            for src, src_o in zip(source, self.get_objects(source)): # pathlib objects
+                # Assembly sources hold the hooks the game jumps to, so they are
+                # the entry points from which the rest of the mod is reachable.
+                # C functions called directly by the game must be marked with
+                # __attribute__((retain)) instead.
+                keep = "{}"
+                if not self.gc_sections or src.suffix.lower() == ".s":
+                    keep = "KEEP({})"
+                text.append(" " * 12 + keep.format(f"{src_o}(.text*)") + "\n")
+                rodata.append(" " * 12 + keep.format(f"{src_o}(.rodata*)") + "\n")
+                sdata.append(" " * 12 + keep.format(f"{src_o}(.sdata*)") + "\n")
+                data.append(" " * 12 + keep.format(f"{src_o}(.data*)") + "\n")
+                sbss.append(" " * 12 + keep.format(f"{src_o}(.sbss*)") + "\n")
+                bss.append(" " * 12 + keep.format(f"{src_o}(.bss*)") + "\n")
                 ctors.append(" " * 12 + f"KEEP({src_o}(.end*))\n")
             if i == len(self.ovrs) - 1:
                 text.append(" " * 12 + "*(.text*)\n")
@@ -131,15 +254,40 @@ class Makefile:
         with open(filename, "w") as file:
             file.write(buffer)
 
-        _files.create_directory(DEBUG_FOLDER)
-        with open(TRIMBIN_OFFSET, "w") as file:
-            file.write(offset_buffer)
-
         return filename
 
+    def get_pch_key(self) -> str | None:
+        """
+        Key of the current configuration in the precompiled header cache shared
+        by the mods of the game. It's computed from the flags make builds the
+        header with, so the Makefile must have been written already.
+        """
+        flags = get_build_flags()
+        if flags is None:
+            return None
+        compiler, *flags = flags
+        return get_cache_key(get_compiler_version(compiler), [self.pch, *flags], self.build_id)
+
     def build_makefile(self) -> bool:
+        if not self.set_provisional_addresses():
+            return False
         self.set_base_address()
         self.build_makefile_objects()
+        compile_order = order_by_compile_time([src for src in self.srcs if src.lower().endswith((".c", ".cpp", ".cc"))], load_compile_times(COMPILE_TIMES))
+        self.write_makefile(compile_order)
+        if self.pch:
+            # make is asked for the final flags, then the Makefile is written
+            # again with the precompiled header of that configuration.
+            key = self.get_pch_key()
+            if key is None:
+                logger.warning("Couldn't get the compiler flags from make, building without the precompiled header")
+                return True
+            pch_path, pch_dep = get_cache_path(GAME_INCLUDE_PATH / self.pch, key), get_dep_path(GAME_INCLUDE_PATH / self.pch, key)
+            prepare_cache(pch_path, pch_dep)
+            self.write_makefile(compile_order, pch_path, pch_dep)
+        return True
+
+    def write_makefile(self, compile_order: list[str], pch_path: pathlib.Path | str = "", pch_dep: pathlib.Path | str = "") -> None:
         buffer = f"""
         MODDIR := $(dir $(abspath $(lastword $(MAKEFILE_LIST))))
         TARGET = mod
@@ -151,17 +299,22 @@ class Makefile:
         DISABLE_FUNCTION_REORDER ?= {self.disable_function_reorder}
         USE_PSYQ ?= {self.use_psyq_str}
         USE_MININOOB ?= {self.use_mininoob_str}
+        USE_PROFILE ?= {self.use_profile_str}
         OVERLAYSECTION ?= {" ".join(self.ovr_section)}
         OVR_START_ADDR = {hex(self.base_addr)}
         OVERLAYSCRIPT = {self.build_linker_script()}
         BUILDDIR = $(MODDIR){OUTPUT_FOLDER}
         GAMEINCLUDEDIR = {str(GAME_INCLUDE_PATH)}
+        MININOOB_BUILDDIR = $(MODDIR){DEBUG_FOLDER / "minin00b"}/
         EXTRA_CC_FLAGS = {self.compiler_flags}
         OPT_CC_FLAGS = {self.opt_ccflags}
         OPT_LD_FLAGS = {self.opt_ldflags}
-        PCHS = {str(GAME_INCLUDE_PATH/self.pch)}
-        TRIMBIN_OFFSET = $(MODDIR){str(TRIMBIN_OFFSET)}
+        PCH_HEADER = {str(GAME_INCLUDE_PATH / self.pch) if pch_path else ""}
+        PCHS = {str(pch_path)}
+        PCH_DEP = {str(pch_dep)}
         BUILD_ID = {self.build_id}
+        COMPILE_TIMES = {str(COMPILE_TIMES_LOG)}
+        COMPILE_ORDER = {" ".join(os.path.splitext(src)[0] + ".o" for src in compile_order)}
 
         -include define.mk
         include {str(CONFIG_PATH.parents[1] / 'common.mk')}
@@ -170,8 +323,6 @@ class Makefile:
         with open(MAKEFILE, "w") as file:
             file.write(textwrap.dedent(buffer)) # removes indentation
 
-        return True
-
     def delete_temp_files(self) -> None:
         for ovr in self.ovrs:
             for src in ovr[1]: # list of pathlibs
@@ -185,13 +336,16 @@ class Makefile:
             for src in ovr[1]:
                 obj_path = src.with_suffix(".o")
                 dep_path = src.with_suffix(".dep")
-                if _files.check_file(obj_path) and _files.check_file(dep_path):
+                # The .dep files are written by the compiler alongside the
+                # objects, except for assembly sources which have none.
+                if _files.check_file(obj_path, quiet=True):
                     obj_dst = OBJ_FOLDER / obj_path.name
-                    dep_dst = DEP_FOLDER / dep_path.name
                     buffer += f"{obj_dst} {obj_path}\n"
-                    buffer += f"{dep_dst} {dep_path}\n"
                     shutil.move(obj_path, obj_dst)
-                    shutil.move(dep_path, dep_dst)
+                    if _files.check_file(dep_path, quiet=True):
+                        dep_dst = DEP_FOLDER / dep_path.name
+                        buffer += f"{dep_dst} {dep_path}\n"
+                        shutil.move(dep_path, dep_dst)
         with open(COMP_SOURCE, "w") as file:
             file.write(buffer)
 
@@ -203,7 +357,51 @@ class Makefile:
                     line = [l.strip() for l in line.split()]
                     shutil.move(line[0], line[1])
 
-    def make(self) -> bool:
+    def split_overlays(self, elf_path: pathlib.Path) -> bool:
+        """
+        Writes each overlay section of the linked elf to the output folder,
+        skipping the padding that places it at its address in the shared
+        OVERLAY block, and saves a manifest with the size of every overlay.
+        Returns False if a section is missing from the elf, after deleting
+        its binary from the previous build so that it can't be injected.
+        """
+        elf = Elf.from_file(elf_path)
+        manifest = []
+        print("\n[Makefile-py] Overlays:")
+        print(f"{'section':<24}{'address':>12}{'size':>10}{'mem size':>10}")
+        self.overlay_sizes.clear()
+        missing = []
+        for section_name, _, addr, _ in self.ovrs:
+            path = pathlib.Path(OUTPUT_FOLDER) / (section_name + ".bin")
+            section = elf.get_section("." + section_name)
+            if section is None:
+                logger.error(f"Section .{section_name} not found in {elf_path}")
+                _files.delete_file(path)
+                missing.append(section_name)
+                continue
+            if elf.get_load_segment(section) is None:
+                logger.warning(f"Section .{section_name} is not part of any loadable segment")
+            trim = max(addr - section.addr, 0)
+            data = elf.section_data(section)[trim:]
+            # Unlike the file size, this also accounts for bss-only overlays
+            mem_size = max(section.size - trim, 0)
+            self.overlay_sizes[section_name] = mem_size
+            with open(path, "wb") as file:
+                file.write(data)
+            print(f"{section_name:<24}{hex(addr):>12}{len(data):>10}{mem_size:>10}")
+            manifest.append({
+                "section": section_name,
+                "file": str(path).replace("\\", "/"),
+                "address": hex(addr),
+                "end": hex(addr + mem_size),
+                "size": len(data),
+                "mem_size": mem_size,
+            })
+        with open(OVERLAY_MANIFEST, "w") as file:
+            json.dump({"overlays": manifest}, file, indent=4)
+        return not missing
+
+    def link(self, message: str) -> bool:
         """
         TODO: Creating all of these directories right now instead of upfront is bad design
         TODO: Keep track of all files incase this fails to clean up after ourselves
@@ -213,25 +411,32 @@ class Makefile:
         _files.create_directory(OBJ_FOLDER)
         _files.create_directory(DEP_FOLDER)
         self.restore_temp_files()
-        cli_clear()
-        print("\n[Makefile-py] Compiling " + MOD_NAME + "...\n")
+        print(f"\n[Makefile-py] {message}...\n")
         start_time = time()
+        jobs = get_job_count(self.jobs)
+        command = ["make", f"-j{jobs}", f"-l{get_load_limit()}", "--silent"] # TODO: Point to the CWD directory
+        if make_supports_output_sync():
+            # Prints the diagnostics of each file together, as soon as it's compiled
+            command.append("--output-sync=target")
+        _files.delete_file(COMPILE_TIMES_LOG)
         try:
-            command = ["make", "-j8", "--silent"] # TODO: Point to the CWD directory
             with open(GCC_OUT_FILE, "w") as outfile:
-                result = subprocess.run(command, stdout=outfile, stderr=subprocess.STDOUT)
-                if result.returncode != 0:
-                    logger.critical(f"Compilation failed. See {GCC_OUT_FILE}")
-                    return False
-        except subprocess.CalledProcessError as error:
+                process = subprocess.Popen(command, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+                for line in process.stdout:
+                    print(line, end="")
+                    outfile.write(line)
+                returncode = process.wait()
+        except OSError as error:
             logger.exception(error, exc_info = False)
             logger.critical(f"Compilation failed. See {GCC_OUT_FILE}")
             return False
+        finally:
+            update_compile_times(COMPILE_TIMES, COMPILE_TIMES_LOG)
+        if returncode != 0:
+            logger.critical(f"Compilation failed. See {GCC_OUT_FILE}")
+            return False
         end_time = time()
         total_time = str(round(end_time - start_time, 3))
-        with open(GCC_OUT_FILE, "r") as file:
-            for line in file:
-                print(line)
 
         # These are relaive to the current Makefile
         if (not os.path.isfile("mod.map")) or (not os.path.isfile("mod.elf")):
@@ -243,18 +448,94 @@ class Makefile:
         shutil.move("mod.map", GCC_MAP_FILE)
         shutil.move("mod.elf", DEBUG_FOLDER / "mod.elf")
         self.move_temp_files()
+        if not self.split_overlays(DEBUG_FOLDER / "mod.elf"):
+            logger.critical(f"Compilation completed but unsuccessful. ({total_time}s)")
+            return False
+
+        logger.info(f"Compilation successful ({total_time}s, {jobs} jobs)")
+        return True
+
+    def place_auto_sections(self) -> dict[str, int] | None:
+        """
+        Places the auto sections into the free regions of their disc.json
+        section, minus the space taken by the other sections, now that their
+        sizes are known. Returns the sections whose address changed.
+        """
+        self.load_free_regions()
+        fixed = []
+        for instance in self.list_compile_lists:
+            if not instance.is_auto:
+                fixed.append((instance.address, instance.address + self.overlay_sizes.get(instance.section_name, 0)))
+        holes = {name: subtract(regions, fixed) for name, regions in self.free_regions.items()}
+        requests = [(instance.section_name, instance.game_file, self.overlay_sizes.get(instance.section_name, 0))
+            for instance in self.list_compile_lists if instance.is_auto]
+        try:
+            addresses = best_fit(holes, requests)
+        except PlacementError as error:
+            logger.critical(f"Unable to place the auto sections: {error}")
+            return None
+        changed = dict()
+        for instance in self.list_compile_lists:
+            if instance.is_auto and addresses[instance.section_name] != instance.address:
+                instance.address = addresses[instance.section_name]
+                changed[instance.section_name] = instance.address
+        return changed
 
-        logger.info(f"Compilation successful ({total_time}s)")
-        special_symbols = ["__heap_base", "__ovr_start", "__ovr_end", "OVR_START_ADDR", "__mod_end"]
-        buffer = ""
-        with open(GCC_MAP_FILE, "r") as file:
-            for line in file:
-                line = line.split()[:2]
-                if len(line) == 2 and len(line[0]) == 10 and line[0][:2] == "0x":
-                    if not ("." in line[1] or "/" in line[1] or "\\" in line[1]):
-                        if line[1][0] != "0" and line[1] not in special_symbols:
-                            buffer += line[0][2:] + " " + line[1] + "\n"
+    def check_placement(self) -> bool:
+        """ Fails if sections of the same disc.json section overlap, or if an auto section outgrew its region. """
+        is_valid = True
+        sections = []
+        for instance in self.list_compile_lists:
+            size = self.overlay_sizes.get(instance.section_name, 0)
+            sections.append((instance.section_name, instance.game_file, instance.address, instance.address + size))
+            if instance.is_auto and not any(start <= instance.address and instance.address + size <= end
+                for start, end in self.free_regions.get(instance.game_file, [])):
+                logger.critical(f"{instance.section_name} doesn't fit in its free region anymore")
+                is_valid = False
+        for name, other in find_overlaps(sections):
+            logger.critical(f"Sections {name} and {other} overlap")
+            is_valid = False
+        return is_valid
+
+    def report_sizes(self, map_file: MapFile) -> bool:
+        """ Writes the size report and fails if an overlay is over its budget. """
+        is_valid = True
+        overlays = []
+        for instance in self.list_compile_lists:
+            size = self.overlay_sizes.get(instance.section_name, 0)
+            overlays.append((instance.section_name, instance.address, size, instance.budget, instance.address - self.base_addr))
+            if instance.budget is not None:
+                print(f"[Makefile-py] {instance.section_name}: {size}/{instance.budget} bytes")
+                if size > instance.budget:
+                    logger.critical(f"{instance.section_name} is {size - instance.budget} bytes over its budget. See {SIZE_REPORT}")
+                    is_valid = False
+        with open(SIZE_REPORT, "w") as file:
+            file.write(size_report(map_file, overlays))
+        return is_valid
 
+    def write_symbols(self, map_file: MapFile) -> None:
+        """ Saves the symbol index of the mod, and the map uploaded to redux. """
+        index = SymbolIndex.from_elf(Elf.from_file(DEBUG_FOLDER / "mod.elf"), map_file)
+        index.save(SYMBOL_INDEX)
         with open(REDUX_MAP_FILE, "w") as file:
-            file.write(buffer)
+            file.write(index.redux_map())
+
+    def make(self) -> bool:
+        cli_clear()
+        if not self.link("Compiling " + MOD_NAME):
+            return False
+        if any(instance.is_auto for instance in self.list_compile_lists):
+            changed = self.place_auto_sections()
+            if changed is None:
+                return False
+            for name, addr in changed.items():
+                print(f"[Makefile-py] {name} placed at {hex(addr)}")
+            # The objects don't depend on the addresses, so only the link has to
+            # be redone.
+            if changed and not (self.build_makefile() and self.link("Relinking " + MOD_NAME)):
+                return False
+        map_file = MapFile.from_file(GCC_MAP_FILE)
+        if not self.check_placement() or not self.report_sizes(map_file):
+            return False
+        self.write_symbols(map_file)
         return True
\ No newline at end of file
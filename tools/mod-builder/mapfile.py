@@ -0,0 +1,153 @@
+"""
+Parser for the map files written by GNU ld (-Map), used to report what takes
+space in each overlay and what was removed by --gc-sections.
+"""
+from __future__ import annotations # to use type in python 3.7
+
+import re
+from collections import defaultdict
+from dataclasses import dataclass, field
+
+SECTION_RE = re.compile(r"^(\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)")
+INPUT_RE = re.compile(r"^ (\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+FILL_RE = re.compile(r"^ \*fill\*\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)")
+CONTINUATION_RE = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+(\S.*))?$")
+NAME_RE = re.compile(r"^ ?([.\w][^\s()]*)$")
+
+# Prefixes added to the names of sections by -ffunction-sections and -fdata-sections
+SECTION_PREFIXES = [".text.", ".rodata.", ".data.", ".sdata.", ".bss.", ".sbss."]
+
+@dataclass
+class InputSection:
+    name: str
+    address: int
+    size: int
+    file: str
+
+    def symbol(self) -> str:
+        """ Name of the function or variable the section was created for, if any. """
+        for prefix in SECTION_PREFIXES:
+            if self.name.startswith(prefix):
+                return self.name[len(prefix):]
+        return self.name
+
+    def end(self) -> int:
+        return self.address + self.size
+
+@dataclass
+class OutputSection:
+    name: str
+    address: int
+    size: int
+    inputs: list[InputSection] = field(default_factory=list)
+    fill: int = 0
+
+class MapFile:
+    def __init__(self, text: str) -> None:
+        self.discarded = []
+        self.sections = dict()
+        mode = None
+        current = None # output section
+        pending = None # section name wrapped onto the next line
+        for line in text.splitlines():
+            line = line.rstrip()
+            if line == "Discarded input sections":
+                mode, current, pending = "discarded", None, None
+                continue
+            if line == "Memory Configuration":
+                mode, current, pending = None, None, None
+                continue
+            if line == "Linker script and memory map":
+                mode, current, pending = "map", None, None
+                continue
+            if mode is None or not line:
+                continue
+
+            if pending is not None:
+                name, is_output, pending = pending[0], pending[1], None
+                match = CONTINUATION_RE.match(line)
+                if match:
+                    address, size, file = int(match.group(1), 16), int(match.group(2), 16), match.group(3)
+                    if is_output:
+                        current = self.add_output(name, address, size)
+                    else:
+                        self.add_input(mode, current, InputSection(name, address, size, file or ""))
+                    continue
+
+            if mode == "map" and not line[0].isspace():
+                match = SECTION_RE.match(line)
+                if match:
+                    current = self.add_output(match.group(1), int(match.group(2), 16), int(match.group(3), 16))
+                elif NAME_RE.match(line):
+                    pending = (line, True)
+                else: # LOAD, OUTPUT, ...
+                    current = None
+                continue
+
+            match = FILL_RE.match(line)
+            if match:
+                if current is not None:
+                    current.fill += int(match.group(2), 16)
+                continue
+            match = INPUT_RE.match(line)
+            if match:
+                section = InputSection(match.group(1), int(match.group(2), 16), int(match.group(3), 16), match.group(4))
+                self.add_input(mode, current, section)
+                continue
+            match = NAME_RE.match(line)
+            if match and line[0] == " " and line[1] != " ":
+                pending = (match.group(1), False)
+
+    def add_output(self, name: str, address: int, size: int) -> OutputSection:
+        section = OutputSection(name, address, size)
+        self.sections[name] = section
+        return section
+
+    def add_input(self, mode: str, current: OutputSection | None, section: InputSection) -> None:
+        if mode == "discarded":
+            self.discarded.append(section)
+        elif current is not None:
+            current.inputs.append(section)
+
+    @staticmethod
+    def from_file(path) -> MapFile:
+        with open(path, "r") as file:
+            return MapFile(file.read())
+
+def size_report(map_file: MapFile, overlays: list[tuple[str, int, int, int | None, int]]) -> str:
+    """
+    Builds a text report of the space used in each (name, address, size, budget,
+    trimmed padding) overlay by source file and by function or variable,
+    followed by the sections removed by --gc-sections.
+    """
+    out = []
+    for name, address, size, budget, trim in overlays:
+        usage = f"{size} bytes"
+        if budget is not None:
+            usage += f" of {budget} ({size * 100 / budget if budget else 100:.1f}%)"
+        out.append(f"{name} at {hex(address)}: {usage}")
+        section = map_file.sections.get("." + name)
+        if section is None:
+            out.append("")
+            continue
+        by_file = defaultdict(int)
+        for input in section.inputs:
+            by_file[input.file] += input.size
+        out.append("  By file:")
+        for file, file_size in sorted(by_file.items(), key=lambda item: (-item[1], item[0])):
+            if file_size:
+                out.append(f"    {file_size:>8}  {file}")
+        padding = section.fill - trim
+        if padding > 0:
+            out.append(f"    {padding:>8}  (alignment padding)")
+        out.append("  By function/variable:")
+        for input in sorted(section.inputs, key=lambda input: (-input.size, input.name)):
+            if input.size:
+                out.append(f"    {input.size:>8}  {input.symbol():<40} {input.file}")
+        out.append("")
+
+    removed = [section for section in map_file.discarded if section.size]
+    out.append(f"Removed by --gc-sections: {sum(section.size for section in removed)} bytes")
+    for section in sorted(removed, key=lambda section: (section.file, section.name)):
+        out.append(f"    {section.size:>8}  {section.symbol():<40} {section.file}")
+    return "\n".join(out) + "\n"
@@ -0,0 +1,434 @@
+"""
+Encoder for MDEC bitstreams
+
+Converts images into the .BS format decoded by psxpress (DecDCTvlcStart(),
+DecDCTvlcStart2()) and by the Sony library, and image sequences into video-only
+.STR streams. Frames go through the same steps the MDEC undoes: color space
+conversion, 8x8 DCT, quantization against the DECDCTENV tables, zigzag reordering
+and Huffman coding using the tree in minin00b's generate_lookup_table.py.
+"""
+from __future__ import annotations # to use type in python 3.7
+
+import concurrent.futures
+import importlib.util
+import logging
+import math
+import os
+import pathlib
+import struct
+
+logger = logging.getLogger(__name__)
+
+LOOKUP_TABLE_SCRIPT = pathlib.Path(__file__).resolve().parents[1] / "minin00b" / "psxpress" / "generate_lookup_table.py"
+
+# Default quantization tables (in zigzag order) uploaded by DecDCTPutEnv(0, 0),
+# must match _default_mdec_env in minin00b/psxpress/mdec.c.
+DEFAULT_IQ_TABLE = (
+     2, 16, 16, 19, 16, 19, 22, 22,
+    22, 22, 22, 22, 26, 24, 26, 27,
+    27, 27, 26, 26, 26, 26, 27, 27,
+    27, 29, 29, 29, 34, 34, 34, 29,
+    29, 29, 27, 27, 29, 29, 32, 32,
+    34, 34, 37, 38, 37, 35, 35, 34,
+    35, 38, 38, 40, 40, 40, 48, 48,
+    46, 46, 56, 56, 58, 69, 69, 83
+)
+
+BS_HEADER_SIZE = 8
+MDEC_HEADER = 0x3800
+MDEC_DMA_CHUNK = 32 # words
+MIN_QUANT_SCALE = 1
+MAX_QUANT_SCALE = 63
+EOB_CODE = "10"
+ESCAPE_CODE = "000001"
+END_OF_FRAME_CODES = { 2: "0111111111", 3: "111111111" }
+
+CD_SECTOR_SIZE = 2048
+STR_HEADER_SIZE = 32
+STR_PAYLOAD_SIZE = CD_SECTOR_SIZE - STR_HEADER_SIZE
+STR_MAGIC = 0x0160
+STR_TYPE_MDEC = 0x8001
+
+imgs = [] # global
+
+## Tables
+
+def load_lookup_table_script(path = LOOKUP_TABLE_SCRIPT):
+    """
+    The Huffman tree is only defined once, in the script the decoder's lookup
+    tables are generated from
+    """
+    spec = importlib.util.spec_from_file_location("generate_lookup_table", path)
+    module = importlib.util.module_from_spec(spec)
+    spec.loader.exec_module(module)
+    return module
+
+def build_ac_codes(tree, prefix = "") -> dict:
+    """ Flattens the Huffman tree into a (run, level) -> code dictionary """
+    codes = dict()
+    for code, value in tree.items():
+        if type(value) is dict:
+            codes.update(build_ac_codes(value, prefix + code))
+        elif type(value) is tuple:
+            codes[value] = prefix + code
+    return codes
+
+def zigzag_order(size = 8) -> list[int]:
+    """ Returns the raster index of each coefficient in zigzag order """
+    coords = [(y, x) for y in range(size) for x in range(size)]
+    coords.sort(key = lambda c: (c[0] + c[1], c[0] if (c[0] + c[1]) % 2 else -c[0]))
+    return [(y * size) + x for y, x in coords]
+
+def dct_matrix(size = 8) -> list[list[float]]:
+    """ Orthonormal DCT-II basis, the inverse of the MDEC's IDCT matrix """
+    matrix = []
+    for u in range(size):
+        scale = math.sqrt((1 if u else 0.5) / (size / 2))
+        matrix.append([scale * math.cos(((2 * x) + 1) * u * math.pi / (2 * size)) for x in range(size)])
+    return matrix
+
+def load_env(fname) -> tuple[tuple[int], tuple[int]]:
+    """
+    Reads the quantization tables from a binary DECDCTENV structure (as passed
+    to DecDCTPutEnv()). The IDCT matrix is ignored.
+    """
+    with open(fname, "rb") as file:
+        data = file.read(128)
+    if len(data) != 128:
+        raise ValueError(f"Invalid DECDCTENV file: {fname}")
+    return tuple(data[:64]), tuple(data[64:])
+
+ZIGZAG = zigzag_order()
+DCT = dct_matrix()
+
+## Frame transform
+
+def rgb_to_planes(pixels, width: int, height: int) -> tuple[list[float], list[float], list[float], int, int]:
+    """
+    Converts a row-major list of (r, g, b) tuples to Y, Cb and Cr planes using
+    the same coefficients as the MDEC, padding each side to a multiple of 16
+    pixels by repeating the last row/column. Chroma is subsampled 2x2.
+    """
+    mb_width = (width + 15) // 16 * 16
+    mb_height = (height + 15) // 16 * 16
+
+    luma = [0.0] * (mb_width * mb_height)
+    cb_full = [0.0] * (mb_width * mb_height)
+    cr_full = [0.0] * (mb_width * mb_height)
+    for y in range(mb_height):
+        row = min(y, height - 1) * width
+        for x in range(mb_width):
+            r, g, b = pixels[row + min(x, width - 1)][:3]
+            i = (y * mb_width) + x
+            luma[i] = (0.299 * r) + (0.587 * g) + (0.114 * b) - 128
+            cb_full[i] = (-0.168736 * r) - (0.331264 * g) + (0.5 * b)
+            cr_full[i] = (0.5 * r) - (0.418688 * g) - (0.081312 * b)
+
+    c_width = mb_width // 2
+    cb = [0.0] * (c_width * (mb_height // 2))
+    cr = [0.0] * (c_width * (mb_height // 2))
+    for y in range(mb_height // 2):
+        for x in range(c_width):
+            i = (y * 2 * mb_width) + (x * 2)
+            j = i + mb_width
+            cb[(y * c_width) + x] = (cb_full[i] + cb_full[i + 1] + cb_full[j] + cb_full[j + 1]) / 4
+            cr[(y * c_width) + x] = (cr_full[i] + cr_full[i + 1] + cr_full[j] + cr_full[j + 1]) / 4
+
+    return luma, cb, cr, mb_width, mb_height
+
+def fdct(plane: list[float], stride: int, x: int, y: int) -> list[float]:
+    """ 2D DCT of the 8x8 block at (x, y), returned in zigzag order """
+    rows = []
+    for j in range(8):
+        offset = ((y + j) * stride) + x
+        line = plane[offset:offset + 8]
+        rows.append([sum(c * p for c, p in zip(basis, line)) for basis in DCT])
+
+    coeffs = [0.0] * 64
+    for v, basis in enumerate(DCT):
+        for u in range(8):
+            coeffs[(v * 8) + u] = sum(basis[j] * rows[j][u] for j in range(8))
+
+    return [coeffs[i] for i in ZIGZAG]
+
+def transform_frame(pixels, width: int, height: int) -> list[list[float]]:
+    """
+    Returns the DCT coefficients of every block in bitstream order: macroblocks
+    go top to bottom, then left to right, and each one is made up of its Cr, Cb,
+    Y1, Y2, Y3 and Y4 blocks.
+    """
+    luma, cb, cr, mb_width, mb_height = rgb_to_planes(pixels, width, height)
+    c_stride = mb_width // 2
+
+    blocks = []
+    for mb_x in range(0, mb_width, 16):
+        for mb_y in range(0, mb_height, 16):
+            blocks.append(fdct(cr, c_stride, mb_x // 2, mb_y // 2))
+            blocks.append(fdct(cb, c_stride, mb_x // 2, mb_y // 2))
+            blocks.append(fdct(luma, mb_width, mb_x, mb_y))
+            blocks.append(fdct(luma, mb_width, mb_x + 8, mb_y))
+            blocks.append(fdct(luma, mb_width, mb_x, mb_y + 8))
+            blocks.append(fdct(luma, mb_width, mb_x + 8, mb_y + 8))
+    return blocks
+
+## Bitstream encoding
+
+class Encoder:
+    """
+    Quantizes and Huffman codes transformed frames for a given bitstream
+    version and pair of quantization tables
+    """
+    def __init__(self, version: int, iq_y = DEFAULT_IQ_TABLE, iq_c = DEFAULT_IQ_TABLE) -> None:
+        if version not in END_OF_FRAME_CODES:
+            raise ValueError(f"Unsupported bitstream version: {version}")
+        script = load_lookup_table_script()
+        self.version = version
+        self.iq_y = iq_y
+        self.iq_c = iq_c
+        self.ac_codes = build_ac_codes(script.HUFFMAN_TREE)
+        self.dc_luma_codes = script.DC_LUMA_CODES
+        self.dc_chroma_codes = script.DC_CHROMA_CODES
+
+    def encode_ac(self, run: int, level: int) -> str:
+        code = self.ac_codes.get((run, abs(level)))
+        if code is not None:
+            return code + ("1" if level < 0 else "0")
+        return ESCAPE_CODE + format(run, "06b") + format(level & 0x3ff, "010b")
+
+    def encode_dc_v3(self, delta: int, is_luma: bool) -> str:
+        size = abs(delta).bit_length()
+        code = (self.dc_luma_codes if is_luma else self.dc_chroma_codes)[size]
+        if size:
+            # Negative values are stored in one's complement, as in JPEG.
+            code += format(delta if delta > 0 else delta + (1 << size) - 1, f"0{size}b")
+        return code
+
+    def encode(self, blocks: list[list[float]], quant_scale: int) -> bytes:
+        """ Returns a complete .BS frame, header included """
+        bits = []
+        num_codes = 0
+        last = [0, 0, 0] # Y, Cb, Cr (v3 only)
+
+        for index, coeffs in enumerate(blocks):
+            block_type = index % 6 # 0 = Cr, 1 = Cb, 2-5 = Y
+            iq = self.iq_y if block_type >= 2 else self.iq_c
+
+            # The DC coefficient is not affected by the quantization scale, v3
+            # streams only store its upper 8 bits as a delta from the last
+            # block of the same type.
+            if self.version == 3:
+                dc = min(max(round(coeffs[0] / (iq[0] * 4)), -128), 127)
+                predictor = 0 if block_type >= 2 else 2 - block_type
+                bits.append(self.encode_dc_v3(dc - last[predictor], block_type >= 2))
+                last[predictor] = dc
+            else:
+                # 0x1ff is reserved for the end-of-frame marker.
+                dc = min(max(round(coeffs[0] / iq[0]), -0x200), 0x1fe)
+                bits.append(format(dc & 0x3ff, "010b"))
+
+            run = 0
+            num_codes += 2
+            for k in range(1, 64):
+                level = round((coeffs[k] * 8) / (iq[k] * quant_scale))
+                if not level:
+                    run += 1
+                    continue
+                bits.append(self.encode_ac(run, min(max(level, -0x200), 0x1ff)))
+                run = 0
+                num_codes += 1
+            bits.append(EOB_CODE)
+
+        bits.append(END_OF_FRAME_CODES[self.version])
+        bitstream = "".join(bits)
+        bitstream += "0" * (-len(bitstream) % 32)
+
+        # The decoder reads the bitstream in 16-bit little endian units, MSB
+        # first.
+        data = bytearray(BS_HEADER_SIZE + (len(bitstream) // 8))
+        for i in range(0, len(bitstream), 16):
+            struct.pack_into("<H", data, BS_HEADER_SIZE + (i // 8), int(bitstream[i:i + 16], 2))
+
+        # The length of the decoded data is rounded up to a multiple of the
+        # MDEC's DMA chunk size, the decoder pads the rest.
+        num_words = (num_codes + 1) // 2
+        num_words += -num_words % MDEC_DMA_CHUNK
+        struct.pack_into("<HHHH", data, 0, num_words, MDEC_HEADER, quant_scale, self.version)
+        return bytes(data)
+
+    def encode_to_budget(self, blocks: list[list[float]], budget: int) -> tuple[bytes, int]:
+        """
+        Rate control: binary searches for the lowest quantization scale whose
+        output fits within budget bytes. A budget of 0 means no limit.
+        """
+        if not budget:
+            return self.encode(blocks, MIN_QUANT_SCALE), MIN_QUANT_SCALE
+
+        best = None
+        low, high = MIN_QUANT_SCALE, MAX_QUANT_SCALE
+        while low <= high:
+            quant_scale = (low + high) // 2
+            data = self.encode(blocks, quant_scale)
+            if len(data) <= budget:
+                best = (data, quant_scale)
+                high = quant_scale - 1
+            else:
+                low = quant_scale + 1
+
+        if best is None:
+            best = (self.encode(blocks, MAX_QUANT_SCALE), MAX_QUANT_SCALE)
+        return best
+
+## .STR container
+
+def build_str(frames: list[bytes], width: int, height: int, sectors_per_frame: int) -> bytes:
+    """
+    Splits each .BS frame into sectors with a STR header, padding each frame
+    to sectors_per_frame sectors so the stream plays back at a constant rate.
+    Frames that do not fit take as many sectors as they need.
+    """
+    stream = bytearray()
+    for frame_id, frame in enumerate(frames, start = 1):
+        num_chunks = max(sectors_per_frame, (len(frame) + STR_PAYLOAD_SIZE - 1) // STR_PAYLOAD_SIZE)
+        mdec0_header, quant_scale, version = struct.unpack_from("<IHH", frame)
+        for chunk in range(num_chunks):
+            payload = frame[chunk * STR_PAYLOAD_SIZE:(chunk + 1) * STR_PAYLOAD_SIZE]
+            stream += struct.pack(
+                "<HHHHIIHHIHHI",
+                STR_MAGIC, STR_TYPE_MDEC, chunk, num_chunks, frame_id, len(frame),
+                width, height, mdec0_header, quant_scale, version, 0
+            )
+            stream += payload.ljust(STR_PAYLOAD_SIZE, b"\0")
+    return bytes(stream)
+
+## Assets
+
+def load_rgb(fname) -> tuple[list[tuple[int]], int, int]:
+    from PIL import Image as PILImage # only needed when encoding files
+
+    with PILImage.open(str(fname)) as img:
+        img = img.convert("RGB")
+        return list(img.getdata()), img.width, img.height
+
+encoders = dict() # per worker process
+
+def encode_file(fname, version: int, budget: int, env = None) -> tuple[bytes, int, int, int]:
+    """ Worker entry point, returns (data, quant_scale, width, height) """
+    pixels, width, height = load_rgb(fname)
+    if (version, env) not in encoders:
+        encoders[(version, env)] = Encoder(version, *env) if env else Encoder(version)
+    encoder = encoders[(version, env)]
+    data, quant_scale = encoder.encode_to_budget(transform_frame(pixels, width, height), budget)
+    return data, quant_scale, width, height
+
+class Bitstream:
+    """
+    Class for MDEC bitstream assets
+
+    A single image is encoded to a .BS file, a directory of images (sorted by
+    name) to a .STR file
+    """
+    def __init__(self, path: pathlib.Path) -> None:
+        self.valid = self.check_naming_convention(path.stem)
+        if not self.is_valid():
+            return
+
+        fname_parts = path.stem.split("_")
+        self.name = fname_parts[0]
+        self.version = int(fname_parts[1])
+        self.sectors = int(fname_parts[2])
+        self.is_str = path.is_dir()
+        if self.is_str:
+            self.frames = sorted(path.glob("*.png"))
+            self.budget = self.sectors * STR_PAYLOAD_SIZE
+        else:
+            self.frames = [path]
+            self.budget = self.sectors * CD_SECTOR_SIZE
+        if not len(self.frames):
+            logger.error(f"No frames found for: {path}")
+            self.valid = False
+        self.output_path = None
+
+    @staticmethod
+    def check_naming_convention(fname):
+        """
+        Any bitstream file or directory should be of the form
+        NAME_#_# (name, bitstream version, sectors per frame)
+        """
+        list_parts = fname.split("_")
+        if len(list_parts) != 3 or not list_parts[1].isdigit() or not list_parts[2].isdigit():
+            logger.error(f"wrong naming convention for bitstream: {fname}")
+            return False
+        if int(list_parts[1]) not in END_OF_FRAME_CODES:
+            logger.error(f"bitstream version must be 2 or 3: {fname}")
+            return False
+
+        return True
+
+    def is_valid(self) -> bool:
+        return self.valid
+
+    def get_path(self) -> str:
+        return self.output_path
+
+    def encode(self, executor: concurrent.futures.Executor, dir_out: pathlib.Path, env = None) -> None:
+        results = list(executor.map(
+            encode_file, self.frames,
+            [self.version] * len(self.frames),
+            [self.budget] * len(self.frames),
+            [env] * len(self.frames)
+        ))
+
+        over_budget = [data for data, _, _, _ in results if self.budget and len(data) > self.budget]
+        if len(over_budget):
+            logger.warning(f"{self.name}: {len(over_budget)} frame(s) exceed {self.sectors} sector(s) at the maximum quantization scale")
+
+        _, _, width, height = results[0]
+        if self.is_str:
+            if any((w, h) != (width, height) for _, _, w, h in results):
+                logger.error(f"{self.name}: all frames must have the same size")
+                return
+            data = build_str([data for data, _, _, _ in results], width, height, self.sectors)
+            self.output_path = dir_out / f"{self.name}.str"
+        else:
+            data = results[0][0]
+            self.output_path = dir_out / f"{self.name}.bs"
+
+        with open(self.output_path, "wb") as file:
+            file.write(data)
+        scales = [quant_scale for _, quant_scale, _, _ in results]
+        logger.info(f"{self.name}: {len(results)} frame(s), {width}x{height}, quantization scale {min(scales)}-{max(scales)} -> {self.output_path}")
+
+def get_bitstream_list() -> list[Bitstream]:
+    return imgs
+
+def clear_bitstreams() -> None:
+    imgs.clear()
+
+def create_bitstreams(directory) -> int:
+    """
+    Looks for .png files (encoded to .BS) and directories of .png files
+    (encoded to .STR), skipping the output directory
+    Affects the global bitstream list
+    """
+    count = 0
+    dir_path = pathlib.Path(directory)
+    if not dir_path.exists():
+        return count
+    for path in sorted(dir_path.iterdir()):
+        if path.name == "output" or not (path.is_dir() or path.suffix == ".png"):
+            continue
+        count += 1
+        logger.debug(path)
+        bs = Bitstream(path)
+        if bs.is_valid():
+            imgs.append(bs)
+    return count
+
+def encode_bitstreams(dir_out: str, env_fname = None) -> None:
+    """ Encodes every frame of every asset in parallel, one process per core """
+    logger.info("Encoding bitstreams...")
+    env = load_env(env_fname) if env_fname else None
+    path_out = pathlib.Path(dir_out)
+    with concurrent.futures.ProcessPoolExecutor(max_workers = os.cpu_count()) as executor:
+        for bs in imgs:
+            bs.encode(executor, path_out, env)
@@ -9,7 +9,7 @@ import _files # check_file, delete_file, create_directory, delete_directory
 from common import ISO_PATH, MOD_NAME, OUTPUT_FOLDER, COMPILE_LIST , FILE_LIST , MOD_DIR, PLUGIN_PATH, request_user_input, cli_pause, get_build_id
 from game_options import game_options
 from disc import Disc
-from compile_list import CompileList, free_sections
+from compile_list import get_compile_plan
 from syms import Syms
 
 import importlib
@@ -103,95 +103,91 @@ class Mkpsxiso:
         build_lists = ["./"] # cwd
         while build_lists:
             prefix = build_lists.pop(0)
-            bl = (pathlib.Path(prefix) / COMPILE_LIST).resolve() # TODO: Double check
-            free_sections()
-            with open(bl, "r") as file:
-                for line in file:
-                    instance_cl = CompileList(line, sym, prefix)
-                    if not instance_cl.should_build():
+            for instance_cl in get_compile_plan(sym, prefix):
+                if not instance_cl.should_build():
+                    continue
+
+                # if it's a file to be overwritten in the game
+                df = disc.get_df(instance_cl.game_file)
+                if df is not None:
+                    # checking file start boundaries
+                    if instance_cl.address < df.address:
+                        error_msg = f"""
+                        [ISO-py] ERROR: Cannot overwrite {df.physical_file}
+                        Base address {hex(df.address)} is bigger than the requested address {hex(instance_cl.address)}
+                        At line: {instance_cl.original_line}
+                        """
+                        print(error_msg)
+                        if self.abort_build_request():
+                            return False
                         continue
 
-                    # if it's a file to be overwritten in the game
-                    df = disc.get_df(instance_cl.game_file)
-                    if df is not None:
-                        # checking file start boundaries
-                        if instance_cl.address < df.address:
-                            error_msg = f"""
-                            [ISO-py] ERROR: Cannot overwrite {df.physical_file}
-                            Base address {hex(df.address)} is bigger than the requested address {hex(instance_cl.address)}
-                            At line: {instance_cl.original_line}
-                            """
-                            print(error_msg)
-                            if self.abort_build_request():
-                                return False
-                            continue
-
-                        # checking whether the original file exists and retrieving its size
-                        game_file = dir_in_build / df.physical_file
-                        if not _files.check_file(game_file):
-                            if self.abort_build_request():
-                                return False
-                            continue
-                        game_file_size = os.path.getsize(game_file)
-
-                        # checking whether the modded file exists and retrieving its size
-                        mod_file = instance_cl.get_output_name()
-                        if not _files.check_file(mod_file):
-                            if self.abort_build_request():
-                                return False
-                            continue
-                        mod_size = os.path.getsize(mod_file)
-
-                        # Checking potential file size overflows and warning the user about them
-                        offset = instance_cl.address - df.address + df.offset
-                        if (mod_size + offset) > game_file_size:
-                            logger.warning(f"{mod_file} will increase total file size of {game_file}\n")
-
-                        mod_data = bytearray()
-                        with open(mod_file, "rb") as mod:
-                            mod_data = bytearray(mod.read())
-                        if game_file not in modded_files:
-                            modified_game_file = dir_in_build / df.physical_file
-                            modded_stream = open(modified_game_file, "r+b") # BUG: Should this be closed?
-                            modded_files[game_file] = [modded_stream, bytearray(modded_stream.read())]
-                            iso_changed = True
-
-                        modded_stream = modded_files[game_file][0]
-                        modded_buffer = modded_files[game_file][1]
-                        # Add zeroes if the new total file size is more than the original file size
-                        for i in range(len(modded_buffer), offset + mod_size):
-                            modded_buffer.append(0)
-                        for i in range(mod_size):
-                            modded_buffer[i + offset] = mod_data[i]
-
-                    # if it's not a file to be overwritten in the game
-                    # assume it's a new file to be inserted in the disc
-                    else:
-                        filename = (instance_cl.section_name + ".bin").upper()
-                        filename_len = len(filename)
-                        if filename_len > 12:
-                            filename = filename[(filename_len - 12):] # truncate
-                        mod_file = OUTPUT_FOLDER + instance_cl.section_name + ".bin"
-                        dst = dir_in_build / filename
-                        shutil.copyfile(mod_file, dst)
-                        contents = {
-                            "name": filename,
-                            "source": modified_rom_name + "/" + filename,
-                            "type": "data"
-                        }
-                        element = et.Element("file", contents)
-                        dir_tree.insert(-1, element)
+                    # checking whether the original file exists and retrieving its size
+                    game_file = dir_in_build / df.physical_file
+                    if not _files.check_file(game_file):
+                        if self.abort_build_request():
+                            return False
+                        continue
+                    game_file_size = os.path.getsize(game_file)
+
+                    # checking whether the modded file exists and retrieving its size
+                    mod_file = instance_cl.get_output_name()
+                    if not _files.check_file(mod_file):
+                        if self.abort_build_request():
+                            return False
+                        continue
+                    mod_size = os.path.getsize(mod_file)
+
+                    # Checking potential file size overflows and warning the user about them
+                    offset = instance_cl.address - df.address + df.offset
+                    if (mod_size + offset) > game_file_size:
+                        logger.warning(f"{mod_file} will increase total file size of {game_file}\n")
+
+                    mod_data = bytearray()
+                    with open(mod_file, "rb") as mod:
+                        mod_data = bytearray(mod.read())
+                    if game_file not in modded_files:
+                        modified_game_file = dir_in_build / df.physical_file
+                        modded_stream = open(modified_game_file, "r+b") # BUG: Should this be closed?
+                        modded_files[game_file] = [modded_stream, bytearray(modded_stream.read())]
                         iso_changed = True
 
-                # writing changes to files we overwrote
-                for game_file in modded_files:
                     modded_stream = modded_files[game_file][0]
                     modded_buffer = modded_files[game_file][1]
-                    modded_stream.seek(0)
-                    modded_stream.write(modded_buffer)
-                    modded_stream.close()
-                if iso_changed:
-                    xml_tree.write(fname_xml)
+                    # Add zeroes if the new total file size is more than the original file size
+                    for i in range(len(modded_buffer), offset + mod_size):
+                        modded_buffer.append(0)
+                    for i in range(mod_size):
+                        modded_buffer[i + offset] = mod_data[i]
+
+                # if it's not a file to be overwritten in the game
+                # assume it's a new file to be inserted in the disc
+                else:
+                    filename = (instance_cl.section_name + ".bin").upper()
+                    filename_len = len(filename)
+                    if filename_len > 12:
+                        filename = filename[(filename_len - 12):] # truncate
+                    mod_file = OUTPUT_FOLDER + instance_cl.section_name + ".bin"
+                    dst = dir_in_build / filename
+                    shutil.copyfile(mod_file, dst)
+                    contents = {
+                        "name": filename,
+                        "source": modified_rom_name + "/" + filename,
+                        "type": "data"
+                    }
+                    element = et.Element("file", contents)
+                    dir_tree.insert(-1, element)
+                    iso_changed = True
+
+            # writing changes to files we overwrote
+            for game_file in modded_files:
+                modded_stream = modded_files[game_file][0]
+                modded_buffer = modded_files[game_file][1]
+                modded_stream.seek(0)
+                modded_stream.write(modded_buffer)
+                modded_stream.close()
+            if iso_changed:
+                xml_tree.write(fname_xml)
 
         return iso_changed
 
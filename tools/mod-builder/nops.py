@@ -1,6 +1,6 @@
 import _files # check_file
 from syms import Syms
-from compile_list import CompileList, free_sections
+from compile_list import get_compile_plan
 from common import COMPILE_LIST, SETTINGS_PATH, BACKUP_FOLDER, get_build_id, request_user_input
 
 import os
@@ -34,25 +34,21 @@ class Nops:
         build_lists = ["./"]
         while build_lists:
             prefix = build_lists.pop(0)
-            bl = prefix + COMPILE_LIST
-            free_sections()
-            with open(bl, "r") as file:
-                for line in file:
-                    cl = CompileList(line, sym, prefix)
-                    if not cl.should_build():
-                        continue
-                    bin = cl.get_output_name()
-                    backup_bin = pathlib.Path(prefix) / BACKUP_FOLDER / ("nops_" + cl.section_name + ".bin")
-                    if backup:
-                        if not _files.check_file(bin):
-                            continue
-                        size = os.path.getsize(bin)
-                        self.fire_command(["/dump", hex(cl.address), hex(size),backup_bin])
-                    if restore:
-                        bin = backup_bin
+            for cl in get_compile_plan(sym, prefix):
+                if not cl.should_build():
+                    continue
+                bin = cl.get_output_name()
+                backup_bin = pathlib.Path(prefix) / BACKUP_FOLDER / ("nops_" + cl.section_name + ".bin")
+                if backup:
                     if not _files.check_file(bin):
                         continue
-                    self.fire_command(["/bin", hex(cl.address), bin])
+                    size = os.path.getsize(bin)
+                    self.fire_command(["/dump", hex(cl.address), hex(size),backup_bin])
+                if restore:
+                    bin = backup_bin
+                if not _files.check_file(bin):
+                    continue
+                self.fire_command(["/bin", hex(cl.address), bin])
 
     def hot_reload(self) -> None:
         if not _files.check_file(COMPILE_LIST):
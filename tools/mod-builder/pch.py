@@ -0,0 +1,128 @@
+"""
+Precompiled header cache
+gcc accepts a directory named after the header with a .gch suffix in place of
+a single precompiled header, and uses the first file in it that is valid for
+the flags of the current compilation. Each configuration (compiler, flags and
+build id) gets its own file in there, so all the mods of a game share the
+precompiled headers without overwriting each other's.
+
+gcc tries to load every file in that directory, so the dependency files and
+the temporary files written while a header is precompiled are kept in a
+separate .pch directory next to it.
+"""
+from __future__ import annotations # to use type in python 3.7
+
+import functools
+import hashlib
+import os
+import pathlib
+import shutil
+import subprocess
+import time
+
+COMPILER = "mipsel-none-elf-gcc"
+FLAGS_GOAL = "pch-flags" # see nugget/common.mk
+FLAGS_PREFIX = "PCH_FLAGS = "
+BUILD_DIR = ".pch"
+MAX_AGE = 30 * 24 * 60 * 60 # seconds since a configuration was last used
+TEMP_MAX_AGE = 60 * 60 # older temporary files are left by interrupted builds
+TEMP_SUFFIX = ".tmp"
+
+@functools.lru_cache(maxsize=None)
+def get_compiler_version(compiler: str = COMPILER) -> str:
+    """ Path and version of the compiler, as a precompiled header is only valid for the gcc that wrote it. """
+    path = shutil.which(compiler)
+    if path is None:
+        return compiler
+    try:
+        result = subprocess.run([path, "--version"], stdout=subprocess.PIPE, stderr=subprocess.DEVNULL, text=True)
+    except OSError:
+        return path
+    lines = result.stdout.splitlines()
+    return path + " " + (lines[0] if lines else "")
+
+def get_build_flags(directory: str | None = None, make: str = "make") -> list[str] | None:
+    """
+    Compiler and flags the precompiled header is built with, as printed by make
+    once it has read every makefile of the mod, define.mk included. The
+    compiler comes first. None if make couldn't tell.
+    """
+    try:
+        result = subprocess.run([make, "--silent", "--no-print-directory", FLAGS_GOAL], cwd=directory, stdout=subprocess.PIPE, stderr=subprocess.DEVNULL, text=True)
+    except OSError:
+        return None
+    if result.returncode != 0:
+        return None
+    for line in result.stdout.splitlines():
+        if line.startswith(FLAGS_PREFIX):
+            return line[len(FLAGS_PREFIX):].split() or None
+    return None
+
+def get_cache_key(compiler: str, flags: list[str], build_id: int) -> str:
+    text = "\n".join([compiler, *flags, str(build_id)])
+    return hashlib.sha1(text.encode()).hexdigest()[:16]
+
+def get_cache_dir(header: pathlib.Path) -> pathlib.Path:
+    return header.with_name(header.name + ".gch")
+
+def get_cache_path(header: pathlib.Path, key: str) -> pathlib.Path:
+    return get_cache_dir(header) / (key + ".gch")
+
+def get_dep_path(header: pathlib.Path, key: str) -> pathlib.Path:
+    """ Headers included by the precompiled header, so that it's rebuilt when any of them changes. """
+    return header.parent / BUILD_DIR / (key + ".dep")
+
+def get_last_use(path: pathlib.Path) -> float:
+    stat = path.stat()
+    return max(stat.st_atime, stat.st_mtime)
+
+def prepare_cache(path: pathlib.Path, dep_path: pathlib.Path) -> None:
+    """
+    Removes the single precompiled header written before the cache existed,
+    which has the name of the cache directory, and any precompiled header
+    without dependencies, which make couldn't tell is out of date. Then marks
+    the configuration as used so that it isn't pruned. Only the access time
+    is updated, as make compares the modification time with the headers'.
+    """
+    if path.parent.is_file():
+        path.parent.unlink()
+    if path.is_file() and not dep_path.is_file():
+        path.unlink()
+    if path.is_file():
+        os.utime(path, (time.time(), path.stat().st_mtime))
+
+def prune_cache(header: pathlib.Path, max_age: float = MAX_AGE, now: float | None = None) -> list[pathlib.Path]:
+    """
+    Deletes the precompiled headers of the configurations that weren't used
+    for max_age seconds with their dependency files, and the temporary files
+    of interrupted builds. Returns the deleted files.
+    """
+    directory = get_cache_dir(header)
+    if directory.is_file():
+        directory.unlink()
+        return [directory]
+    now = time.time() if now is None else now
+    deleted = []
+    if directory.is_dir():
+        for path in directory.iterdir():
+            try:
+                is_stale = now - get_last_use(path) > max_age
+            except OSError:
+                continue
+            if is_stale and path.is_file():
+                path.unlink()
+                deleted.append(path)
+    build_dir = header.parent / BUILD_DIR
+    if build_dir.is_dir():
+        for path in build_dir.iterdir():
+            try:
+                if path.suffix == TEMP_SUFFIX:
+                    is_stale = now - path.stat().st_mtime > TEMP_MAX_AGE
+                else:
+                    is_stale = not get_cache_path(header, path.stem).exists()
+            except OSError:
+                continue
+            if is_stale and path.is_file():
+                path.unlink()
+                deleted.append(path)
+    return deleted
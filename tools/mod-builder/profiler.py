@@ -0,0 +1,230 @@
+"""
+Function call profiler
+
+Reads the call trace logged by minin00b's psxprof library (see ProfTraceInit()
+in psxprof.h) for mods compiled with the "profile" option, symbolizes it with
+the map produced by the last compilation and turns it into a flame graph.
+
+The trace is a ring buffer of (function address | exit flag, timestamp) pairs,
+located through the _prof_trace header. Since the buffer only holds the most
+recent calls, exits whose matching entry was overwritten are skipped and
+functions that are still running when the trace is dumped are not counted.
+"""
+from __future__ import annotations # to use type in python 3.7
+
+import bisect
+import html
+import logging
+import pathlib
+import struct
+import zlib
+from collections import defaultdict
+
+logger = logging.getLogger(__name__)
+
+TRACE_SYMBOL = "_prof_trace"
+TRACE_MAGIC = 0x43525450 # "PTRC"
+# magic, entries, mask, count, enabled (see PROF_TraceHeader)
+TRACE_HEADER = struct.Struct("<5I")
+TRACE_ENTRY = struct.Struct("<2I")
+
+# Timestamps are taken from root counter 2, running at 1/8 of the system clock
+TICKS_PER_US = 33.8688 / 8
+
+SVG_WIDTH = 1200
+SVG_FRAME_HEIGHT = 16
+SVG_MIN_TEXT_WIDTH = 24
+SVG_CHAR_WIDTH = 7
+
+class Symbolizer:
+    def __init__(self, symbols: list[tuple[int, str]]) -> None:
+        self.symbols = sorted(symbols)
+        self.addresses = [addr for addr, _ in self.symbols]
+        self.names = {name: addr for addr, name in self.symbols}
+
+    @staticmethod
+    def from_map(path: pathlib.Path) -> Symbolizer:
+        """
+        Loads a map in the format written for redux ("address name" per line,
+        address in hex without prefix).
+        """
+        symbols = []
+        with open(path, "r") as file:
+            for line in file:
+                line = line.split()
+                if len(line) != 2:
+                    continue
+                try:
+                    symbols.append((int(line[0], 16), line[1]))
+                except ValueError:
+                    continue
+        return Symbolizer(symbols)
+
+    def address_of(self, name: str) -> int | None:
+        return self.names.get(name)
+
+    def name_of(self, addr: int) -> str:
+        """ Returns the symbol at or right before addr. """
+        i = bisect.bisect_right(self.addresses, addr) - 1
+        if i < 0:
+            return f"0x{addr:08x}"
+        base, name = self.symbols[i]
+        if base == addr:
+            return name
+        return f"{name}+0x{addr - base:x}"
+
+def ram_offset(addr: int) -> int:
+    """ Converts a KUSEG/KSEG0/KSEG1 address into an offset in main RAM. """
+    return addr & 0x1FFFFFFF
+
+def read_trace(ram: bytes, header_addr: int) -> list[tuple[int, bool, int]]:
+    """
+    Returns the events in the trace buffer, oldest first, as
+    (function address, is exit, timestamp) tuples.
+    """
+    offset = ram_offset(header_addr)
+    if offset + TRACE_HEADER.size > len(ram):
+        raise ValueError(f"trace header at 0x{header_addr:08x} is outside of RAM")
+    magic, entries, mask, count, _ = TRACE_HEADER.unpack_from(ram, offset)
+    if magic != TRACE_MAGIC:
+        raise ValueError(f"invalid trace header at 0x{header_addr:08x} (magic 0x{magic:08x})")
+    if not entries:
+        return []
+    length = mask + 1
+    entries = ram_offset(entries)
+    if entries + length * TRACE_ENTRY.size > len(ram):
+        raise ValueError("trace buffer is outside of RAM")
+    events = []
+    for i in range(max(count - length, 0), count):
+        value, time = TRACE_ENTRY.unpack_from(ram, entries + (i & mask) * TRACE_ENTRY.size)
+        events.append((value & ~1, bool(value & 1), time))
+    return events
+
+def fold_stacks(events: list[tuple[int, bool, int]], symbolize) -> dict[str, int]:
+    """
+    Reconstructs the call stacks from a list of events and returns the time (in
+    ticks) spent in each unique stack, excluding time spent in callees. Stacks are
+    keyed by semicolon-separated function names, root first.
+    """
+    folded = defaultdict(int)
+    stack = [] # [address, name, start time, time spent in callees]
+    for func, is_exit, time in events:
+        if not is_exit:
+            stack.append([func, symbolize(func), time, 0])
+            continue
+        # Skip exits whose entry was overwritten in the ring buffer
+        if not any(frame[0] == func for frame in stack):
+            continue
+        # Frames above the matching one never returned normally (e.g. due to
+        # longjmp()), so they are considered to have ended here as well.
+        while True:
+            path = ";".join(frame[1] for frame in stack)
+            addr, _, start, callees = stack.pop()
+            total = (time - start) & 0xFFFFFFFF
+            folded[path] += max(total - callees, 0)
+            if stack:
+                stack[-1][3] += total
+            if addr == func:
+                break
+    return dict(folded)
+
+def ticks_to_us(ticks: int) -> int:
+    return round(ticks / TICKS_PER_US)
+
+def write_folded(folded: dict[str, int], path: pathlib.Path) -> None:
+    """ Writes the stacks in the collapsed format used by flamegraph.pl and speedscope. """
+    with open(path, "w") as file:
+        for stack, ticks in sorted(folded.items()):
+            us = ticks_to_us(ticks)
+            if us:
+                file.write(f"{stack} {us}\n")
+
+def _build_tree(folded: dict[str, int]) -> dict:
+    root = {"name": "all", "value": 0, "children": {}}
+    for stack, ticks in folded.items():
+        root["value"] += ticks
+        node = root
+        for name in stack.split(";"):
+            node = node["children"].setdefault(name, {"name": name, "value": 0, "children": {}})
+            node["value"] += ticks
+    return root
+
+def _color(name: str) -> str:
+    # Warm colors as in the original flame graphs, stable for a given name
+    h = zlib.crc32(name.encode())
+    return f"rgb({205 + (h & 0x1F)},{(h >> 5) % 160 + 60},{(h >> 13) % 50})"
+
+def render_svg(folded: dict[str, int], title: str = "Flame Graph") -> str:
+    """ Renders a static flame graph, with the root at the bottom. """
+    root = _build_tree(folded)
+    total = root["value"] or 1
+    depth = 0
+    frames = []
+
+    def layout(node, x, level):
+        nonlocal depth
+        depth = max(depth, level)
+        frames.append((node, x, level))
+        for child in sorted(node["children"].values(), key=lambda n: n["name"]):
+            layout(child, x, level + 1)
+            x += child["value"] / total * SVG_WIDTH
+
+    layout(root, 0.0, 0)
+    height = (depth + 1) * SVG_FRAME_HEIGHT + 40
+    out = [
+        f'<svg xmlns="http://www.w3.org/2000/svg" width="{SVG_WIDTH}" height="{height}" font-family="monospace" font-size="11">',
+        f'<rect width="100%" height="100%" fill="#f8f8f8"/>',
+        f'<text x="{SVG_WIDTH // 2}" y="20" text-anchor="middle" font-size="15">{html.escape(title)}</text>',
+    ]
+    for node, x, level in frames:
+        width = node["value"] / total * SVG_WIDTH
+        if width < 0.1:
+            continue
+        y = height - (level + 1) * SVG_FRAME_HEIGHT
+        us = ticks_to_us(node["value"])
+        label = f'{node["name"]} ({us} us, {node["value"] * 100 / total:.2f}%)'
+        out.append(f'<g><title>{html.escape(label)}</title>')
+        out.append(f'<rect x="{x:.2f}" y="{y}" width="{width:.2f}" height="{SVG_FRAME_HEIGHT - 1}" fill="{_color(node["name"])}"/>')
+        if width >= SVG_MIN_TEXT_WIDTH:
+            text = node["name"][:int(width // SVG_CHAR_WIDTH) - 1]
+            out.append(f'<text x="{x + 3:.2f}" y="{y + SVG_FRAME_HEIGHT - 4}">{html.escape(text)}</text>')
+        out.append('</g>')
+    out.append('</svg>')
+    return "\n".join(out) + "\n"
+
+def self_times(folded: dict[str, int]) -> list[tuple[str, int]]:
+    """ Returns the total self time of each function, highest first. """
+    totals = defaultdict(int)
+    for stack, ticks in folded.items():
+        totals[stack.rsplit(";", 1)[-1]] += ticks
+    return sorted(totals.items(), key=lambda item: item[1], reverse=True)
+
+def create_profile(ram: bytes, map_path: pathlib.Path, output_folder: pathlib.Path) -> bool:
+    """
+    Extracts the trace from a RAM dump and writes profile.folded and
+    profile.svg to output_folder.
+    """
+    symbolizer = Symbolizer.from_map(map_path)
+    header_addr = symbolizer.address_of(TRACE_SYMBOL)
+    if header_addr is None:
+        logger.error(f"{TRACE_SYMBOL} not found in {map_path}. Make sure the mod was compiled with the profile option enabled.")
+        return False
+    try:
+        events = read_trace(ram, header_addr)
+    except ValueError as error:
+        logger.error(f"Unable to read the trace: {error}")
+        return False
+    if not events:
+        logger.warning("The trace is empty. Make sure the mod calls ProfTraceInit().")
+        return False
+    folded = fold_stacks(events, symbolizer.name_of)
+    folded_path = output_folder / "profile.folded"
+    svg_path = output_folder / "profile.svg"
+    write_folded(folded, folded_path)
+    with open(svg_path, "w") as file:
+        file.write(render_svg(folded, f"{len(events)} events"))
+    print(f"\n[Profiler-py] {len(events)} events, top functions by self time:")
+    for name, ticks in self_times(folded)[:10]:
+        print(f"{ticks_to_us(ticks):>10} us  {name}")
+    logger.info(f"Flame graph written to {svg_path} ({folded_path})")
+    return True
@@ -1,12 +1,13 @@
 import _files # check_file
 from syms import Syms
-from compile_list import CompileList, free_sections
-from common import COMPILE_LIST, ISO_PATH, REDUX_MAP_FILE, SETTINGS_PATH, BACKUP_FOLDER, TEXTURES_OUTPUT_FOLDER, MOD_NAME, request_user_input, get_build_id, cli_pause
+from compile_list import get_compile_plan
+from common import COMPILE_LIST, ISO_PATH, REDUX_MAP_FILE, DEBUG_FOLDER, SETTINGS_PATH, BACKUP_FOLDER, TEXTURES_OUTPUT_FOLDER, MOD_NAME, request_user_input, get_build_id, cli_pause
 from image import get_image_list
 from clut import get_clut_list
 from game_options import game_options
 from mkpsxiso import Mkpsxiso
 from disc import Disc, DiscFile
+from profiler import create_profile
 
 import logging
 import json
@@ -176,6 +177,12 @@ class Redux:
         else:
             logger.error(f"Web Server: error loading {REDUX_MAP_FILE}")
 
+    def upload_ram(self, bin: pathlib.Path, offset: int, size: int) -> bool:
+        with open(bin, "rb") as file:
+            files = {"file": file}
+            response = requests.post(self.url + "/api/v1/cpu/ram/raw?offset=" + str(offset) + "&size=" + str(size), files=files)
+        return response.ok and response.status_code == 200
+
     def inject(self, backup: bool, restore: bool) -> None:
         build_id = get_build_id()
         if build_id is None:
@@ -195,40 +202,31 @@ class Redux:
         build_lists = ["./"]
         while build_lists:
             prefix = build_lists.pop(0)
-            build_list = prefix + COMPILE_LIST
-            free_sections()
-            with open(build_list, "r") as file:
-                for line in file:
-                    cl = CompileList(line, sym, prefix)
-                    if not cl.should_build():
-                        continue
-                    bin = cl.get_output_name() # pathlib object
-                    backup_bin = pathlib.Path(prefix) / BACKUP_FOLDER / ("redux_" + cl.section_name + ".bin")
-                    offset = cl.address & 0xFFFFFFF
+            for cl in get_compile_plan(sym, prefix):
+                if not cl.should_build():
+                    continue
+                bin = cl.get_output_name() # pathlib object
+                backup_bin = pathlib.Path(prefix) / BACKUP_FOLDER / ("redux_" + cl.section_name + ".bin")
+                offset = cl.address & 0xFFFFFFF
+                if not _files.check_file(bin):
+                    continue
+                size = os.path.getsize(bin)
+                if backup:
+                    section = psx_ram[offset : (offset + size)]
+                    with open(backup_bin, "wb") as file:
+                        file.write(section)
+                if restore:
+                    bin = backup_bin
                     if not _files.check_file(bin):
                         continue
                     size = os.path.getsize(bin)
-                    if backup:
-                        section = psx_ram[offset : (offset + size)]
-                        with open(backup_bin, "wb") as file:
-                            file.write(section)
+                if self.upload_ram(bin, offset, size):
                     if restore:
-                        bin = backup_bin
-                        if not _files.check_file(bin):
-                            continue
-                        size = os.path.getsize(bin)
-                    file = open(bin, "rb")
-                    files = {"file": file}
-                    response = requests.post(url + "?offset=" + str(offset) + "&size=" + str(size), files=files)
-                    if response.ok:
-                        if response.status_code == 200:
-                            if restore:
-                                logger.info(f"{bin} successfully restored.")
-                            else:
-                                logger.info(f"{bin} successfully injected.")
+                        logger.info(f"{bin} successfully restored.")
                     else:
-                        logger.error(f"Web Server: error injecting {bin}")
-                    file.close()
+                        logger.info(f"{bin} successfully injected.")
+                else:
+                    logger.error(f"Web Server: error injecting {bin}")
 
     def inject_textures(self, backup: bool, restore: bool) -> None:
         url = self.url + "/api/v1/gpu/vram/raw"
@@ -302,6 +300,43 @@ class Redux:
         if is_running:
             self.resume_emulation()
 
+    def push_code(self, bins: list[tuple[pathlib.Path, int]]) -> bool:
+        """
+        Injects the given (binary, address) pairs and the symbols without asking
+        anything, for the watch mode. The backup is taken by the first hot reload.
+        """
+        try:
+            is_running = self.get_emulation_running_state()
+        except Exception:
+            print("\n[Redux - Web Server] ERROR: Couldn't start a connection with redux.\n")
+            return False
+        self.pause_emulation()
+        is_valid = True
+        for bin, address in bins:
+            if self.upload_ram(bin, address & 0xFFFFFFF, os.path.getsize(bin)):
+                logger.info(f"{bin} successfully injected.")
+            else:
+                logger.error(f"Web Server: error injecting {bin}")
+                is_valid = False
+        self.load_map()
+        self.flush_cache()
+        if is_running:
+            self.resume_emulation()
+        return is_valid
+
+    def push_textures(self) -> bool:
+        """ Injects the converted textures without asking for a backup, for the watch mode. """
+        try:
+            is_running = self.get_emulation_running_state()
+        except Exception:
+            print("\n[Redux - Web Server] ERROR: Couldn't start a connection with redux.\n")
+            return False
+        self.pause_emulation()
+        self.inject_textures(False, False)
+        if is_running:
+            self.resume_emulation()
+        return True
+
     def restore(self) -> None:
         if not _files.check_file(COMPILE_LIST):
             return
@@ -360,6 +395,28 @@ class Redux:
         if is_running:
             self.resume_emulation()
 
+    def dump_profile(self) -> None:
+        if not _files.check_file(REDUX_MAP_FILE):
+            print("\n[Redux-py] ERROR: No map file found. Make sure you have compiled your mod with the profile option enabled.\n")
+            return
+        is_running = bool()
+        try:
+            is_running = self.get_emulation_running_state()
+        except Exception:
+            print("\n[Redux - Web Server] ERROR: Couldn't start a connection with redux.")
+            print("Make sure that redux is running, its web server is active, and")
+            print("the port configuration saved in settings.json is correct.\n")
+            return
+        # Pause so that the trace doesn't change while it is being read
+        self.pause_emulation()
+        response = requests.get(self.url + "/api/v1/cpu/ram/raw")
+        if is_running:
+            self.resume_emulation()
+        if not response.ok:
+            logger.error("Web Server: error retrieving the RAM.")
+            return
+        create_profile(response.content, REDUX_MAP_FILE, DEBUG_FOLDER)
+
     def compare_asset_sizes(self, og_file_df: DiscFile, og_file_path: str, patch_file_path: str) -> bool:
         # this looks kinda ugly. is there a better way of doing this?
         binary = pathlib.Path(patch_file_path)
@@ -424,39 +481,34 @@ class Redux:
         # read buildList contents
         while build_lists:
             prefix = build_lists.pop(0)
-            bl = (pathlib.Path(prefix) / COMPILE_LIST).resolve() # TODO: Double check
-            free_sections()
-            with open(bl, "r") as bl_file:
-                for line in bl_file:
-                    instance_cl = CompileList(line, sym, prefix)
-
-                    # check if buildList line is for a valid patch file
-                    # in this context, a valid patch file is any binary (ergo, non-code (i.e. .c, .s, .cpp)) file which
-                    # disc location, referred to as section in terms of the toolchain, is set to that of an existing
-                    # disc file. note that the section must have its address set to 0x0 in disc.json in order to count as valid
-                    if (instance_cl.is_bin):
-                        df = disc.get_df(instance_cl.game_file)
-                        if (not df):
+            for instance_cl in get_compile_plan(sym, prefix):
+                # check if buildList line is for a valid patch file
+                # in this context, a valid patch file is any binary (ergo, non-code (i.e. .c, .s, .cpp)) file which
+                # disc location, referred to as section in terms of the toolchain, is set to that of an existing
+                # disc file. note that the section must have its address set to 0x0 in disc.json in order to count as valid
+                if (instance_cl.is_bin):
+                    df = disc.get_df(instance_cl.game_file)
+                    if (not df):
+                        print(f"Ignoring {instance_cl.source[0]}:")
+                        print(f"section aliased \"{instance_cl.game_file}\" doesn't correspond to a disc file.\n")
+                    else:
+                        if (df.address != 0):
                             print(f"Ignoring {instance_cl.source[0]}:")
-                            print(f"section aliased \"{instance_cl.game_file}\" doesn't correspond to a disc file.\n")
+                            print(f"section aliased \"{instance_cl.game_file}\" has an address.\n")
                         else:
-                            if (df.address != 0):
-                                print(f"Ignoring {instance_cl.source[0]}:")
-                                print(f"section aliased \"{instance_cl.game_file}\" has an address.\n")
-                            else:
-                                # if line is valid, check if patch file is larger than the disc file
-                                # if yes, return
-                                # if not, add relevant information to arrays for actual patching
-
-                                # by the way this code sucks please forgive me
-                                willCancel = False;
-                                isLarger = self.compare_asset_sizes(df, f"{extract_folder}/{df.physical_file}".replace("\\", "/"), instance_cl.source[0])
-                                if (isLarger):
-                                    willCancel = True;
-                                if (willCancel):
-                                    return
-                                bl_line_array.append(instance_cl)
-                                df_array.append(df)
+                            # if line is valid, check if patch file is larger than the disc file
+                            # if yes, return
+                            # if not, add relevant information to arrays for actual patching
+
+                            # by the way this code sucks please forgive me
+                            willCancel = False;
+                            isLarger = self.compare_asset_sizes(df, f"{extract_folder}/{df.physical_file}".replace("\\", "/"), instance_cl.source[0])
+                            if (isLarger):
+                                willCancel = True;
+                            if (willCancel):
+                                return
+                            bl_line_array.append(instance_cl)
+                            df_array.append(df)
 
         if (not bl_line_array):
             print("ERROR: There are no valid patch files in the buildList.")
@@ -0,0 +1,144 @@
+"""
+Symbol index of the linked mod
+Built from the .symtab of mod.elf, with the source file of each symbol taken
+from the map written by the linker. Saved in debug/symbols.json after each
+compilation, and used to write the map uploaded to redux and to annotate the
+disassembly.
+"""
+from __future__ import annotations # to use type in python 3.7
+
+import bisect
+import json
+import re
+from dataclasses import asdict, dataclass
+
+from elf import Elf, ABS_SECTION, STB_LOCAL, STT_FILE, STT_FUNC, STT_OBJECT, STT_SECTION
+from mapfile import MapFile
+
+# Symbols defined by the linker scripts to lay out the mod, which don't name
+# any code or data
+SPECIAL_SYMBOLS = ["__heap_base", "__ovr_start", "__ovr_end", "OVR_START_ADDR", "__mod_end"]
+
+KIND_NAMES = {STT_FUNC: "func", STT_OBJECT: "object"}
+
+SECTION_LINE_RE = re.compile(r"^Disassembly of section (\S+):$")
+FUNCTION_LINE_RE = re.compile(r"^([0-9a-fA-F]+) <(.+)>:$")
+
+@dataclass
+class IndexedSymbol:
+    name: str
+    address: int
+    size: int
+    kind: str # func, object, label or abs (symbols assigned in the linker scripts, e.g. game symbols)
+    section: str
+    file: str
+    local: bool = False
+
+    def end(self) -> int:
+        return self.address + self.size
+
+class SymbolIndex:
+    def __init__(self, symbols: list[IndexedSymbol]) -> None:
+        self.symbols = sorted(symbols, key=lambda sym: (sym.address, sym.name))
+        self.addresses = [sym.address for sym in self.symbols]
+        self.names = dict()
+        self.sections = dict()
+        for sym in self.symbols:
+            self.sections.setdefault(sym.section, []).append(sym)
+            # Static symbols can share the name of a global one
+            if sym.name not in self.names or self.names[sym.name].local:
+                self.names[sym.name] = sym
+        self.section_addresses = {section: [sym.address for sym in symbols] for section, symbols in self.sections.items()}
+
+    @staticmethod
+    def from_elf(elf: Elf, map_file: MapFile | None = None) -> SymbolIndex:
+        # Overlays share addresses, so the input sections are looked up within
+        # the output section of the symbol
+        inputs = dict()
+        if map_file is not None:
+            for output in map_file.sections.values():
+                ranges = sorted((section.address, section.end(), section.file) for section in output.inputs if section.size)
+                inputs[output.name] = ([start for start, _, _ in ranges], ranges)
+
+        def file_of(section: str, address: int) -> str:
+            starts, ranges = inputs.get(section, ([], []))
+            i = bisect.bisect_right(starts, address) - 1
+            if i >= 0 and address < ranges[i][1]:
+                return ranges[i][2]
+            return ""
+
+        symbols = []
+        for sym in elf.symbols():
+            if sym.section is None or not sym.name or sym.type in (STT_SECTION, STT_FILE):
+                continue
+            if sym.name in SPECIAL_SYMBOLS or sym.name.startswith("$"): # mapping symbols
+                continue
+            if sym.section == ABS_SECTION:
+                kind, file = "abs", ""
+            else:
+                kind, file = KIND_NAMES.get(sym.type, "label"), file_of(sym.section, sym.value)
+            symbols.append(IndexedSymbol(sym.name, sym.value, sym.size, kind, sym.section, file, sym.bind == STB_LOCAL))
+        return SymbolIndex(symbols)
+
+    @staticmethod
+    def load(path) -> SymbolIndex:
+        with open(path, "r") as file:
+            data = json.load(file)
+        return SymbolIndex([IndexedSymbol(**sym) for sym in data["symbols"]])
+
+    def save(self, path) -> None:
+        with open(path, "w") as file:
+            json.dump({"symbols": [asdict(sym) for sym in self.symbols]}, file)
+
+    def get(self, name: str) -> IndexedSymbol | None:
+        return self.names.get(name)
+
+    def at(self, address: int, section: str | None = None) -> IndexedSymbol | None:
+        """
+        Returns the symbol containing the address, or the closest one before it
+        if it has no size (e.g. assembly labels). Overlays share addresses, so
+        the search can be restricted to one section.
+        """
+        symbols, addresses = self.symbols, self.addresses
+        if section is not None:
+            symbols = self.sections.get(section, [])
+            addresses = self.section_addresses.get(section, [])
+        i = bisect.bisect_right(addresses, address) - 1
+        if i < 0:
+            return None
+        candidates = symbols[bisect.bisect_left(addresses, addresses[i]) : i + 1]
+        for sym in candidates:
+            if address < sym.end():
+                return sym
+        for sym in candidates:
+            if sym.size == 0:
+                return sym
+        return None
+
+    def in_section(self, section: str) -> list[IndexedSymbol]:
+        return list(self.sections.get(section, []))
+
+    def in_file(self, file: str) -> list[IndexedSymbol]:
+        return [sym for sym in self.symbols if sym.file == file]
+
+    def redux_map(self) -> str:
+        """ Map in the format expected by redux: "address name" per line, address in hex without prefix. """
+        return "".join(f"{sym.address:08x} {sym.name}\n" for sym in self.symbols)
+
+def annotate_disassembly(text: str, index: SymbolIndex) -> str:
+    """ Adds the source file and size of each function to the headers printed by objdump -d. """
+    out = []
+    section = None
+    for line in text.splitlines():
+        match = SECTION_LINE_RE.match(line)
+        if match:
+            section = match.group(1)
+        match = FUNCTION_LINE_RE.match(line)
+        if match:
+            sym = index.at(int(match.group(1), 16), section)
+            if sym is not None and sym.name == match.group(2):
+                details = [detail for detail in [sym.file, f"{sym.size} bytes" if sym.size else ""] if detail]
+                if details:
+                    line += "  [" + ", ".join(details) + "]"
+        out.append(line)
+    return "\n".join(out) + "\n"
@@ -0,0 +1,96 @@
+import math
+import struct
+import wave
+import pytest
+
+import adpcm
+
+def make_tone(length, period = 40.0, amplitude = 12000):
+    return [int(amplitude * math.sin(2 * math.pi * i / period)) for i in range(length)]
+
+def decode(data):
+    hist = (0, 0)
+    samples, flags = [], []
+    for offset in range(0, len(data), adpcm.BLOCK_SIZE):
+        block = data[offset:offset + adpcm.BLOCK_SIZE]
+        decoded, hist = adpcm.decode_block(block, hist)
+        samples += decoded
+        flags.append(block[1])
+    return samples, flags
+
+def exhaustive_error(samples, hist):
+    return min(
+        adpcm.try_block(samples, hist, filt, shift, 1 << 62)[0]
+        for filt in range(len(adpcm.FILTERS)) for shift in range(adpcm.NUM_SHIFTS)
+    )
+
+def test_encode_block_matches_exhaustive_search():
+    tone = make_tone(adpcm.SAMPLES_PER_BLOCK * 8, period = 13.7)
+    hist = (0, 0)
+    for i in range(0, len(tone), adpcm.SAMPLES_PER_BLOCK):
+        samples = tone[i:i + adpcm.SAMPLES_PER_BLOCK]
+        block, new_hist = adpcm.encode_block(samples, hist)
+        decoded, _ = adpcm.decode_block(block, hist)
+        assert sum((a - b) ** 2 for a, b in zip(samples, decoded)) == exhaustive_error(samples, hist)
+        hist = new_hist
+
+def test_encode_one_shot():
+    tone = make_tone(1000)
+    data = adpcm.encode_samples(tone)
+    samples, flags = decode(data)
+    assert len(data) == 36 * adpcm.BLOCK_SIZE
+    assert flags == [0] * 35 + [adpcm.FLAG_LOOP_END]
+    snr = sum(x ** 2 for x in tone) / sum((x - y) ** 2 for x, y in zip(tone, samples))
+    assert 10 * math.log10(snr) > 30
+
+def test_encode_loop():
+    tone = make_tone(1000)
+    data = adpcm.encode_samples(tone, loop_start = 100)
+    samples, flags = decode(data)
+    padding = (-100) % adpcm.SAMPLES_PER_BLOCK
+    loop_block = (100 + padding) // adpcm.SAMPLES_PER_BLOCK
+    assert len(samples) % adpcm.SAMPLES_PER_BLOCK == 0
+    assert flags[loop_block] == adpcm.FLAG_LOOP_START
+    assert flags[-1] == adpcm.FLAG_LOOP_END | adpcm.FLAG_LOOP_REPEAT
+    assert data[loop_block * adpcm.BLOCK_SIZE] >> 4 == 0
+    assert samples[:padding] == [0] * padding
+
+def test_encode_silence():
+    data = adpcm.encode_samples([])
+    assert len(data) == adpcm.BLOCK_SIZE
+    assert data[1] == adpcm.FLAG_LOOP_END
+    assert data[2:] == bytes(14)
+
+def test_build_vag():
+    vag = adpcm.build_vag(bytes(32), 22050, "JUMP")
+    magic, version, _, size, rate = struct.unpack_from(">4sIIII", vag)
+    assert len(vag) == adpcm.VAG_HEADER_SIZE + 32
+    assert (magic, version, size, rate) == (adpcm.VAG_MAGIC, adpcm.VAG_VERSION, 32, 22050)
+    assert vag[32:36] == b"JUMP"
+
+def test_encode_file_smpl_loop(tmp_path):
+    path = tmp_path / "LOOP.wav"
+    tone = make_tone(500)
+    with wave.open(str(path), "wb") as wav:
+        wav.setnchannels(2)
+        wav.setsampwidth(2)
+        wav.setframerate(11025)
+        wav.writeframes(struct.pack(f"<{len(tone) * 2}h", *[x for x in tone for _ in range(2)]))
+    smpl = struct.pack("<9I", 0, 0, 0, 60, 0, 0, 0, 1, 0) + struct.pack("<6I", 0, 0, 56, 447, 0, 0)
+    with open(path, "ab") as file:
+        file.write(b"smpl" + struct.pack("<I", len(smpl)) + smpl)
+
+    assert adpcm.read_loop_start(path) == (56, 447)
+    data, rate, num_samples, loop_start = adpcm.encode_file(path)
+    assert (rate, num_samples, loop_start) == (11025, 448, 56)
+    assert len(data) == 16 * adpcm.BLOCK_SIZE
+
+cases_fnames = (
+    ("JUMP", True),
+    ("MUSIC_1024", True),
+    ("MUSIC_LOOP", False),
+    ("MUSIC_1_2", False),
+)
+@pytest.mark.parametrize("string, expected", cases_fnames)
+def test_check_naming_convention(string, expected):
+    assert adpcm.Sound.check_naming_convention(string) == expected
@@ -0,0 +1,40 @@
+import pytest
+
+import allocator
+
+def test_subtract():
+    regions = [(0x80010000, 0x80011000), (0x80020000, 0x80021000)]
+    used = [(0x80010100, 0x80010200), (0x80020000, 0x80021000), (0x80030000, 0x80030010)]
+    assert allocator.subtract(regions, used) == [(0x80010000, 0x80010100), (0x80010200, 0x80011000)]
+
+def test_best_fit_picks_smallest_hole():
+    holes = {"exe": [(0x80010000, 0x80011000), (0x80020000, 0x80020100)]}
+    placements = allocator.best_fit(holes, [("small", "exe", 0x80), ("big", "exe", 0x400)])
+    assert placements == {"big": 0x80010000, "small": 0x80020000}
+
+def test_best_fit_largest_first_and_alignment():
+    holes = {"exe": [(0x80010004, 0x80010100)]}
+    placements = allocator.best_fit(holes, [("a", "exe", 0x10), ("b", "exe", 0x21)])
+    # b is placed first, aligned, and a goes after it
+    assert placements == {"b": 0x80010008, "a": 0x80010030}
+
+def test_best_fit_respects_groups():
+    holes = {"exe": [(0x80010000, 0x80010100)], "header": [(0x8000B000, 0x8000B100)]}
+    placements = allocator.best_fit(holes, [("hdr", "header", 0x10)])
+    assert placements == {"hdr": 0x8000B000}
+
+def test_best_fit_not_enough_space():
+    holes = {"exe": [(0x80010000, 0x80010100)]}
+    with pytest.raises(allocator.PlacementError, match="too_big"):
+        allocator.best_fit(holes, [("fits", "exe", 0x80), ("too_big", "exe", 0x101)])
+    with pytest.raises(allocator.PlacementError):
+        allocator.best_fit(holes, [("no_region", "other", 0x4)])
+
+def test_find_overlaps():
+    sections = [
+        ("a", "exe", 0x80010000, 0x80010100),
+        ("b", "exe", 0x800100F0, 0x80010200),
+        ("c", "exe", 0x80010200, 0x80010300),
+        ("d", "overlay", 0x80010000, 0x80010100),
+    ]
+    assert allocator.find_overlaps(sections) == [("a", "b")]
@@ -19,4 +19,19 @@ cases_makefiles = (
 )
 @pytest.mark.parametrize("fname, expected", cases_makefiles)
 def test_get_build_id(fname, expected):
-    assert common.get_build_id(fname) == expected
\ No newline at end of file
+    assert common.get_build_id(fname) == expected
+
+cases_arithmetic = (
+    ("0x0", 0),
+    ("0x10 * (2 + 1)", 0x30),
+    ("-0x8 + 1 << 4", -112),
+    ("0x100 / 3", 0x55),
+)
+@pytest.mark.parametrize("expression, expected", cases_arithmetic)
+def test_eval_arithmetic(expression, expected):
+    assert common.eval_arithmetic(expression) == expected
+
+@pytest.mark.parametrize("expression", ["__import__('os')", "1.5", "x + 1", "1 / 0", ""])
+def test_eval_arithmetic_rejects(expression):
+    with pytest.raises(ValueError):
+        common.eval_arithmetic(expression)
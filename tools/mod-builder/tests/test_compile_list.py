@@ -1,3 +1,4 @@
+import os
 import pathlib
 import pytest
 
@@ -43,6 +44,46 @@ cases_commments = (
 def test_skip_comments(list_strings, expected):
     assert compile_list.CompileList.skip_comments(list_strings) == expected
 
+
+def test_get_placement(tmp_path):
+    manifest = tmp_path / compile_list.OVERLAY_MANIFEST
+    manifest.parent.mkdir(parents=True)
+    manifest.write_text('{"overlays": [{"section": "main", "address": "0x80012000"}]}')
+    prefix = str(tmp_path) + "/"
+    compile_list.free_sections()
+    assert compile_list.get_placement(prefix, "main") == 0x80012000
+    assert compile_list.get_placement(prefix, "hook") is None
+    compile_list.free_sections()
+    assert compile_list.get_placement("./does_not_exist/", "main") is None
+
+class FakeSyms:
+    def get_build_id(self):
+        return 926
+    def get_version(self):
+        return "NTSC-U"
+    def get_files(self):
+        return []
+    def get_address(self, symbol):
+        return None
+
+def test_compile_plan(tmp_path, monkeypatch):
+    config = tmp_path / "config.json"
+    config.write_text('{"compiler": {"8mb": 0}}')
+    monkeypatch.setattr(compile_list, "CONFIG_PATH", config)
+    (tmp_path / "src").mkdir()
+    (tmp_path / "src" / "main.c").write_text("")
+    (tmp_path / "buildList.txt").write_text("common, exe, 0x80010000, 0x10 * 2, src/*.c, main\n")
+    prefix = str(tmp_path) + "/"
+    lines = compile_list.get_compile_plan(FakeSyms(), prefix)
+    assert [(cl.section_name, cl.address, len(cl.source)) for cl in lines] == [("main", 0x80010020, 1)]
+    assert compile_list.get_compile_plan(FakeSyms(), prefix) is lines
+
+    # A new file in a source directory invalidates the plan
+    (tmp_path / "src" / "other.c").write_text("")
+    os.utime(tmp_path / "src", ns=(0, 0))
+    lines = compile_list.get_compile_plan(FakeSyms(), prefix)
+    assert len(lines[0].source) == 2
+
 # "// Include anti-anti-piracy patches for PAL and NTSC-J"
 # "1006, exe, 0x80012534, 0x0, ../../Patches/JpnModchips/src/jpnModchips.s"
 # "1111, exe, 0x80012570, 0x0, ../../Patches/JpnModchips/src/jpnModchips.s"
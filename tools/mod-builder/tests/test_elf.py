@@ -0,0 +1,77 @@
+import struct
+import pytest
+
+import elf
+
+def make_elf(sections, segments = ()):
+    """
+    Builds a little endian 32-bit elf with the given (name, type, addr, data)
+    sections and (vaddr, filesz, memsz) loadable segments.
+    """
+    names = b"\0" + b"".join(name.encode() + b"\0" for name, _, _, _ in sections) + b".shstrtab\0"
+    body = bytearray()
+    offsets = []
+    for _, _, _, data in sections:
+        offsets.append(elf.ELF_HEADER.size + len(body))
+        body += data
+    strtab_offset = elf.ELF_HEADER.size + len(body)
+    body += names
+    phoff = elf.ELF_HEADER.size + len(body)
+    for vaddr, filesz, memsz in segments:
+        body += elf.PROGRAM_HEADER.pack(elf.PT_LOAD, 0, vaddr, vaddr, filesz, memsz, 5, 4)
+    shoff = elf.ELF_HEADER.size + len(body)
+    body += bytes(elf.SECTION_HEADER.size)
+    name_offset = 1
+    for (name, sh_type, addr, data), offset in zip(sections, offsets):
+        body += elf.SECTION_HEADER.pack(name_offset, sh_type, 7, addr, offset, len(data), 0, 0, 4, 0)
+        name_offset += len(name) + 1
+    body += elf.SECTION_HEADER.pack(name_offset, 3, 0, 0, strtab_offset, len(names), 0, 0, 1, 0)
+    ident = elf.ELF_MAGIC + bytes([1, 1, 1]) + bytes(9)
+    header = elf.ELF_HEADER.pack(
+        ident, 2, 8, 1, 0x80010000, phoff, shoff, 0, elf.ELF_HEADER.size,
+        elf.PROGRAM_HEADER.size, len(segments), elf.SECTION_HEADER.size, len(sections) + 2, len(sections) + 1
+    )
+    return header + bytes(body)
+
+def test_sections_and_segments():
+    data = make_elf(
+        [(".ovl1", 1, 0x80010000, b"\x01\x02\x03\x04"), (".ovl2", elf.SHT_NOBITS, 0x80010000, b"")],
+        [(0x80010000, 4, 0x10)]
+    )
+    instance = elf.Elf(data)
+    ovl1 = instance.get_section(".ovl1")
+    assert ovl1.addr == 0x80010000
+    assert instance.section_data(ovl1) == b"\x01\x02\x03\x04"
+    assert instance.get_load_segment(ovl1).memsz == 0x10
+    assert instance.section_data(instance.get_section(".ovl2")) == b""
+    assert instance.get_section(".missing") is None
+
+def test_invalid_file():
+    with pytest.raises(ValueError):
+        elf.Elf(b"\x7fELF" + bytes([2, 1]) + bytes(100))
+
+def make_symtab(symbols):
+    """ Returns the .strtab and .symtab contents for (name, value, size, type, bind, section index) symbols. """
+    strtab = b"\0"
+    symtab = bytes(elf.SYMBOL.size)
+    for name, value, size, sym_type, bind, shndx in symbols:
+        symtab += elf.SYMBOL.pack(len(strtab), value, size, (bind << 4) | sym_type, 0, shndx)
+        strtab += name.encode() + b"\0"
+    return strtab, symtab
+
+def test_symbols():
+    strtab, symtab = make_symtab([
+        ("hello.c", 0, 0, elf.STT_FILE, 0, elf.SHN_ABS),
+        ("Hello_Main", 0x80010000, 0x20, elf.STT_FUNC, 1, 1),
+        ("game_func", 0x80020000, 0, elf.STT_NOTYPE, 1, elf.SHN_ABS),
+        ("printf", 0, 0, elf.STT_NOTYPE, 1, elf.SHN_UNDEF),
+    ])
+    instance = elf.Elf(make_elf([(".ovl1", 1, 0x80010000, bytes(0x20)), (".strtab", 3, 0, strtab), (".symtab", 2, 0, symtab)]))
+    symbols = instance.symbols()
+    assert [(s.name, s.value, s.size, s.type, s.section) for s in symbols] == [
+        ("hello.c", 0, 0, elf.STT_FILE, elf.ABS_SECTION),
+        ("Hello_Main", 0x80010000, 0x20, elf.STT_FUNC, ".ovl1"),
+        ("game_func", 0x80020000, 0, elf.STT_NOTYPE, elf.ABS_SECTION),
+        ("printf", 0, 0, elf.STT_NOTYPE, None),
+    ]
+    assert elf.Elf(make_elf([(".ovl1", 1, 0x80010000, b"")])).symbols() == []
@@ -0,0 +1,26 @@
+import jobs
+
+LOG = """0.5 0.1 /usr/libexec/gcc/mipsel-none-elf/13/cc1 -quiet -MMD src/main.dep -MT src/main.o src/main.c -quiet -dumpbase main.c -dumpbase-ext .c -o /tmp/cc1.s
+0.01 0 as -EL -o src/main.o /tmp/cc1.s
+1.5 0.25 cc1plus -quiet src/big.cpp -dumpbase big.cpp -o /tmp/cc2.s
+"""
+
+def test_parse_compile_times():
+    assert jobs.parse_compile_times(LOG) == {"src/main.c": 0.6, "src/big.cpp": 1.75}
+
+def test_update_compile_times(tmp_path):
+    path, log = tmp_path / "times.json", tmp_path / "times.log"
+    path.write_text('{"src/old.c": 3.0, "src/main.c": 9.0}')
+    log.write_text(LOG)
+    jobs.update_compile_times(path, log)
+    assert jobs.load_compile_times(path) == {"src/old.c": 3.0, "src/main.c": 0.6, "src/big.cpp": 1.75}
+    jobs.update_compile_times(path, tmp_path / "missing.log")
+    assert jobs.load_compile_times(tmp_path / "missing.json") == {}
+
+def test_order_by_compile_time():
+    times = {"a.c": 0.1, "b.c": 2.0, "c.c": 0.5}
+    assert jobs.order_by_compile_time(["a.c", "b.c", "new.c", "c.c"], times) == ["new.c", "b.c", "c.c", "a.c"]
+
+def test_get_job_count():
+    assert jobs.get_job_count(3) == 3
+    assert jobs.get_job_count(0) >= 1
@@ -0,0 +1,31 @@
+import layout
+
+def test_clean_name():
+    assert layout.clean_name("main+0x1c") == "main"
+    assert layout.clean_name("0x80012345") is None
+    assert layout.clean_name("update") == "update"
+
+def test_load_profile(tmp_path):
+    path = tmp_path / "profile.folded"
+    path.write_text(
+        "main;update;draw 30\n"
+        "main;update 10\n"
+        "main;0x80012345 5\n"
+        "sort 7\n"
+        "not a sample\n"
+    )
+    heat, edges = layout.load_profile(path)
+    assert heat == {"main": 0, "update": 10, "draw": 30, "sort": 7}
+    assert edges == {("main", "update"): 40, ("update", "draw"): 30}
+
+def test_order_functions_follows_heaviest_calls():
+    heat = {"main": 1, "update": 10, "draw": 30, "sort": 7, "idle": 50}
+    edges = {("main", "update"): 40, ("update", "draw"): 30, ("main", "sort"): 7}
+    # main -> update -> draw form a chain, sort can't be joined to main anymore
+    assert layout.order_functions(heat, edges) == ["idle", "main", "update", "draw", "sort"]
+
+def test_order_functions_only_joins_chain_ends():
+    heat = {"a": 1, "b": 1, "c": 1}
+    edges = {("a", "b"): 10, ("c", "b"): 5, ("b", "a"): 3}
+    # b is already after a, so c stays on its own and the a <-> b cycle is ignored
+    assert layout.order_functions(heat, edges) == ["a", "b", "c"]
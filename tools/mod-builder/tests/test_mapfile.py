@@ -0,0 +1,68 @@
+import mapfile
+
+MAP = """
+Discarded input sections
+
+ .text          0x00000000        0x0 src/hook.o
+ .text.a_very_long_function_name_for_wrapping
+                0x00000000        0x9 src/hello.o
+ .text.unused_function
+                0x00000000        0x8 src/hello.o
+
+Memory Configuration
+
+Name             Origin             Length             Attributes
+*default*        0x00000000         0xffffffff
+
+Linker script and memory map
+
+                0x80010000                        __ovr_start = 0x80010000
+
+.hook           0x80010000        0x8
+ KEEP(src/hook.o(.text*))
+ .text          0x80010000        0x8 src/hook.o
+
+.main           0x80010000      0x120 load address 0x80010008
+                0x80010100                        . = (. + 0x100)
+ *fill*         0x80010000      0x100 
+ src/hello.o(.text*)
+ .text.Hello_Main
+                0x80010100       0x15 src/hello.o
+                0x80010100                Hello_Main
+ *fill*         0x80010115        0x3 
+ .text.memcpy   0x80010118        0x4 /path/to/libc.a(string.o)
+ .bss.counter   0x8001011c        0x4 src/hello.o
+                0x8001011c                counter
+LOAD src/hook.o
+OUTPUT(mod.elf elf32-littlemips)
+
+.comment        0x00000000       0x27
+ .comment       0x00000000       0x27 src/hello.o
+                                 0x28 (size before relaxing)
+"""
+
+def test_parse():
+    parsed = mapfile.MapFile(MAP)
+    assert [(s.name, s.size, s.file) for s in parsed.discarded] == [
+        (".text", 0, "src/hook.o"),
+        (".text.a_very_long_function_name_for_wrapping", 9, "src/hello.o"),
+        (".text.unused_function", 8, "src/hello.o"),
+    ]
+    main = parsed.sections[".main"]
+    assert (main.address, main.size, main.fill) == (0x80010000, 0x120, 0x103)
+    assert [(s.symbol(), s.address, s.size, s.file) for s in main.inputs] == [
+        ("Hello_Main", 0x80010100, 0x15, "src/hello.o"),
+        ("memcpy", 0x80010118, 4, "/path/to/libc.a(string.o)"),
+        ("counter", 0x8001011c, 4, "src/hello.o"),
+    ]
+    assert parsed.sections[".hook"].inputs[0].name == ".text"
+    assert parsed.sections[".comment"].size == 0x27
+
+def test_size_report():
+    report = mapfile.size_report(mapfile.MapFile(MAP), [("hook", 0x80010000, 8, 16, 0), ("main", 0x80010100, 0x20, None, 0x100)])
+    assert "hook at 0x80010000: 8 bytes of 16 (50.0%)" in report
+    assert "main at 0x80010100: 32 bytes\n" in report
+    assert "          25  src/hello.o" in report
+    assert "           3  (alignment padding)" in report
+    assert "Removed by --gc-sections: 17 bytes" in report
+    assert "unused_function" in report
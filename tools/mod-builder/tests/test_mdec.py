@@ -0,0 +1,100 @@
+import math
+import struct
+import pytest
+
+import mdec
+
+def make_frame(width, height):
+    """ Gradient with some detail, so that the quantization scale matters """
+    pixels = []
+    for y in range(height):
+        for x in range(width):
+            pixels.append((int(127 + 100 * math.sin(x / 3)), (y * 255) // height, (x * y) % 256))
+    return pixels
+
+@pytest.fixture(scope="module")
+def blocks():
+    yield mdec.transform_frame(make_frame(48, 40), 48, 40)
+
+def test_zigzag_order():
+    assert mdec.ZIGZAG[:10] == [0, 1, 8, 16, 9, 2, 3, 10, 17, 24]
+    assert sorted(mdec.ZIGZAG) == list(range(64))
+
+cases_ac_codes = (
+    ((0, 1), "11"),
+    ((1, 1), "011"),
+    ((21, 1), "000000010110"),
+    ((1, 18), "0000000000010000"),
+)
+@pytest.mark.parametrize("run_level, code", cases_ac_codes)
+def test_build_ac_codes(run_level, code):
+    tree = mdec.load_lookup_table_script().HUFFMAN_TREE
+    assert mdec.build_ac_codes(tree)[run_level] == code
+
+cases_encode_ac = (
+    (0, 1, "110"),
+    (0, -1, "111"),
+    (40, 1, "000001" + "101000" + "0000000001"),
+    (0, -100, "000001" + "000000" + "1110011100"),
+)
+@pytest.mark.parametrize("run, level, code", cases_encode_ac)
+def test_encode_ac(run, level, code):
+    assert mdec.Encoder(2).encode_ac(run, level) == code
+
+cases_encode_dc = (
+    (0, True, "100"),
+    (0, False, "00"),
+    (1, True, "001"),
+    (-1, True, "000"),
+    (-3, False, "1000"),
+    (127, False, "1111110" + "1111111"),
+    (-255, True, "1111110" + "00000000"),
+)
+@pytest.mark.parametrize("delta, is_luma, code", cases_encode_dc)
+def test_encode_dc_v3(delta, is_luma, code):
+    assert mdec.Encoder(3).encode_dc_v3(delta, is_luma) == code
+
+@pytest.mark.parametrize("version", (2, 3))
+def test_encode_header(blocks, version):
+    data = mdec.Encoder(version).encode(blocks, 5)
+    num_words, header, quant_scale, _version = struct.unpack_from("<HHHH", data)
+    assert len(blocks) == 3 * 3 * 6
+    assert len(data) % 4 == 0
+    assert num_words % mdec.MDEC_DMA_CHUNK == 0
+    assert header == mdec.MDEC_HEADER
+    assert quant_scale == 5
+    assert _version == version
+
+@pytest.mark.parametrize("version", (2, 3))
+def test_encode_to_budget(blocks, version):
+    encoder = mdec.Encoder(version)
+    data, quant_scale = encoder.encode_to_budget(blocks, 1024)
+    assert len(data) <= 1024
+    assert quant_scale > mdec.MIN_QUANT_SCALE
+    assert len(encoder.encode(blocks, quant_scale - 1)) > 1024
+
+def test_build_str(blocks):
+    frames = [mdec.Encoder(2).encode(blocks, scale) for scale in (1, 20)]
+    stream = mdec.build_str(frames, 48, 40, 2)
+    assert len(stream) == 4 * mdec.CD_SECTOR_SIZE
+
+    for sector in range(4):
+        offset = sector * mdec.CD_SECTOR_SIZE
+        magic, _type, chunk, num_chunks, frame_id, length, width, height = \
+            struct.unpack_from("<HHHHIIHH", stream, offset)
+        frame = frames[sector // 2]
+        assert (magic, _type) == (mdec.STR_MAGIC, mdec.STR_TYPE_MDEC)
+        assert (chunk, num_chunks, frame_id) == (sector % 2, 2, (sector // 2) + 1)
+        assert (length, width, height) == (len(frame), 48, 40)
+        assert stream[offset + 20:offset + 28] == frame[:8]
+
+cases_fnames = (
+    ("INTRO_2_10", True),
+    ("LOGO_3_0", True),
+    ("LOGO_1_0", False),
+    ("LOGO_3", False),
+    ("SPYRO_368_216_1_251_44_26_4", False),
+)
+@pytest.mark.parametrize("string, expected", cases_fnames)
+def test_check_naming_convention(string, expected):
+    assert mdec.Bitstream.check_naming_convention(string) == expected
@@ -0,0 +1,91 @@
+import os
+import pathlib
+import shutil
+
+import pytest
+
+import pch
+
+GAMES_COMMON_MK = pathlib.Path(__file__).resolve().parents[3] / "games" / "common.mk"
+
+def set_times(path, atime, mtime):
+    os.utime(path, (atime, mtime))
+
+def test_cache_key():
+    key = pch.get_cache_key("gcc 13.2.0", ["common.h", "-O2"], 1)
+    assert key == pch.get_cache_key("gcc 13.2.0", ["common.h", "-O2"], 1)
+    assert key != pch.get_cache_key("gcc 13.2.0", ["common.h", "-Os"], 1)
+    assert key != pch.get_cache_key("gcc 13.2.0", ["common.h", "-O2"], 2)
+    assert key != pch.get_cache_key("gcc 14.1.0", ["common.h", "-O2"], 1)
+
+@pytest.mark.skipif(shutil.which("make") is None, reason="needs make")
+def test_build_flags(tmp_path):
+    (tmp_path / "define.mk").write_text("CPPFLAGS += -DFROM_DEFINE_MK\n")
+    (tmp_path / "Makefile").write_text(
+        "MODDIR := $(dir $(abspath $(lastword $(MAKEFILE_LIST))))\n"
+        "CPPFLAGS = -DBUILD=1\n"
+        "COMPILE_TIMES = times.log\n"
+        "-include define.mk\n"
+        f"include {GAMES_COMMON_MK}\n"
+    )
+    compiler, *flags = pch.get_build_flags(str(tmp_path))
+    assert compiler == pch.COMPILER
+    assert "-DBUILD=1" in flags and "-DFROM_DEFINE_MK" in flags
+    # The flags that only apply to one mod are left out, as the header is shared
+    assert f"-I{tmp_path}/" not in flags
+    assert not any(flag.startswith("-time=") for flag in flags)
+
+def test_cache_paths():
+    header = pathlib.Path("include/common.h")
+    assert pch.get_cache_path(header, "0123") == pathlib.Path("include/common.h.gch/0123.gch")
+    # Nothing but precompiled headers can be in the .gch directory, as gcc tries every file
+    assert pch.get_dep_path(header, "0123") == pathlib.Path("include/.pch/0123.dep")
+
+def test_prepare_cache_removes_old_pch(tmp_path):
+    legacy = tmp_path / "common.h.gch"
+    legacy.write_bytes(b"pch")
+    pch.prepare_cache(legacy / "0123.gch", tmp_path / ".pch" / "0123.dep")
+    assert not legacy.exists()
+
+def test_prepare_cache_keeps_modification_time(tmp_path):
+    header = tmp_path / "common.h"
+    path, dep = pch.get_cache_path(header, "0123"), pch.get_dep_path(header, "0123")
+    path.parent.mkdir()
+    dep.parent.mkdir()
+    path.write_bytes(b"pch")
+    dep.write_text("")
+    set_times(path, 1000, 1000)
+    pch.prepare_cache(path, dep)
+    assert path.stat().st_mtime == 1000
+    assert path.stat().st_atime > 1000
+
+def test_prepare_cache_removes_pch_without_dependencies(tmp_path):
+    header = tmp_path / "common.h"
+    path = pch.get_cache_path(header, "0123")
+    path.parent.mkdir()
+    path.write_bytes(b"pch")
+    pch.prepare_cache(path, pch.get_dep_path(header, "0123"))
+    assert not path.exists()
+
+def test_prune_cache(tmp_path):
+    header = tmp_path / "common.h"
+    directory, build_dir = pch.get_cache_dir(header), tmp_path / pch.BUILD_DIR
+    directory.mkdir()
+    build_dir.mkdir()
+    now = 1000000.0
+    ages = {
+        directory / "used.gch": 60,
+        directory / "unused.gch": pch.MAX_AGE + 1,
+        build_dir / "used.dep": 60,
+        build_dir / "unused.dep": 60, # its precompiled header is pruned
+        build_dir / "0123.dep.42.gch.tmp": pch.TEMP_MAX_AGE + 1,
+        build_dir / "4567.dep.43.gch.tmp": 1,
+    }
+    for path, age in ages.items():
+        path.write_bytes(b"")
+        set_times(path, now - age, now - age)
+    set_times(directory / "used.gch", now - 60, now - pch.MAX_AGE - 1) # only read lately
+    deleted = pch.prune_cache(header, now=now)
+    assert sorted(path.name for path in deleted) == ["0123.dep.42.gch.tmp", "unused.dep", "unused.gch"]
+    assert sorted(path.name for path in directory.iterdir()) == ["used.gch"]
+    assert sorted(path.name for path in build_dir.iterdir()) == ["4567.dep.43.gch.tmp", "used.dep"]
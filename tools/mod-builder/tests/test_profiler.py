@@ -0,0 +1,94 @@
+import struct
+import pytest
+
+import profiler
+
+TRACE_ADDR = 0x80010000
+ENTRIES_ADDR = 0x80010100
+
+def make_ram(events, length = 8, count = None):
+    """ Builds a fake RAM dump with the given (func, is_exit, time) events. """
+    if count is None:
+        count = len(events)
+    ram = bytearray(0x20000)
+    struct.pack_into("<5I", ram, TRACE_ADDR & 0x1FFFFFFF, profiler.TRACE_MAGIC, ENTRIES_ADDR, length - 1, count, 1)
+    base = ENTRIES_ADDR & 0x1FFFFFFF
+    for i, (func, is_exit, time) in zip(range(count - len(events), count), events):
+        struct.pack_into("<2I", ram, base + (i % length) * 8, func | int(is_exit), time)
+    return bytes(ram)
+
+def test_symbolizer(tmp_path):
+    path = tmp_path / "redux.map"
+    path.write_text("80010000 main\n80010040 update\ngarbage\n80020000 _prof_trace\n")
+    symbolizer = profiler.Symbolizer.from_map(path)
+    assert symbolizer.address_of("_prof_trace") == 0x80020000
+    assert symbolizer.address_of("missing") is None
+    assert symbolizer.name_of(0x80010040) == "update"
+    assert symbolizer.name_of(0x80010044) == "update+0x4"
+    assert symbolizer.name_of(0x8000FFFC) == "0x8000fffc"
+
+def test_read_trace_wraps_around():
+    events = [(0x80011000 + i * 4, False, i) for i in range(5)]
+    ram = make_ram(events, length = 4, count = 13)
+    # Only the 4 most recent entries are still in the buffer
+    assert profiler.read_trace(ram, TRACE_ADDR) == events[1:]
+
+def test_read_trace_bad_magic():
+    ram = bytearray(make_ram([]))
+    ram[TRACE_ADDR & 0x1FFFFFFF] ^= 0xFF
+    with pytest.raises(ValueError):
+        profiler.read_trace(bytes(ram), TRACE_ADDR)
+
+def test_fold_stacks():
+    events = [
+        (1, False, 0),
+        (2, False, 10),
+        (3, False, 20),
+        (3, True, 50),
+        (2, True, 60),
+        (2, False, 70),
+        (2, True, 75),
+        (1, True, 100),
+    ]
+    folded = profiler.fold_stacks(events, lambda addr: f"f{addr}")
+    assert folded == {"f1": 45, "f1;f2": 25, "f1;f2;f3": 30}
+
+def test_fold_stacks_truncated_trace():
+    events = [
+        (4, True, 5), # entry overwritten in the ring buffer
+        (1, False, 10),
+        (2, False, 20), # never returns (longjmp)
+        (1, True, 40),
+        (3, False, 50), # still running
+    ]
+    folded = profiler.fold_stacks(events, lambda addr: f"f{addr}")
+    assert folded == {"f1": 10, "f1;f2": 20}
+
+def test_fold_stacks_timer_wraparound():
+    events = [(1, False, 0xFFFFFFF0), (1, True, 0x10)]
+    assert profiler.fold_stacks(events, str) == {"1": 0x20}
+
+def test_render_svg():
+    folded = {"main": 1000, "main;draw": 3000, "main;update<T>": 100}
+    svg = profiler.render_svg(folded)
+    assert svg.startswith("<svg")
+    assert svg.count("<rect") == 5 # background, all, main, draw, update
+    assert "update&lt;T&gt;" in svg
+
+def test_create_profile(tmp_path):
+    map_path = tmp_path / "redux.map"
+    map_path.write_text(f"80011000 main\n80011100 draw\n{TRACE_ADDR:08x} _prof_trace\n")
+    ram = make_ram([
+        (0x80011000, False, 0),
+        (0x80011100, False, 4234),
+        (0x80011100, True, 8468),
+        (0x80011000, True, 12702),
+    ])
+    assert profiler.create_profile(ram, map_path, tmp_path)
+    assert (tmp_path / "profile.folded").read_text() == "main 2000\nmain;draw 1000\n"
+    assert (tmp_path / "profile.svg").exists()
+
+def test_create_profile_without_trace(tmp_path):
+    map_path = tmp_path / "redux.map"
+    map_path.write_text("80011000 main\n")
+    assert not profiler.create_profile(make_ram([]), map_path, tmp_path)
@@ -0,0 +1,56 @@
+import elf
+import mapfile
+import symbol_index
+from test_elf import make_elf, make_symtab
+from test_mapfile import MAP
+
+def make_index():
+    strtab, symtab = make_symtab([
+        ("hello.c", 0, 0, elf.STT_FILE, 0, elf.SHN_ABS),
+        ("hook", 0x80010000, 0, elf.STT_NOTYPE, 1, 1),
+        ("Hello_Main", 0x80010100, 0x15, elf.STT_FUNC, 1, 2),
+        ("Hello_Main.constprop.0", 0x80010118, 0x4, elf.STT_FUNC, 0, 2),
+        ("counter", 0x8001011c, 4, elf.STT_OBJECT, 1, 2),
+        ("__ovr_end", 0x80010120, 0, elf.STT_NOTYPE, 1, 2),
+        ("game_func", 0x80020000, 0, elf.STT_NOTYPE, 1, elf.SHN_ABS),
+        ("printf", 0, 0, elf.STT_NOTYPE, 1, elf.SHN_UNDEF),
+    ])
+    data = make_elf([(".hook", 1, 0x80010000, bytes(8)), (".main", 1, 0x80010000, bytes(0x120)), (".strtab", 3, 0, strtab), (".symtab", 2, 0, symtab)])
+    return symbol_index.SymbolIndex.from_elf(elf.Elf(data), mapfile.MapFile(MAP))
+
+def test_from_elf():
+    index = make_index()
+    assert [(s.name, s.kind, s.section, s.file) for s in index.symbols] == [
+        ("hook", "label", ".hook", "src/hook.o"),
+        ("Hello_Main", "func", ".main", "src/hello.o"),
+        ("Hello_Main.constprop.0", "func", ".main", "/path/to/libc.a(string.o)"),
+        ("counter", "object", ".main", "src/hello.o"),
+        ("game_func", "abs", elf.ABS_SECTION, ""),
+    ]
+    assert index.get("Hello_Main.constprop.0").local
+    assert index.get("printf") is None
+
+def test_at():
+    index = make_index()
+    assert index.at(0x80010104).name == "Hello_Main"
+    assert index.at(0x80010004, ".hook").name == "hook"
+    assert index.at(0x80010004, ".main") is None
+    assert index.at(0x80010116) is None # padding after Hello_Main
+    assert index.at(0x8000FFFF) is None
+
+def test_save_and_load(tmp_path):
+    index = make_index()
+    index.save(tmp_path / "symbols.json")
+    loaded = symbol_index.SymbolIndex.load(tmp_path / "symbols.json")
+    assert loaded.symbols == index.symbols
+    assert loaded.redux_map().splitlines()[:2] == ["80010000 hook", "80010100 Hello_Main"]
+
+def test_annotate_disassembly():
+    text = (
+        "Disassembly of section .main:\n"
+        "\n"
+        "80010100 <Hello_Main>:\n"
+        "80010100:\t03e00008 \tjr\tra\n"
+    )
+    out = symbol_index.annotate_disassembly(text, make_index())
+    assert "80010100 <Hello_Main>:  [src/hello.o, 21 bytes]\n" in out
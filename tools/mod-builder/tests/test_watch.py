@@ -0,0 +1,49 @@
+import os
+
+import watch
+
+def touch(path, data, mtime):
+    path.write_text(data)
+    os.utime(path, ns=(mtime, mtime))
+
+def test_file_watcher(tmp_path):
+    src = tmp_path / "src"
+    output = tmp_path / "newtex" / "output"
+    output.mkdir(parents=True)
+    src.mkdir()
+    touch(src / "main.c", "int main;", 1000)
+    touch(src / "main.o", "", 1000)
+    build_list = tmp_path / "buildList.txt"
+    touch(build_list, "", 1000)
+    watcher = watch.FileWatcher([src, build_list, tmp_path / "newtex", tmp_path / "missing"], ignore=[output])
+    assert watcher.poll() == set()
+
+    touch(src / "main.c", "int main;", 2000)
+    touch(src / "main.o", "changed", 2000) # written by the build
+    touch(src / ".main.c.swp", "", 2000)
+    touch(output / "vram.bin", "", 2000)
+    touch(tmp_path / "newtex" / "sky.png", "", 2000)
+    assert watcher.poll() == {str(src / "main.c"), str(tmp_path / "newtex" / "sky.png")}
+    assert watcher.poll() == set()
+
+    (src / "main.c").unlink()
+    touch(build_list, "changed", 1000)
+    assert watcher.poll() == {str(src / "main.c"), str(build_list)}
+
+    # Saved while make was running: the next poll still compares against the
+    # snapshot taken before the build, so the edit isn't lost
+    assert watcher.poll() == set()
+    touch(build_list, "saved during the build", 3000)
+    touch(src / "main.o", "", 3000) # written by the build
+    assert watcher.poll() == {str(build_list)}
+
+def test_load_compile_list_only_rebuilds_makefile_on_new_plan(monkeypatch):
+    plans = [["a"], ["a"], ["a", "b"]]
+    plans[1] = plans[0] # cached plan, returned as the same list
+    monkeypatch.setattr(watch, "get_compile_plan", lambda symbols: plans.pop(0))
+    mode = watch.WatchMode(redux=None)
+    loads = []
+    monkeypatch.setattr(mode, "load_makefile", lambda: loads.append(list(mode.compile_lists)))
+    for _ in range(3):
+        mode.load_compile_list()
+    assert loads == [["a"], ["a", "b"]]
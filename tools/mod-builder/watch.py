@@ -0,0 +1,187 @@
+"""
+Watch mode
+Keeps the symbols, the compile list and the compiler configuration of the mod
+in memory, and polls the mod sources, the textures and buildList.txt for
+changes. Sources are recompiled and the binaries that changed are pushed to
+redux, and textures are converted and pushed to VRAM, without going through
+the menu.
+"""
+from __future__ import annotations # to use type in python 3.7
+
+import _files # check_file, create_directory
+from makefile import Makefile
+from compile_list import get_compile_plan, print_errors
+from syms import Syms
+from redux import Redux
+from image import create_images, clear_images, dump_images
+from clut import clear_cluts, dump_cluts
+from common import COMPILE_LIST, CONFIG_PATH, GAME_INCLUDE_PATH, SRC_FOLDER, TEXTURES_FOLDER, TEXTURES_OUTPUT_FOLDER
+
+import logging
+import os
+import pathlib
+import time
+
+logger = logging.getLogger(__name__)
+
+POLL_INTERVAL = 0.25 # seconds
+SETTLE_TIME = 0.1 # editors often save a file in several writes
+# Files written by the build itself, and temporary files of editors
+IGNORED_SUFFIXES = {".o", ".dep", ".gch", ".swp", ".swx", ".tmp", ".bak"}
+
+class FileWatcher:
+    """
+    Polls the modification time and size of every file under the watched paths.
+    Polling is used instead of inotify so that the watch mode works the same on
+    Windows, and the mod folders are small enough to be scanned several times
+    per second.
+    """
+    def __init__(self, paths: list, ignore: list = ()) -> None:
+        self.paths = [pathlib.Path(path) for path in paths]
+        self.ignore = [pathlib.Path(path).resolve() for path in ignore]
+        self.snapshot = self.scan()
+
+    def is_ignored(self, path: pathlib.Path) -> bool:
+        name = path.name
+        if name.startswith(".") or name.endswith("~") or path.suffix.lower() in IGNORED_SUFFIXES:
+            return True
+        return any(folder == path or folder in path.parents for folder in self.ignore)
+
+    def scan(self) -> dict[str, tuple[int, int]]:
+        files = dict()
+        for path in self.paths:
+            if path.is_file():
+                candidates = [path]
+            elif path.is_dir():
+                candidates = (pathlib.Path(root) / name for root, _, names in os.walk(path) for name in names)
+            else:
+                continue
+            for file in candidates:
+                if self.is_ignored(file.resolve()):
+                    continue
+                try:
+                    stat = file.stat()
+                except OSError: # deleted while scanning
+                    continue
+                files[str(file)] = (stat.st_mtime_ns, stat.st_size)
+        return files
+
+    def poll(self) -> set[str]:
+        """ Returns the files created, modified or deleted since the last poll. """
+        current = self.scan()
+        changed = {name for name in current.keys() | self.snapshot.keys() if current.get(name) != self.snapshot.get(name)}
+        self.snapshot = current
+        return changed
+
+    def wait(self) -> set[str]:
+        """ Blocks until something changes, and returns every change once the files stop changing. """
+        changed = set()
+        while not changed:
+            time.sleep(POLL_INTERVAL)
+            changed = self.poll()
+        while True:
+            time.sleep(SETTLE_TIME)
+            more = self.poll()
+            if not more:
+                return changed
+            changed |= more
+
+class WatchMode:
+    def __init__(self, redux: Redux) -> None:
+        self.redux = redux
+        self.symbols = None
+        self.compile_lists = []
+        self.make = None
+        self.pushed = dict() # contents of the last binary pushed for each section
+
+    def load_symbols(self) -> None:
+        self.symbols = Syms()
+
+    def load_compile_list(self) -> None:
+        """
+        The plan is cached until the build list, the configuration or the
+        source directories it globs change, so this is cheap enough to run
+        before every build. The Makefile is only rebuilt with a new plan.
+        """
+        compile_lists = get_compile_plan(self.symbols)
+        if compile_lists is self.compile_lists:
+            return
+        self.compile_lists = compile_lists
+        if print_errors[0]:
+            logger.warning(f"{COMPILE_LIST} has errors, the lines above are skipped.")
+        self.load_makefile()
+
+    def load_makefile(self) -> None:
+        """ The compiler configuration is read once and kept until config.json changes. """
+        self.make = Makefile(self.symbols.get_build_id(), self.symbols.get_files())
+        for cl in self.compile_lists:
+            if not cl.should_ignore():
+                self.make.add_cl(cl)
+
+    def compile(self) -> bool:
+        # The objects of the previous compilation are kept, so make only
+        # rebuilds the sources that changed and the ones including them.
+        return self.make.build_makefile() and self.make.make()
+
+    def changed_binaries(self) -> list[tuple[pathlib.Path, int]]:
+        bins = []
+        for cl in self.compile_lists:
+            if not cl.should_build():
+                continue
+            bin = pathlib.Path(cl.get_output_name())
+            if not _files.check_file(bin, quiet=True):
+                continue
+            with open(bin, "rb") as file:
+                data = file.read()
+            if self.pushed.get(cl.section_name) != (cl.address, data):
+                bins.append((bin, cl.address))
+                self.pushed[cl.section_name] = (cl.address, data)
+        return bins
+
+    def push_code(self) -> None:
+        bins = self.changed_binaries()
+        if not bins:
+            print("[Watch-py] No binary changed.")
+            return
+        self.redux.push_code(bins)
+
+    def push_textures(self) -> None:
+        _files.create_directory(TEXTURES_OUTPUT_FOLDER)
+        if create_images(TEXTURES_FOLDER) == 0:
+            return
+        dump_images(TEXTURES_OUTPUT_FOLDER)
+        dump_cluts(TEXTURES_OUTPUT_FOLDER)
+        self.redux.push_textures()
+        clear_images()
+        clear_cluts()
+
+    def run(self) -> None:
+        if not _files.check_file(COMPILE_LIST):
+            return
+        self.load_symbols()
+        self.load_compile_list()
+        if self.compile():
+            # The first push goes through the regular hot reload, which offers
+            # to backup the RAM so that the mod can be uninstalled afterwards.
+            self.redux.hot_reload()
+            self.changed_binaries() # what was just injected
+        mod_sources = [SRC_FOLDER, COMPILE_LIST, CONFIG_PATH, GAME_INCLUDE_PATH]
+        watcher = FileWatcher(mod_sources + [TEXTURES_FOLDER], ignore=[TEXTURES_OUTPUT_FOLDER])
+        print(f"\n[Watch-py] Watching {', '.join(str(path) for path in mod_sources + [TEXTURES_FOLDER])}. Press Ctrl+C to stop.\n")
+        try:
+            while True:
+                # The snapshot taken by wait() is kept through the build, so
+                # the files saved while make runs are picked up by the next
+                # wait(). The files written by the build itself are ignored.
+                changed = watcher.wait()
+                start_time = time.time()
+                # Also picks up the sources added or deleted since the last build
+                self.load_compile_list()
+                textures = {name for name in changed if TEXTURES_FOLDER in pathlib.Path(name).parents}
+                if changed - textures and self.compile():
+                    self.push_code()
+                if textures:
+                    self.push_textures()
+                print(f"\n[Watch-py] Done in {round(time.time() - start_time, 3)}s. Watching for changes...\n")
+        except KeyboardInterrupt:
+            print("\n[Watch-py] Stopped watching.\n")
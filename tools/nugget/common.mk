@@ -30,20 +30,29 @@ LDFLAGS += $(OPT_LD_FLAGS)
 
 CXXFLAGS += -fno-exceptions -fno-rtti
 
+# Appends the CPU time taken by each compiler pass to a file, which is used to
+# start the slowest objects first in the next build.
+ifneq ($(strip $(COMPILE_TIMES)),)
+CPPFLAGS += -time=$(COMPILE_TIMES)
+endif
+
 OBJS += $(addsuffix .o, $(basename $(SRCS)))
 
+# Dependencies are written as a side effect of compiling each object, rather
+# than through a separate preprocessing pass.
+DEPFLAGS = -MMD -MP -MF $(@:.o=.dep) -MT $@
+
 DEPS := $(patsubst %.cpp, %.dep,$(filter %.cpp,$(SRCS)))
 DEPS += $(patsubst %.cc, %.dep,$(filter %.cc,$(SRCS)))
 DEPS +=	$(patsubst %.c, %.dep,$(filter %.c,$(SRCS)))
-DEPS += $(patsubst %.s, %.dep,$(filter %.s,$(SRCS)))
 
-all: pch dep $(foreach ovl, $(OVERLAYSECTION), $(BINDIR)Overlay$(ovl))
+# The overlays are split out of the elf by the mod-builder once make is done.
+all: pch $(BINDIR)$(TARGET).elf
 
-$(BINDIR)Overlay%: $(BINDIR)$(TARGET).elf
-	$(PREFIX)-objcopy -j $(@:$(BINDIR)Overlay%=%) -O binary $< $(BINDIR)$(TARGET)$(@:$(BINDIR)Overlay%=%)
-	$(PYTHON) $(TOOLSDIR)trimbin/trimbin.py $(BINDIR)$(TARGET)$(@:$(BINDIR)Overlay%=%) $(BUILDDIR) $(TRIMBIN_OFFSET)
-
-$(BINDIR)$(TARGET).elf: $(OBJS)
+# With -j, make starts the prerequisites in the order they are listed, so
+# COMPILE_ORDER lists the objects from the slowest to the fastest to compile.
+# The link still uses the order of OBJS.
+$(BINDIR)$(TARGET).elf: $(COMPILE_ORDER) $(OBJS)
 ifneq ($(strip $(BINDIR)),)
 	mkdir -p $(BINDIR)
 endif
@@ -52,25 +61,49 @@ endif
 %.o: %.s
 	$(CC) $(ARCHFLAGS) -I$(ROOTDIR) -c $< -o $@
 
-%.dep: %.c
-	$(CC) $(CPPFLAGS) $(CFLAGS) -M -MT $(addsuffix .o, $(basename $@)) -MF $@ $<
-
-%.dep: %.cpp
-	$(CXX) $(CPPFLAGS) $(CXXFLAGS) -M -MT $(addsuffix .o, $(basename $@)) -MF $@ $<
+%.o: %.c
+	$(CC) $(CPPFLAGS) $(CFLAGS) $(DEPFLAGS) -c $< -o $@
+
+%.o: %.cpp
+	$(CXX) $(CPPFLAGS) $(CXXFLAGS) $(DEPFLAGS) -c $< -o $@
+
+%.o: %.cc
+	$(CXX) $(CPPFLAGS) $(CXXFLAGS) $(DEPFLAGS) -c $< -o $@
+
+# The precompiled header is shared by the mods of the game, so it's built
+# without the flags that only apply to one mod (PCH_EXCLUDED_FLAGS). The header
+# thus can't include anything from the mod's own directory. Every other flag,
+# including the ones added by define.mk, is part of its configuration.
+PCH_EXCLUDED_FLAGS += -time=%
+PCH_FLAGS = $(filter-out $(PCH_EXCLUDED_FLAGS),$(CPPFLAGS)) $(CFLAGS)
+
+# PCHS is the precompiled header of the current configuration, inside the
+# <header>.gch directory shared by the mods of the game. gcc tries every file in
+# that directory, so the header and its dependencies are written to temporary
+# files in the directory of PCH_DEP first, and then moved in place. A mod built
+# at the same time never reads a partial file.
+$(PCHS): $(PCH_HEADER)
+	mkdir -p $(dir $@) $(dir $(PCH_DEP))
+	tmp=$(PCH_DEP).$$$$; \
+	if $(CC) $(PCH_FLAGS) -MMD -MP -MF $$tmp.dep.tmp -MT $@ -c $< -o $$tmp.gch.tmp; then \
+		mv -f $$tmp.gch.tmp $@ && mv -f $$tmp.dep.tmp $(PCH_DEP); \
+	else \
+		rm -f $$tmp.gch.tmp $$tmp.dep.tmp; exit 1; \
+	fi
 
-%.dep: %.cc
-	$(CXX) $(CPPFLAGS) $(CXXFLAGS) -M -MT $(addsuffix .o, $(basename $@)) -MF $@ $<
-
-%.dep: %.s
-	$(GCCDIR)touch $@
-
-dep: $(DEPS)
+pch: $(PCHS)
 
-%.h.gch: %.h
-	$(CC) $(CPPFLAGS) $(CFLAGS) -c $< -o $@
+# Prints the compiler and the flags the precompiled header is built with, which
+# the mod-builder hashes into the name of PCHS.
+pch-flags:
+	$(info PCH_FLAGS = $(CC) $(PCH_FLAGS))
+	@:
 
-pch: $(PCHS)
+# The objects must not be compiled before the header they would use is ready.
+# gcc doesn't list the headers read from a precompiled header in the
+# dependencies of the objects, so they're rebuilt whenever it changes.
+$(OBJS): $(PCHS)
 
--include $(DEPS)
+-include $(DEPS) $(PCH_DEP)
 
-.PHONY: all pch dep
\ No newline at end of file
+.PHONY: all pch pch-flags
\ No newline at end of file